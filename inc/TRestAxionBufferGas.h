@@ -53,7 +53,10 @@ class TRestAxionBufferGas : public TRestMetadata {
     void ReadGasData(TString gasName);
 
     Int_t FindGasIndex(TString gName);
-    Int_t GetEnergyIndex(std::vector<Double_t> enVector, Double_t energy);
+    Int_t GetEnergyIndex(const std::vector<Double_t>& enVector, Double_t energy) const;
+
+    Double_t GetGasFormFactor(Int_t gasIndex, Double_t energy) const;
+    Double_t GetGasAbsorptionCoefficient(Int_t gasIndex, Double_t energy) const;
 
    public:
     void SetGasDensity(TString gasName, Double_t density);
@@ -62,18 +65,18 @@ class TRestAxionBufferGas : public TRestMetadata {
     void SetGasMixture(TString gasMixture, TString gasDensities);
 
     /// It returns the number of gases in the mixture
-    Int_t GetNumberOfGases() { return (Int_t)fBufferGasName.size(); }
+    Int_t GetNumberOfGases() const { return (Int_t)fBufferGasName.size(); }
 
     Double_t GetAbsorptionCoefficient(TString gasName, Double_t energy);
     Double_t GetFormFactor(TString gasName, Double_t energy);
 
-    Double_t GetPhotonAbsorptionLength(Double_t energy);
+    Double_t GetPhotonAbsorptionLength(Double_t energy) const;
 
-    Double_t GetPhotonAbsorptionLengthIneV(Double_t energy);
+    Double_t GetPhotonAbsorptionLengthIneV(Double_t energy) const;
 
-    Double_t cmToeV(double l_Inv);
+    Double_t cmToeV(double l_Inv) const;
 
-    Double_t GetPhotonMass(double en);
+    Double_t GetPhotonMass(double en) const;
 
     void PrintAbsorptionGasData(TString gasName);
     void PrintFormFactorGasData(TString gasName);
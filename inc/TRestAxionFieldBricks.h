@@ -0,0 +1,109 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldBricks
+#define _TRestAxionFieldBricks
+
+#include <vector>
+
+#include "Rtypes.h"
+
+class TRestAxionFieldGrid;
+
+/// The field values at the nodes of a grid, stored in bricks of nodes with an adaptive resolution
+class TRestAxionFieldBricks {
+   private:
+    /// The resolution of one brick, and the position of its values
+    struct Brick {
+        /// The distance, in grid nodes, between two consecutive stored nodes along each axis
+        Int_t stride = 1;
+
+        /// The number of grid cells covered along each axis
+        Int_t cells[3] = {0, 0, 0};
+
+        /// The number of stored nodes along each axis
+        Int_t nodes[3] = {1, 1, 1};
+
+        /// The position of the components of the first stored node at fValues
+        size_t offset = 0;
+    };
+
+    /// The number of grid nodes along each axis
+    Int_t fNodes[3] = {0, 0, 0};  //!
+
+    /// The number of grid cells along each axis of a brick
+    Int_t fBrickCells = 0;  //!
+
+    /// The number of bricks along each axis
+    Int_t fBrickCount[3] = {0, 0, 0};  //!
+
+    /// The bricks, with z being the fastest running index
+    std::vector<Brick> fBricks;  //!
+
+    /// The field components (Bx,By,Bz) of the stored nodes of all the bricks, in T
+    std::vector<Double_t> fValues;  //!
+
+    /// The maximum difference, in T, accepted between the stored field and the original nodes
+    Double_t fTolerance = 0;  //!
+
+    /// The maximum difference, in T, found between the stored field and the original nodes
+    Double_t fMaxError = 0;  //!
+
+    const Brick& GetBrick(const Int_t* node, Int_t* local) const;
+
+    void GetInterval(const Brick& brick, Int_t n, Int_t local, Int_t& first, Double_t& fraction) const;
+
+    void Reconstruct(const Brick& brick, const Int_t* local, Double_t* field) const;
+
+   public:
+    /// The default number of cells along each axis of a brick. It must be a power of 2
+    static const Int_t kDefaultBrickCells = 16;
+
+    Bool_t Build(const TRestAxionFieldGrid& grid, Double_t tolerance, Int_t brickCells = kDefaultBrickCells);
+
+    void GetNode(const Int_t* node, Double_t* field) const;
+
+    void GetCell(const Int_t* node, Double_t* values) const;
+
+    size_t GetCellId(const Int_t* node) const;
+
+    /// It returns the maximum difference, in T, accepted between the stored field and the original nodes
+    Double_t GetTolerance() const { return fTolerance; }
+
+    /// It returns the maximum difference, in T, found between the stored field and the original nodes
+    Double_t GetMaxError() const { return fMaxError; }
+
+    /// It returns the number of grid cells along each axis of a brick
+    Int_t GetBrickCells() const { return fBrickCells; }
+
+    /// It returns the total number of bricks
+    size_t GetNumberOfBricks() const { return fBricks.size(); }
+
+    /// It returns the number of nodes whose field is stored
+    size_t GetNumberOfStoredNodes() const { return fValues.size() / 3; }
+
+    /// It returns the memory used by the stored nodes and the bricks in bytes
+    size_t GetMemorySize() const {
+        return fValues.size() * sizeof(Double_t) + fBricks.size() * sizeof(Brick);
+    }
+};
+#endif
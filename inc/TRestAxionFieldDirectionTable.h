@@ -0,0 +1,94 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldDirectionTable
+#define _TRestAxionFieldDirectionTable
+
+#include <vector>
+
+#include "TRestAxionFieldGrid.h"
+#include "TVector3.h"
+
+/// A table of the field integrals along parallel rays with a fixed direction, covering the magnetic volumes
+class TRestAxionFieldDirectionTable {
+   private:
+    /// The direction of the rays
+    TVector3 fDirection = TVector3(0, 0, 0);  //!
+
+    /// The two unit vectors defining the plane normal to the rays
+    TVector3 fAxes[2];  //!
+
+    /// The position of the first node of the first ray
+    TVector3 fOrigin = TVector3(0, 0, 0);  //!
+
+    /// The distance between rays, and between nodes along a ray, in mm
+    Double_t fSpacing = 0;  //!
+
+    /// The number of rays along each axis of the plane, and the number of nodes along each ray
+    Int_t fNodes[3] = {0, 0, 0};  //!
+
+    /// The integrals from the first node of each ray, with kValues values for each node
+    std::vector<Double_t> fValues;  //!
+
+    void GetRayIntegrals(Int_t ia, Int_t ib, Double_t s, Double_t* values) const;
+
+   public:
+    /// The number of values stored at each node (the field vector, the transverse vector, the transverse
+    /// intensity and the squared transverse intensity)
+    static const Int_t kValues = 8;
+
+    Bool_t Define(const TVector3& direction, const TVector3& boxMin, const TVector3& boxMax, Double_t spacing,
+                  size_t maxBytes = 0);
+
+    void Clear();
+
+    /// It returns true if no table has been defined
+    Bool_t IsEmpty() const { return fValues.empty(); }
+
+    /// It returns true if the table was built for the unit vector `direction`
+    Bool_t IsDefinedFor(const TVector3& direction) const {
+        return !fValues.empty() && (direction - fDirection).Mag2() < 1.e-18;
+    }
+
+    /// It returns the number of rays along the axis `n` (0 or 1) of the plane, or the number of nodes along
+    /// each ray (n=2)
+    Int_t GetNodes(Int_t n) const { return fNodes[n]; }
+
+    /// It returns the distance between rays, and between nodes along a ray, in mm
+    Double_t GetSpacing() const { return fSpacing; }
+
+    /// It returns the direction of the rays
+    TVector3 GetDirection() const { return fDirection; }
+
+    /// It returns the position of the first node of the ray (ia, ib)
+    TVector3 GetRayStart(Int_t ia, Int_t ib) const {
+        return fOrigin + ia * fSpacing * fAxes[0] + ib * fSpacing * fAxes[1];
+    }
+
+    void SetRay(Int_t ia, Int_t ib, const std::vector<FieldLineIntegral>& pieces);
+
+    FieldLineIntegral GetIntegral(const TVector3& from, const TVector3& to) const;
+
+    /// It returns the memory used by the table in bytes
+    size_t GetMemorySize() const { return fValues.size() * sizeof(Double_t); }
+};
+#endif
@@ -0,0 +1,139 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldEvaluator
+#define _TRestAxionFieldEvaluator
+
+#include <memory>
+#include <vector>
+
+#include "TMatrixD.h"
+#include "TVector3.h"
+
+#include "TRestAxionBufferGas.h"
+#include "TRestAxionFieldGrid.h"
+#include "TRestAxionFieldModel.h"
+#include "TRestAxionVolumeIndex.h"
+
+/// The state kept between consecutive field queries at nearby positions, e.g. when sampling a ray. It
+/// remembers the volume and the grid cell of the last position, together with the field at its nodes
+struct FieldCursor {
+    /// The volume of the last position, or -1 if it was outside any volume
+    Int_t volume = -1;
+
+    /// The nodes of the last grid cell
+    FieldCellCache cell;
+
+    /// It forgets the last position. It must be called before using the cursor with different volumes
+    void Clear() {
+        volume = -1;
+        cell.Clear();
+    }
+};
+
+/// An immutable snapshot of the magnetic volumes of TRestAxionMagneticField, that can be shared by threads
+class TRestAxionFieldEvaluator {
+   public:
+    /// The description of a single magnetic volume
+    struct Volume {
+        /// The position of the center of the volume
+        TVector3 position;
+
+        /// The half size of the volume along each axis. The radius of a cylinder is given by the x component
+        TVector3 boundMax;
+
+        /// The size of a grid element from the mesh in mm
+        TVector3 meshSize;
+
+        /// A constant field component that is added to the field map
+        TVector3 constantField;
+
+        /// True if the volume is a cylinder along z, false if it is a box
+        Bool_t cylindrical = false;
+
+        /// The field map, in the absolute reference system. It is empty if the field is constant
+        TRestAxionFieldGrid field;
+
+        /// The analytic field, in the absolute reference system, used instead of a field map
+        TRestAxionFieldModel model;
+
+        /// The gas properties of the volume
+        std::shared_ptr<const TRestAxionBufferGas> gas;
+    };
+
+   private:
+    /// The magnetic volumes
+    std::vector<Volume> fVolumes;
+
+    /// A spatial index over the bounding boxes of the magnetic volumes
+    TRestAxionVolumeIndex fVolumeIndex;
+
+    Bool_t IsInsideVolume(const Volume& vol, const TVector3& pos) const;
+    Bool_t GetLineCrossing(const Volume& vol, const TVector3& pos, const TVector3& dir, Double_t& tIn,
+                           Double_t& tOut) const;
+
+    Bool_t FindTransversalFieldEdge(const TVector3& pos, const TVector3& dir, Double_t from, Double_t to,
+                                    Double_t step, Double_t precision, Double_t& edge) const;
+
+   public:
+    /// It returns the number of magnetic volumes
+    Int_t GetNumberOfVolumes() const { return fVolumes.size(); }
+
+    /// It returns the description of the magnetic volume `id`
+    const Volume& GetVolume(Int_t id) const { return fVolumes[id]; }
+
+    Int_t GetVolumeIndex(const TVector3& pos) const;
+    std::vector<Int_t> GetVolumesAlongRay(const TVector3& pos, const TVector3& dir) const;
+
+    /// It returns true if the given position is found inside a magnetic volume
+    Bool_t IsInside(const TVector3& pos) const { return GetVolumeIndex(pos) >= 0; }
+
+    std::vector<TVector3> GetVolumeBoundaries(Int_t id, const TVector3& pos, const TVector3& dir) const;
+    std::vector<TVector3> GetFieldBoundaries(Int_t id, const TVector3& pos, const TVector3& dir,
+                                             Double_t precision = 0) const;
+    std::vector<TVector3> FindFieldBoundaries(Int_t id, const TVector3& entry, const TVector3& exit,
+                                              Double_t precision = 0) const;
+
+    TVector3 GetMagneticField(const TVector3& pos) const;
+    TVector3 GetMagneticField(Int_t id, const TVector3& pos) const;
+    TVector3 GetMagneticField(const TVector3& pos, FieldCursor& cursor) const;
+    Int_t GetMagneticField(Int_t n, const Double_t* x, const Double_t* y, const Double_t* z, Double_t* bx,
+                           Double_t* by, Double_t* bz) const;
+
+    TVector3 GetMagneticFieldAndGradient(const TVector3& pos, TMatrixD& gradient) const;
+    TVector3 GetMagneticFieldAndGradient(const TVector3& pos, TMatrixD& gradient, FieldCursor& cursor) const;
+
+    Double_t GetTransversalComponent(const TVector3& pos, const TVector3& dir) const;
+    Double_t GetTransversalComponent(const TVector3& pos, const TVector3& dir, FieldCursor& cursor) const;
+
+    Double_t GetPhotonMass(const TVector3& pos, Double_t en) const;
+    Double_t GetPhotonMass(Int_t id, Double_t en) const;
+
+    Double_t GetPhotonAbsorptionLength(const TVector3& pos, Double_t en) const;
+    Double_t GetPhotonAbsorptionLength(Int_t id, Double_t en) const;
+
+    FieldLineIntegral GetFieldIntegral(const TVector3& from, const TVector3& to) const;
+    std::vector<FieldLineIntegral> GetFieldIntegrals(const std::vector<TVector3>& path) const;
+
+    TRestAxionFieldEvaluator(const std::vector<Volume>& volumes);
+};
+#endif
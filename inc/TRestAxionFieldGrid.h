@@ -0,0 +1,530 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldGrid
+#define _TRestAxionFieldGrid
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TVector3.h"
+
+class TRestAxionFieldBricks;
+class TRestAxionFieldTileCache;
+struct FieldOccupancy;
+
+/// The integrals of the magnetic field along a straight segment
+struct FieldLineIntegral {
+    /// The length of the segment in mm
+    Double_t length = 0;
+
+    /// The integral of the field vector in T mm
+    TVector3 field = TVector3(0, 0, 0);
+
+    /// The integral of the field component transverse to the segment in T mm
+    TVector3 transverse = TVector3(0, 0, 0);
+
+    /// The integral of the transverse field intensity in T mm
+    Double_t transverseMag = 0;
+
+    /// The integral of the squared transverse field intensity in T2 mm
+    Double_t transverseMag2 = 0;
+
+    /// The minimum transverse field intensity found at the evaluated points in T
+    Double_t transverseMin = 0;
+
+    /// The maximum transverse field intensity found at the evaluated points in T
+    Double_t transverseMax = 0;
+
+    /// The number of points where the field was evaluated
+    Int_t samples = 0;
+
+    /// It adds the contribution of a constant `b` field along a `length`, for the unit `direction`
+    void Add(const TVector3& b, const TVector3& direction, Double_t length) {
+        TVector3 bt = b - (b * direction) * direction;
+        Double_t bt2 = bt.Mag2();
+        Double_t btMag = sqrt(bt2);
+
+        this->length += length;
+        field += length * b;
+        transverse += length * bt;
+        transverseMag += length * btMag;
+        transverseMag2 += length * bt2;
+
+        if (samples == 0 || btMag < transverseMin) transverseMin = btMag;
+        if (samples == 0 || btMag > transverseMax) transverseMax = btMag;
+        samples++;
+    }
+
+    /// It adds the integrals of a consecutive piece of the segment
+    void Add(const FieldLineIntegral& piece) {
+        if (piece.samples == 0) return;
+
+        length += piece.length;
+        field += piece.field;
+        transverse += piece.transverse;
+        transverseMag += piece.transverseMag;
+        transverseMag2 += piece.transverseMag2;
+
+        if (samples == 0 || piece.transverseMin < transverseMin) transverseMin = piece.transverseMin;
+        if (samples == 0 || piece.transverseMax > transverseMax) transverseMax = piece.transverseMax;
+        samples += piece.samples;
+    }
+
+    /// It returns the average of the transverse field intensity in T
+    Double_t GetTransversalFieldAverage() const { return length > 0 ? transverseMag / length : 0; }
+
+    /// It returns the transverse component of the average field vector in T
+    TVector3 GetFieldAverageTransverseVector() const {
+        return length > 0 ? (1. / length) * transverse : TVector3(0, 0, 0);
+    }
+};
+
+/// The field values at the corners of the last grid cell used by TRestAxionFieldGrid::Interpolate, that are
+/// reused while the following positions are found inside the same cell
+struct FieldCellCache {
+    /// The data block, or tile cache, the values were read from. It is null if the cache is empty
+    const void* source = nullptr;
+
+    /// The bottom, down, left node of the cell
+    Int_t node[3] = {0, 0, 0};
+
+    /// The stored components at the 8 corners of the cell, converted to double precision. The components of
+    /// the corner (i, j, k) start at 3 * (i + 2 * j + 4 * k)
+    Double_t values[24];
+
+    /// It empties the cache
+    void Clear() { source = nullptr; }
+};
+
+/// The multipole expansion of the field at the slices of a bore parallel to z, built from the nodes of a
+/// grid by TRestAxionFieldGrid::BuildMultipoles
+struct FieldMultipoles {
+    /// The number of terms of each expansion
+    Int_t order = 0;
+
+    /// The radius of the bore in mm. The expansion is only used inside it
+    Double_t radius = 0;
+
+    /// The position of the bore axis (x, y), and of the first slice (z), relative to the first node in mm
+    Double_t origin[3] = {0, 0, 0};
+
+    /// The distance between two consecutive slices in mm
+    Double_t spacing = 0;
+
+    /// The number of slices along z
+    Int_t slices = 0;
+
+    /// The maximum difference, in T, between the expansion and the field map at the nodes of the valid slices
+    Double_t residual = 0;
+
+    /// The coefficients (b_n, a_n, e_n, f_n) of each term, for each slice, with 4 * order values per slice
+    std::vector<Double_t> coefficients;
+
+    /// It is true for the slices where the expansion reproduces the field map within the tolerance
+    std::vector<bool> valid;
+};
+
+/// A class storing the field vectors of a regular grid in a single contiguous and aligned memory block
+class TRestAxionFieldGrid {
+   private:
+    /// The number of nodes along each axis (x, y, z)
+    Int_t fNodes[3] = {0, 0, 0};  //!
+
+    /// The distance, in number of stored elements, between two consecutive nodes along each axis. For the
+    /// blocked layout, it is the distance between two consecutive nodes of the same block
+    size_t fStride[3] = {0, 0, 0};  //!
+
+    /// The order of the nodes inside the data block. See TRestAxionFieldGrid::SetLayout
+    UInt_t fLayout = 0;  //!
+
+    /// The distance, in stored elements, between two consecutive blocks along each axis, for the blocked
+    /// layout
+    size_t fBlockStride[3] = {0, 0, 0};  //!
+
+    /// The absolute position of the first node, (xMin, yMin, zMin), in mm
+    Double_t fOrigin[3] = {0, 0, 0};  //!
+
+    /// The distance between two consecutive nodes along each axis in mm
+    Double_t fSpacing[3] = {0, 0, 0};  //!
+
+    /// The field components (Bx,By,Bz) of each node, stored consecutively following the strides. The type
+    /// of the stored values is given by fPrecision
+    std::shared_ptr<void> fData;  //!
+
+    /// The numerical type used to store the field components. See TRestAxionFieldGrid::SetPrecision
+    UInt_t fPrecision = 0;  //!
+
+    /// The field value, in T, of one unit of the stored values. It is 1 for floating point values
+    Double_t fScale = 1;  //!
+
+    /// The maximum absolute error, in T, introduced by the storage precision
+    Double_t fQuantizationError = 0;  //!
+
+    /// The number of nodes along each axis stored in one tile of a tiled grid
+    Int_t fTileNodes[3] = {0, 0, 0};  //!
+
+    /// The number of tiles along each axis of a tiled grid
+    Int_t fTileCount[3] = {0, 0, 0};  //!
+
+    /// The distance, in stored elements, between two consecutive nodes of a tile along each axis
+    size_t fTileStride[3] = {0, 0, 0};  //!
+
+    /// The tiles of a tiled grid, read on demand from the grid file. It is null if the grid is not tiled
+    std::shared_ptr<TRestAxionFieldTileCache> fTileCache;  //!
+
+    /// The field at the nodes of an adaptive grid, stored with a resolution adapted to the field. It is
+    /// null if the grid is not adaptive. See TRestAxionFieldGrid::SetAdaptive
+    std::shared_ptr<const TRestAxionFieldBricks> fBricks;  //!
+
+    /// The mirror symmetries of the field. See TRestAxionFieldGrid::SetSymmetry
+    UInt_t fSymmetry = 0;  //!
+
+    /// If true, the grid axes are (r, phi, z) and the stored components are (Br, Bphi, Bz)
+    Bool_t fCylindrical = false;  //!
+
+    /// The (x, y) position of the cylinder axis, that is parallel to z, in mm
+    Double_t fAxis[2] = {0, 0};  //!
+
+    /// One bit for each grid cell, set if the field is not zero at any node of the cell, computed on first
+    /// use. It is null if the occupancy was not enabled. See TRestAxionFieldGrid::BuildOccupancy
+    std::shared_ptr<FieldOccupancy> fOccupancy;  //!
+
+    /// The integrals along z of (Bx, By, Bz, |Bt|, |Bt|^2) from the first node of each column to each node,
+    /// with kAxialValues values for each node. It is null if they were not built. See
+    /// TRestAxionFieldGrid::BuildAxialSums
+    std::shared_ptr<const std::vector<Double_t>> fAxialSums;  //!
+
+    /// The maximum displacement in x and y, relative to the node spacing, of a segment integrated using the
+    /// axial sums. See TRestAxionFieldGrid::IsAxial
+    Double_t fAxialTolerance = kAxialTolerance;  //!
+
+    /// The field and its derivatives used by the tricubic interpolation, with kTricubicValues values for
+    /// each node. It is null if they were not built. See TRestAxionFieldGrid::BuildTricubic
+    std::shared_ptr<const std::vector<Double_t>> fTricubic;  //!
+
+    /// The multipole expansion of the field inside the bore. It is null if it was not built. See
+    /// TRestAxionFieldGrid::BuildMultipoles
+    std::shared_ptr<const FieldMultipoles> fMultipoles;  //!
+
+    friend class TRestAxionFieldMapRegistry;
+
+    void SetStrides(UInt_t layout);
+
+    size_t GetNumberOfElements() const;
+
+    void Reflect(Double_t* pos, Double_t* sign) const;
+
+    void InterpolateAt(const Double_t* pos, Double_t* field, FieldCellCache* cache,
+                       Double_t* gradient = nullptr) const;
+    void InterpolateNodes(const Double_t* pos, Double_t* field, FieldCellCache* cache,
+                          Double_t* gradient = nullptr) const;
+    Bool_t InterpolateMultipoles(const Double_t* pos, Double_t* field, Double_t* gradient) const;
+    void ReadCell(const Int_t* node, FieldCellCache& cache) const;
+    void ScaleGradient(const Double_t* pos, const Double_t* sign, Double_t* gradient) const;
+
+    std::shared_ptr<const void> GetTile(const Int_t* node, size_t& index) const;
+
+    std::vector<Double_t> GetCrossings(const TVector3& from, const TVector3& to) const;
+    std::vector<Double_t> GetCoarseCrossings(const TVector3& from, const TVector3& to,
+                                             const std::vector<Double_t>& crossings) const;
+
+    void GetAxialValues(Int_t nx, Int_t ny, Int_t nz, Double_t* values) const;
+    void GetColumnIntegral(Int_t nx, Int_t ny, Double_t z, Double_t* values) const;
+    void IntegrateAxial(const TVector3& from, const TVector3& to, FieldLineIntegral& integral) const;
+
+    Bool_t GetNeighbourField(const Int_t* node, Double_t* field) const;
+
+    const std::vector<bool>& GetOccupancy() const;
+
+   public:
+    /// The number of field components stored at each node
+    static const Int_t kComponents = 3;
+
+    /// The byte alignment of the data block, large enough for any vector register
+    static const size_t kAlignment = 64;
+
+    /// The version of the native grid file format written by this class
+    static const UInt_t kFileVersion = 2;
+
+    /// The default number of cells along each axis stored in one tile of a tiled grid file
+    static const Int_t kDefaultTileCells = 32;
+
+    /// The default limit, in bytes, of the tiles kept in memory when reading a tiled grid file
+    static const size_t kDefaultCacheSize = (size_t)256 << 20;
+
+    /// The number of values stored at each node by TRestAxionFieldGrid::BuildAxialSums
+    static const Int_t kAxialValues = 5;
+
+    /// The number of values stored at each node by TRestAxionFieldGrid::BuildTricubic, the field and its 7
+    /// derivatives for each field component
+    static const Int_t kTricubicValues = 8 * kComponents;
+
+    /// The number of coefficients of each term of the multipole expansion. See
+    /// TRestAxionFieldGrid::BuildMultipoles
+    static const Int_t kMultipoleValues = 4;
+
+    /// The default maximum displacement in x and y, relative to the node spacing, of a segment integrated
+    /// using the axial sums
+    static constexpr Double_t kAxialTolerance = 0.01;
+
+    /// Layout. The nodes are stored in a single array with z being the fastest running index
+    static const UInt_t kLinearLayout = 0;
+    /// Layout. The nodes are grouped in blocks of kBlockNodes nodes along each axis
+    static const UInt_t kBlockedLayout = 1;
+
+    /// The number of nodes along each axis of a block, for the blocked layout. It must be a power of 2
+    static const Int_t kBlockNodes = 4;
+
+    /// Symmetry flag. The field is symmetric with respect to the plane normal to x at the first node
+    static const UInt_t kMirrorX = 1 << 0;
+    /// Symmetry flag. The field is symmetric with respect to the plane normal to y at the first node
+    static const UInt_t kMirrorY = 1 << 1;
+    /// Symmetry flag. The field is symmetric with respect to the plane normal to z at the first node
+    static const UInt_t kMirrorZ = 1 << 2;
+    /// Symmetry flag. The tangential components, instead of Bx, change sign when reflecting in x
+    static const UInt_t kTangentialX = 1 << 3;
+    /// Symmetry flag. The tangential components, instead of By, change sign when reflecting in y
+    static const UInt_t kTangentialY = 1 << 4;
+    /// Symmetry flag. The tangential components, instead of Bz, change sign when reflecting in z
+    static const UInt_t kTangentialZ = 1 << 5;
+
+    /// Storage precision. The field components are stored as Double_t values
+    static const UInt_t kDoublePrecision = 0;
+    /// Storage precision. The field components are stored as Float_t values
+    static const UInt_t kFloatPrecision = 1;
+    /// Storage precision. The field components are stored as 16-bit integers, multiplied by a common scale
+    static const UInt_t kInt16Precision = 2;
+
+    void Allocate(Int_t nx, Int_t ny, Int_t nz, const TVector3& origin, const TVector3& spacing);
+
+    Bool_t SetSymmetry(UInt_t symmetry);
+
+    Bool_t SetPrecision(UInt_t precision);
+
+    /// It returns the numerical type used to store the field components (kDoublePrecision, ...)
+    UInt_t GetPrecision() const { return fPrecision; }
+
+    /// It returns the field value, in T, of one unit of the stored values
+    Double_t GetScale() const { return fScale; }
+
+    /// It returns the maximum absolute error, in T, introduced by the storage precision
+    Double_t GetQuantizationError() const { return fQuantizationError; }
+
+    /// It returns the size in bytes of one field component stored with the given `precision`
+    static size_t GetElementSize(UInt_t precision) {
+        if (precision == kInt16Precision) return sizeof(Short_t);
+        if (precision == kFloatPrecision) return sizeof(Float_t);
+        return sizeof(Double_t);
+    }
+
+    Bool_t SetLayout(UInt_t layout);
+
+    /// It returns the order of the nodes inside the data block (kLinearLayout, kBlockedLayout)
+    UInt_t GetLayout() const { return fLayout; }
+
+    void SetCylindrical(Double_t xAxis, Double_t yAxis);
+
+    /// It returns true if the grid axes are (r, phi, z)
+    Bool_t IsCylindrical() const { return fCylindrical; }
+
+    /// It returns the x (n=0) or y (n=1) coordinate of the cylinder axis
+    Double_t GetAxis(Int_t n) const { return fAxis[n]; }
+
+    /// It returns the symmetry flags of the grid
+    UInt_t GetSymmetry() const { return fSymmetry; }
+
+    /// It returns true if the field is mirrored with respect to the plane normal to the axis `n`
+    Bool_t IsMirrored(Int_t n) const { return fSymmetry & (kMirrorX << n); }
+
+    /// It returns the lowest coordinate covered by the grid along the axis `n`, including reflections
+    Double_t GetLowerBound(Int_t n) const {
+        return IsMirrored(n) ? 2 * fOrigin[n] - GetUpperBound(n) : fOrigin[n];
+    }
+
+    /// It returns the highest coordinate covered by the grid along the axis `n`
+    Double_t GetUpperBound(Int_t n) const { return fOrigin[n] + (fNodes[n] - 1) * fSpacing[n]; }
+
+    Bool_t MapFile(const std::string& filename, const TVector3& offset = TVector3(0, 0, 0),
+                   size_t cacheSize = kDefaultCacheSize);
+    Bool_t WriteFile(const std::string& filename, const TVector3& offset = TVector3(0, 0, 0),
+                     Int_t tileCells = 0) const;
+
+    /// It releases the field data and all the structures built from it, keeping the geometry of the grid
+    void Reset() {
+        fData.reset();
+        fTileCache.reset();
+        fBricks.reset();
+        fOccupancy.reset();
+        fAxialSums.reset();
+        fTricubic.reset();
+        fMultipoles.reset();
+    }
+
+    /// It moves the grid by `offset`. The field data is not modified
+    void Translate(const TVector3& offset) {
+        if (fCylindrical) {
+            fAxis[0] += offset.X();
+            fAxis[1] += offset.Y();
+            fOrigin[2] += offset.Z();
+        } else {
+            for (int n = 0; n < 3; n++) fOrigin[n] += offset[n];
+        }
+    }
+
+    /// It returns true if no field data has been allocated
+    Bool_t IsEmpty() const { return fData == nullptr && fTileCache == nullptr && fBricks == nullptr; }
+
+    /// It returns true if the field data is read on demand from a tiled grid file
+    Bool_t IsTiled() const { return fTileCache != nullptr; }
+
+    /// It returns the tile cache of a tiled grid
+    TRestAxionFieldTileCache* GetTileCache() const { return fTileCache.get(); }
+
+    Bool_t SetAdaptive(Double_t tolerance);
+
+    /// It returns true if the field is stored with an adaptive resolution
+    Bool_t IsAdaptive() const { return fBricks != nullptr; }
+
+    /// It returns the bricks storing the field of an adaptive grid
+    const TRestAxionFieldBricks* GetBricks() const { return fBricks.get(); }
+
+    /// It returns the number of nodes along the axis `n` (0=x, 1=y, 2=z)
+    Int_t GetNodes(Int_t n) const { return fNodes[n]; }
+
+    /// It returns the total number of nodes in the grid
+    size_t GetNumberOfNodes() const { return (size_t)fNodes[0] * fNodes[1] * fNodes[2]; }
+
+    /// It returns the stride, in stored elements, along the axis `n` (0=x, 1=y, 2=z). For the blocked layout,
+    /// it is the stride inside a block
+    size_t GetStride(Int_t n) const { return fStride[n]; }
+
+    /// It returns the absolute coordinate of the first node along the axis `n` (0=x, 1=y, 2=z)
+    Double_t GetOrigin(Int_t n) const { return fOrigin[n]; }
+
+    /// It returns the distance between nodes along the axis `n` (0=x, 1=y, 2=z)
+    Double_t GetSpacing(Int_t n) const { return fSpacing[n]; }
+
+    size_t GetMemorySize() const;
+
+    /// It returns a pointer to the beginning of the data block. The type of the values is given by
+    /// GetPrecision. It is null for tiled and adaptive grids
+    const void* GetData() const { return fData.get(); }
+
+    /// It returns the contribution of the node `i` along the axis `n` to the position of a node inside the
+    /// data block. The position of a node is the sum of the contributions along the three axes
+    size_t GetAxisOffset(Int_t n, Int_t i) const {
+        if (fLayout == kLinearLayout) return i * fStride[n];
+        return ((UInt_t)i / kBlockNodes) * fBlockStride[n] + ((UInt_t)i % kBlockNodes) * fStride[n];
+    }
+
+    /// It returns the position of the node (nx,ny,nz) inside the data block
+    size_t GetIndex(Int_t nx, Int_t ny, Int_t nz) const {
+        if (fLayout == kLinearLayout) return nx * fStride[0] + ny * fStride[1] + nz * fStride[2];
+        return GetAxisOffset(0, nx) + GetAxisOffset(1, ny) + GetAxisOffset(2, nz);
+    }
+
+    /// It returns a pointer to the field components (Bx,By,Bz) at the node (nx,ny,nz). Only valid for
+    /// double precision grids that are not tiled or adaptive
+    const Double_t* GetNode(Int_t nx, Int_t ny, Int_t nz) const {
+        return (const Double_t*)fData.get() + GetIndex(nx, ny, nz);
+    }
+
+    TVector3 GetNodeField(Int_t nx, Int_t ny, Int_t nz) const;
+
+    /// It assigns the field components (bx,by,bz) to the node (nx,ny,nz). Only valid for double precision
+    /// grids that are not tiled or adaptive
+    void SetNode(Int_t nx, Int_t ny, Int_t nz, Double_t bx, Double_t by, Double_t bz) {
+        Double_t* b = (Double_t*)fData.get() + GetIndex(nx, ny, nz);
+        b[0] = bx;
+        b[1] = by;
+        b[2] = bz;
+    }
+
+    void GetCell(const Double_t* pos, Int_t* node, Double_t* frac) const;
+
+    void Interpolate(const Double_t* pos, Double_t* field) const;
+    TVector3 Interpolate(const TVector3& pos) const;
+
+    void Interpolate(const Double_t* pos, Double_t* field, FieldCellCache& cache) const;
+    TVector3 Interpolate(const TVector3& pos, FieldCellCache& cache) const;
+
+    void InterpolateGradient(const Double_t* pos, Double_t* field, Double_t* gradient) const;
+    void InterpolateGradient(const Double_t* pos, Double_t* field, Double_t* gradient,
+                             FieldCellCache& cache) const;
+
+    void Interpolate(Int_t n, const Double_t* x, const Double_t* y, const Double_t* z, Double_t* bx,
+                     Double_t* by, Double_t* bz) const;
+
+    void Integrate(const TVector3& from, const TVector3& to, const TVector3& offset,
+                   FieldLineIntegral& integral) const;
+
+    void BuildOccupancy();
+
+    /// It returns true if the occupancy of the grid cells has been enabled
+    Bool_t HasOccupancy() const { return fOccupancy != nullptr; }
+
+    std::vector<std::pair<Double_t, Double_t>> GetOccupiedIntervals(const TVector3& from,
+                                                                    const TVector3& to) const;
+
+    void BuildAxialSums();
+
+    /// It returns true if the integrals along z have been built
+    Bool_t HasAxialSums() const { return fAxialSums != nullptr; }
+
+    Bool_t IsAxial(const TVector3& from, const TVector3& to) const;
+
+    /// It sets the maximum displacement in x and y, relative to the node spacing, of a segment integrated
+    /// using the axial sums
+    void SetAxialTolerance(Double_t tolerance) { fAxialTolerance = tolerance; }
+
+    /// It returns the maximum displacement in x and y, relative to the node spacing, of a segment
+    /// integrated using the axial sums
+    Double_t GetAxialTolerance() const { return fAxialTolerance; }
+
+    Bool_t BuildTricubic();
+
+    /// It returns true if the field is interpolated using the tricubic polynomials
+    Bool_t HasTricubic() const { return fTricubic != nullptr; }
+
+    /// It returns the memory used by the derivatives of the tricubic interpolation in bytes
+    size_t GetTricubicSize() const { return fTricubic ? fTricubic->size() * sizeof(Double_t) : 0; }
+
+    Bool_t BuildMultipoles(Int_t order, Double_t radius, Double_t tolerance);
+
+    /// It returns true if the field inside the bore is given by the multipole expansion
+    Bool_t HasMultipoles() const { return fMultipoles != nullptr; }
+
+    /// It returns the multipole expansion of the field inside the bore. It is null if it was not built
+    const FieldMultipoles* GetMultipoles() const { return fMultipoles.get(); }
+
+    /// It returns the memory used by the multipole coefficients in bytes
+    size_t GetMultipoleSize() const {
+        return fMultipoles ? fMultipoles->coefficients.size() * sizeof(Double_t) : 0;
+    }
+
+    static const char* GetVectorInstructionSet();
+};
+#endif
@@ -0,0 +1,40 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldMapRegistry
+#define _TRestAxionFieldMapRegistry
+
+#include <string>
+
+#include "TRestAxionFieldGrid.h"
+
+/// A process-wide registry sharing the field maps loaded from the same file among all the magnetic volumes
+class TRestAxionFieldMapRegistry {
+   public:
+    static std::string GetKey(const std::string& filename);
+
+    static Bool_t Find(const std::string& key, TRestAxionFieldGrid& grid);
+    static void Add(const std::string& key, const TRestAxionFieldGrid& grid);
+
+    static Int_t GetNumberOfMaps();
+};
+#endif
@@ -0,0 +1,104 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldModel
+#define _TRestAxionFieldModel
+
+#include <vector>
+
+#include "TRestAxionFieldGrid.h"
+#include "TVector3.h"
+
+/// A magnetic field given in closed form by a few parameters, e.g. an ideal dipole or a solenoid
+class TRestAxionFieldModel {
+   private:
+    /// The kind of magnet described by the model, e.g. TRestAxionFieldModel::kDipole
+    UInt_t fType = 0;  //!
+
+    /// The absolute position of the center of the magnet, in mm
+    Double_t fCenter[3] = {0, 0, 0};  //!
+
+    /// The magnetic length along z, in mm. If zero, the magnet is infinitely long
+    Double_t fLength = 0;  //!
+
+    /// The length of the fringe fields at the ends of a dipole or multipole, in mm
+    Double_t fFringe = 0;  //!
+
+    /// The radius of the solenoid, or the reference radius of the multipole coefficients, in mm
+    Double_t fRadius = 0;  //!
+
+    /// The field of an infinitely long solenoid, in T
+    Double_t fSolenoidField = 0;  //!
+
+    /// The normal multipole coefficients, b_n, at the reference radius, in T. The first one is the dipole
+    std::vector<Double_t> fNormal;  //!
+
+    /// The skew multipole coefficients, a_n, at the reference radius, in T
+    std::vector<Double_t> fSkew;  //!
+
+    void GetProfile(Double_t z, Double_t* profile) const;
+
+    void EvaluateMultipole(const Double_t* pos, Double_t* field, Double_t* gradient) const;
+    void EvaluateSolenoid(const Double_t* pos, Double_t* field, Double_t* gradient) const;
+
+   public:
+    /// Model type. No model is defined
+    static const UInt_t kNone = 0;
+    /// Model type. A uniform transverse field, with fringe fields at both ends
+    static const UInt_t kDipole = 1;
+    /// Model type. A finite solenoid along z
+    static const UInt_t kSolenoid = 2;
+    /// Model type. A transverse multipole expansion, with fringe fields at both ends
+    static const UInt_t kMultipole = 3;
+
+    /// It returns true if no model is defined
+    Bool_t IsEmpty() const { return fType == kNone; }
+
+    /// It returns the kind of magnet described by the model, e.g. TRestAxionFieldModel::kDipole
+    UInt_t GetType() const { return fType; }
+
+    /// It returns the magnetic length along z, in mm
+    Double_t GetLength() const { return fLength; }
+
+    /// It returns the length of the fringe fields, in mm
+    Double_t GetFringe() const { return fFringe; }
+
+    /// It returns the radius of the solenoid, or the reference radius of the multipole, in mm
+    Double_t GetRadius() const { return fRadius; }
+
+    void SetDipole(const TVector3& field, Double_t length, Double_t fringe);
+    void SetSolenoid(Double_t field, Double_t length, Double_t radius);
+    void SetMultipole(const std::vector<Double_t>& normal, const std::vector<Double_t>& skew, Double_t radius,
+                      Double_t length, Double_t fringe);
+
+    void Clear();
+
+    void Translate(const TVector3& offset);
+
+    TVector3 Evaluate(const TVector3& pos) const;
+    void Evaluate(const Double_t* pos, Double_t* field, Double_t* gradient = nullptr) const;
+
+    Double_t GetIntegrationStep() const;
+    void Integrate(const TVector3& from, const TVector3& to, const TVector3& offset,
+                   FieldLineIntegral& integral) const;
+};
+#endif
@@ -0,0 +1,57 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldTable
+#define _TRestAxionFieldTable
+
+#include <string>
+#include <vector>
+
+#include "Rtypes.h"
+
+/// A field map table, with the columns x,y,z,Bx,By,Bz, storing all the rows in a single block
+class TRestAxionFieldTable {
+   private:
+    /// The values of the rows, one row after the other
+    std::vector<Float_t> fValues;  //!
+
+   public:
+    /// The number of columns of a field map table
+    static const Int_t kColumns = 6;
+
+    Bool_t ReadASCII(const std::string& filename, Int_t threads = 1);
+
+    void SetRows(const std::vector<std::vector<Float_t>>& data);
+
+    /// It releases the memory used by the rows
+    void Clear() { std::vector<Float_t>().swap(fValues); }
+
+    /// It returns the number of rows
+    size_t GetNumberOfRows() const { return fValues.size() / kColumns; }
+
+    /// It returns the kColumns values of the row `n`
+    const Float_t* operator[](size_t n) const { return fValues.data() + n * kColumns; }
+
+    /// It returns the memory used by the rows in bytes
+    size_t GetMemorySize() const { return fValues.size() * sizeof(Float_t); }
+};
+#endif
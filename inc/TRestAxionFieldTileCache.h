@@ -0,0 +1,134 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionFieldTileCache
+#define _TRestAxionFieldTileCache
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "Rtypes.h"
+
+/// A bounded cache keeping in memory the most recently used tiles of a tiled field map file
+class TRestAxionFieldTileCache {
+   private:
+    /// A tile kept in memory, and its position in the list of recently used tiles
+    struct Tile {
+        /// The tile data
+        std::shared_ptr<const void> data;
+
+        /// The position of the tile at fRecent
+        std::list<size_t>::iterator position;
+    };
+
+    /// The file descriptor of the tiled file
+    int fFile = -1;  //!
+
+    /// The position of the first tile inside the file, in bytes
+    size_t fDataOffset = 0;  //!
+
+    /// The size of one tile in bytes
+    size_t fTileBytes = 0;  //!
+
+    /// The number of tiles stored in the file
+    size_t fNumberOfTiles = 0;  //!
+
+    /// The maximum number of tiles kept in memory
+    size_t fMaxTiles = 1;  //!
+
+    /// A part of the cache, keeping the tiles whose mixed id modulo the number of shards is the shard index
+    struct Shard {
+        /// The tile ids ordered from the most to the least recently used
+        std::list<size_t> recent;
+
+        /// The tiles kept in memory
+        std::unordered_map<size_t, Tile> tiles;
+
+        /// The maximum number of tiles kept in this shard
+        size_t maxTiles = 1;
+
+        /// It protects the shard when the same grid is used by several threads. It is never held while a
+        /// tile is read from the file
+        std::mutex mutex;
+    };
+
+    /// The maximum number of shards
+    static const size_t kShards = 16;
+
+    /// The minimum number of tiles kept by each shard
+    static const size_t kMinShardTiles = 8;
+
+    /// The shards of the cache. Only the first fNumberOfShards are used
+    Shard fShards[kShards];  //!
+
+    /// The number of shards used, so that each shard keeps at least kMinShardTiles tiles when possible
+    size_t fNumberOfShards = 1;  //!
+
+    /// A tile filled with zeros, returned when a tile cannot be read
+    std::shared_ptr<const void> fEmptyTile;  //!
+
+    /// The number of tiles read from the file
+    std::atomic<size_t> fLoads{0};  //!
+
+    /// The number of requests served from memory
+    std::atomic<size_t> fHits{0};  //!
+
+    /// The number of requests of tiles that could not be read
+    std::atomic<size_t> fErrors{0};  //!
+
+    size_t GetShard(size_t id) const;
+
+    std::shared_ptr<void> AllocateTile() const;
+
+   public:
+    Bool_t Open(const std::string& filename, size_t dataOffset, size_t tileBytes, size_t numberOfTiles,
+                size_t maxBytes);
+
+    std::shared_ptr<const void> GetTile(size_t id);
+
+    /// It returns the size of one tile in bytes
+    size_t GetTileSize() const { return fTileBytes; }
+
+    /// It returns the maximum number of tiles kept in memory
+    size_t GetMaxTiles() const { return fMaxTiles; }
+
+    size_t GetResidentSize();
+
+    /// It returns the number of tiles read from the file since it was opened
+    size_t GetNumberOfLoads() const { return fLoads; }
+
+    /// It returns the number of tile requests that were served from memory
+    size_t GetNumberOfHits() const { return fHits; }
+
+    /// It returns the number of tile requests that failed, and got a tile filled with zeros
+    size_t GetNumberOfErrors() const { return fErrors; }
+
+    TRestAxionFieldTileCache() = default;
+    TRestAxionFieldTileCache(const TRestAxionFieldTileCache&) = delete;
+    TRestAxionFieldTileCache& operator=(const TRestAxionFieldTileCache&) = delete;
+    ~TRestAxionFieldTileCache();
+};
+#endif
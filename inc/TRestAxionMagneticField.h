@@ -28,10 +28,18 @@
 
 #include "TCanvas.h"
 #include "TH2D.h"
+#include "TMatrixD.h"
 #include "TVector3.h"
 #include "TVectorD.h"
 
 #include "TRestAxionBufferGas.h"
+#include "TRestAxionFieldBricks.h"
+#include "TRestAxionFieldDirectionTable.h"
+#include "TRestAxionFieldEvaluator.h"
+#include "TRestAxionFieldGrid.h"
+#include "TRestAxionFieldMapRegistry.h"
+#include "TRestAxionFieldModel.h"
+#include "TRestAxionFieldTable.h"
 #include "TRestMesh.h"
 
 /// A structure to define the properties and store the field data of a single magnetic volume inside
@@ -44,10 +52,28 @@ struct MagneticFieldVolume {
     TRestMesh mesh;
 
     /// The field data connected to the grid defined by the mesh
-    std::vector<std::vector<std::vector<TVector3>>> field;
+    TRestAxionFieldGrid field;
 
-    /// A pointer to the gas properties
-    TRestAxionBufferGas* bGas = NULL;
+    /// The analytic field used instead of a field map. It is empty if no model was defined
+    TRestAxionFieldModel model;
+
+    /// A pointer to the gas properties, that is shared with TRestAxionFieldEvaluator
+    std::shared_ptr<TRestAxionBufferGas> bGas;
+};
+
+/// The time, in ms, spent at each stage of loading the field map of a magnetic volume
+struct FieldLoadTimes {
+    /// Reading the field map file
+    Double_t read = 0;
+
+    /// Finding the boundaries and the node spacing of a table
+    Double_t scan = 0;
+
+    /// Assigning the rows of a table to the grid nodes
+    Double_t fill = 0;
+
+    /// Building the storage and the derived data of the grid (precision, layout, interpolation, ...)
+    Double_t build = 0;
 };
 
 /// A class to load magnetic field maps and evaluate the field on those maps including interpolation.
@@ -74,12 +100,94 @@ class TRestAxionMagneticField : public TRestMetadata {
     /// The gas components densities corresponding to the gas mixture defined for each volume
     std::vector<TString> fGasDensities;  //<
 
+    /// The mirror symmetries of the field map of each volume (e.g. "xz")
+    std::vector<TString> fSymmetries;  //<
+
+    /// The coordinates of the grid used to store the field map of each volume (cartesian or cylindrical)
+    std::vector<TString> fGridTypes;  //<
+
+    /// The numerical type used to store the field map of each volume (double, float or int16)
+    std::vector<TString> fPrecisions;  //<
+
+    /// The order of the nodes of the field map of each volume in memory (linear or blocked)
+    std::vector<TString> fLayouts;  //<
+
+    /// The maximum error, in T, of the adaptive resolution storage of each volume. If zero, it is not used
+    std::vector<Double_t> fAdaptiveTolerances;  //<
+
+    /// The interpolation of the field map of each volume between the nodes (trilinear or tricubic)
+    std::vector<TString> fInterpolations;  //<
+
+    /// The number of terms of the multipole expansion of the bore of each volume. If zero, it is not used
+    std::vector<Int_t> fMultipoleOrders;  //<
+
+    /// The radius, in mm, of the bore described by the multipole expansion of each volume
+    std::vector<Double_t> fMultipoleRadii;  //<
+
+    /// The maximum difference, in T, between the multipole expansion and the field map of each volume
+    std::vector<Double_t> fMultipoleTolerances;  //<
+
+    /// The maximum memory, in MB, used by the tiles of each volume read from a tiled grid file
+    std::vector<Double_t> fCacheSizes;  //<
+
+    /// The analytic field model of each volume (none, dipole, solenoid or multipole)
+    std::vector<TString> fModels;  //<
+
+    /// The field of the model of each volume in T. Transverse for a dipole, and along z for a solenoid
+    std::vector<TVector3> fModelFields;  //<
+
+    /// The magnetic length along z of the model of each volume in mm. Zero for an infinitely long magnet
+    std::vector<Double_t> fModelLengths;  //<
+
+    /// The length of the fringe fields of the model of each volume in mm
+    std::vector<Double_t> fModelFringes;  //<
+
+    /// The solenoid radius, or the multipole reference radius, of the model of each volume in mm
+    std::vector<Double_t> fModelRadii;  //<
+
+    /// The normal multipole coefficients, in T, of the model of each volume (e.g. "1.5,0.01")
+    std::vector<TString> fModelNormal;  //<
+
+    /// The skew multipole coefficients, in T, of the model of each volume (e.g. "0,0.002")
+    std::vector<TString> fModelSkew;  //<
+
     /// A vector to store the maximum bounding box values
     std::vector<TVector3> fBoundMax;  //<
 
+    /// The distance, in mm, between the rays of the field integral table. If zero, no table is used
+    Double_t fDirectionTableSpacing = 0;  //<
+
+    /// The direction of the rays of the field integral table. If zero, no table is used
+    TVector3 fDirectionTableAxis = TVector3(0, 0, 0);  //<
+
+    /// The maximum size, in MB, of the field integral table
+    Double_t fDirectionTableMaxSize = 512;  //<
+
+    /// If true, the integrals along z of the field maps are built when loading the volumes
+    Bool_t fUseAxialSums = false;  //<
+
+    /// The maximum displacement in x and y, relative to the node spacing, of a segment integrated using the
+    /// axial sums
+    Double_t fAxialTolerance = 0.01;  //<
+
+    /// The number of threads used to load the volumes. If zero, the number of hardware threads
+    Int_t fLoadThreads = 0;  //<
+
+    /// The time spent at each stage of loading the field map of each volume
+    std::vector<FieldLoadTimes> fLoadTimes;  //!
+
     /// A magnetic field volume structure to store field data and mesh.
     std::vector<MagneticFieldVolume> fMagneticFieldVolumes;  //!
 
+    /// The field integrals along parallel rays with the direction fDirectionTableAxis
+    TRestAxionFieldDirectionTable fDirectionTable;  //!
+
+    /// It is true if the field integral table was not built because it exceeds fDirectionTableMaxSize
+    Bool_t fDirectionTableTooLarge = false;  //!
+
+    /// The read-only snapshot of the loaded volumes, created on demand by GetEvaluator
+    std::shared_ptr<const TRestAxionFieldEvaluator> fEvaluator;  //!
+
     /// A helper histogram to plot the field
     TH2D* fHisto;  //!
 
@@ -90,9 +198,42 @@ class TRestAxionMagneticField : public TRestMetadata {
 
     void InitFromConfigFile();
 
-    void LoadMagneticFieldData(MagneticFieldVolume& mVol, std::vector<std::vector<Float_t>> data);
+    struct FieldMapLoad;
+
+    void LoadFieldMap(Int_t n, FieldMapLoad& load, Int_t threads);
+
+    void LoadMagneticFieldData(MagneticFieldVolume& mVol, const TRestAxionFieldTable& data,
+                               Int_t threads = 1);
+    Bool_t LoadCylindricalFieldData(MagneticFieldVolume& mVol, const TRestAxionFieldTable& data,
+                                    const FieldMapLoad& load, Int_t threads = 1);
+
+    TRestMesh GetVolumeMesh(Int_t n, TVector3 boundMax, TVector3 meshSize);
+
+    TVector3 GetMagneticVolumeNode(const MagneticFieldVolume& mVol, TVector3 pos);
+
+    UInt_t GetSymmetryFlags(TString symmetry);
+
+    void SetFieldPrecision(Int_t n, TRestAxionFieldGrid& grid);
+
+    void SetFieldLayout(Int_t n, TRestAxionFieldGrid& grid);
 
-    TVector3 GetMagneticVolumeNode(MagneticFieldVolume mVol, TVector3 pos);
+    void SetFieldAdaptive(Int_t n, TRestAxionFieldGrid& grid);
+
+    void SetFieldInterpolation(Int_t n, TRestAxionFieldGrid& grid);
+
+    void SetFieldMultipoles(Int_t n, TRestAxionFieldGrid& grid);
+
+    void SetFieldModel(Int_t n, TRestAxionFieldModel& model);
+
+    /// It returns the evaluator of the loaded volumes, that implements the field queries of this class
+    const TRestAxionFieldEvaluator& GetFieldEvaluator() {
+        if (!fEvaluator || !FieldLoaded()) GetEvaluator();
+        return *fEvaluator;
+    }
+
+    Bool_t BuildDirectionTable();
+
+    Bool_t IsAxialPath(TVector3 from, TVector3 to);
 
     /// \brief This private method returns true if the magnetic field volumes loaded are the same as
     /// the volumes defined.
@@ -112,9 +253,10 @@ class TRestAxionMagneticField : public TRestMetadata {
    public:
     void LoadMagneticVolumes();
 
-    /// It returns true if no magnetic field map was loaded for that volume
+    /// It returns true if no magnetic field map, neither a field model, was loaded for that volume
     Bool_t IsFieldConstant(Int_t id) {
-        if (GetMagneticVolume(id)) return GetMagneticVolume(id)->field.size() == 0;
+        if (GetMagneticVolume(id))
+            return GetMagneticVolume(id)->field.IsEmpty() && GetMagneticVolume(id)->model.IsEmpty();
         return true;
     }
 
@@ -128,6 +270,13 @@ class TRestAxionMagneticField : public TRestMetadata {
 
     TVector3 GetMagneticField(Double_t x, Double_t y, Double_t z);
     TVector3 GetMagneticField(TVector3 pos, Bool_t showWarning = true);
+    TVector3 GetMagneticField(TVector3 pos, FieldCursor& cursor, Bool_t showWarning = true);
+    void GetMagneticField(Int_t n, const Double_t* x, const Double_t* y, const Double_t* z, Double_t* bx,
+                          Double_t* by, Double_t* bz, Bool_t showWarning = true);
+
+    TVector3 GetMagneticFieldAndGradient(TVector3 pos, TMatrixD& gradient, Bool_t showWarning = true);
+    TVector3 GetMagneticFieldAndGradient(TVector3 pos, TMatrixD& gradient, FieldCursor& cursor,
+                                         Bool_t showWarning = true);
 
     Double_t GetPhotonMass(Double_t x, Double_t y, Double_t z, Double_t en);
     Double_t GetPhotonMass(TVector3 pos, Double_t en);
@@ -138,12 +287,16 @@ class TRestAxionMagneticField : public TRestMetadata {
     Double_t GetPhotonAbsorptionLength(Int_t id, Double_t en);
 
     Int_t GetVolumeIndex(TVector3 pos);
+    std::vector<Int_t> GetVolumesAlongRay(TVector3 pos, TVector3 dir);
     Bool_t IsInside(TVector3 pos);
 
     TVector3 GetVolumePosition(Int_t id);
     TVector3 GetVolumeCenter(Int_t id);
 
     Double_t GetTransversalComponent(TVector3 position, TVector3 direction);
+    Double_t GetTransversalComponent(TVector3 position, TVector3 direction, FieldCursor& cursor);
+    void GetTransversalComponent(Int_t n, const Double_t* x, const Double_t* y, const Double_t* z,
+                                 TVector3 direction, Double_t* bt, Bool_t showWarning = true);
 
     std::vector<Double_t> GetTransversalComponentAlongPath(TVector3 from, TVector3 to, Double_t dl = 1.,
                                                            Int_t Nmax = 0);
@@ -152,15 +305,58 @@ class TRestAxionMagneticField : public TRestMetadata {
 
     TVector3 GetFieldAverageTransverseVector(TVector3 from, TVector3 to, Double_t dl = 10., Int_t Nmax = 0);
 
+    FieldLineIntegral GetFieldIntegral(TVector3 from, TVector3 to, Bool_t extrema = false);
+
+    std::vector<FieldLineIntegral> GetFieldIntegrals(const std::vector<TVector3>& path,
+                                                     Bool_t extrema = false);
+
+    /// It defines the distance, in mm, between the rays of the field integral table. Zero disables the table
+    void SetDirectionTableSpacing(Double_t spacing) {
+        fDirectionTableSpacing = spacing;
+        fDirectionTable.Clear();
+        fDirectionTableTooLarge = false;
+    }
+
+    /// It returns the distance, in mm, between the rays of the field integral table
+    Double_t GetDirectionTableSpacing() { return fDirectionTableSpacing; }
+
+    /// It defines the direction of the rays of the field integral table. A zero vector disables the table
+    void SetDirectionTableAxis(TVector3 axis) {
+        fDirectionTableAxis = axis;
+        fDirectionTable.Clear();
+        fDirectionTableTooLarge = false;
+    }
+
+    /// It returns the direction of the rays of the field integral table
+    TVector3 GetDirectionTableAxis() { return fDirectionTableAxis; }
+
+    /// It defines the maximum size, in MB, of the field integral table
+    void SetDirectionTableMaxSize(Double_t size) {
+        fDirectionTableMaxSize = size;
+        fDirectionTable.Clear();
+        fDirectionTableTooLarge = false;
+    }
+
+    /// It returns the maximum size, in MB, of the field integral table
+    Double_t GetDirectionTableMaxSize() { return fDirectionTableMaxSize; }
+
+    /// It returns the time spent at each stage of loading the field map of the volume `id`
+    FieldLoadTimes GetLoadTimes(Int_t id) {
+        if (!FieldLoaded()) LoadMagneticVolumes();
+        return id >= 0 && id < fLoadTimes.size() ? fLoadTimes[id] : FieldLoadTimes();
+    }
+
     TCanvas* DrawHistogram(TString projection, TString Bcomp, Int_t volIndex = -1, Double_t step = -1,
                            TString style = "COLZ0", Double_t depth = -100010.0);
 
+    std::shared_ptr<const TRestAxionFieldEvaluator> GetEvaluator();
+
     void PrintMetadata();
 
     TRestAxionMagneticField();
     TRestAxionMagneticField(const char* cfgFileName, std::string name = "");
     ~TRestAxionMagneticField();
 
-    ClassDef(TRestAxionMagneticField, 3);
+    ClassDef(TRestAxionMagneticField, 17);
 };
 #endif
@@ -0,0 +1,111 @@
+/*************************************************************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+#ifndef _TRestAxionVolumeIndex
+#define _TRestAxionVolumeIndex
+
+#include <vector>
+
+#include "TVector3.h"
+
+/// A bounding volume hierarchy used to find quickly the magnetic volumes at a position or along a ray
+class TRestAxionVolumeIndex {
+   private:
+    /// An axis-aligned box defined by its lower and upper vertexes
+    struct Box {
+        /// The lower vertex of the box
+        Double_t min[3];
+
+        /// The upper vertex of the box
+        Double_t max[3];
+    };
+
+    /// A node of the hierarchy. Leaf nodes point to a range of entries in fIds
+    struct Node {
+        /// The box enclosing all the volumes below this node
+        Box box;
+
+        /// The index of the first child node, or the first entry in fIds for leaf nodes
+        Int_t first;
+
+        /// The number of volumes in a leaf node. It is 0 for internal nodes
+        Int_t count;
+    };
+
+    /// The nodes of the tree. The first node is the root, and the children of a node are consecutive
+    std::vector<Node> fNodes;  //!
+
+    /// The volume ids, ordered so that the volumes of each leaf are consecutive
+    std::vector<Int_t> fIds;  //!
+
+    /// The bounding box of each volume
+    std::vector<Box> fBoxes;  //!
+
+    void BuildNode(Int_t nodeId, Int_t first, Int_t count);
+
+    Bool_t IsInsideBox(const Box& box, const TVector3& pos) const;
+    Bool_t IsCrossingBox(const Box& box, const TVector3& pos, const TVector3& dir) const;
+
+   public:
+    /// The maximum number of volumes stored at a leaf of the hierarchy
+    static const Int_t kLeafSize = 2;
+
+    void Build(const std::vector<TVector3>& boxMin, const std::vector<TVector3>& boxMax);
+
+    void Clear();
+
+    /// It returns the number of volumes registered in the index
+    Int_t GetNumberOfVolumes() const { return fIds.size(); }
+
+    std::vector<Int_t> GetVolumesAt(const TVector3& pos) const;
+
+    /// It returns the lowest id of the volumes whose bounding box contains the position `pos` and for which
+    /// `accept(id)` is true, or -1 if there is none. No memory is allocated, and `accept` is only called for
+    /// the candidates lower than the best id found so far
+    template <typename Accept>
+    Int_t GetFirstVolumeAt(const TVector3& pos, Accept accept) const {
+        if (fNodes.empty()) return -1;
+
+        Int_t first = -1;
+        Int_t stack[64];
+        Int_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = fNodes[stack[--top]];
+            if (!IsInsideBox(node.box, pos)) continue;
+
+            if (node.count == 0) {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+                continue;
+            }
+
+            for (Int_t n = node.first; n < node.first + node.count; n++) {
+                Int_t id = fIds[n];
+                if ((first < 0 || id < first) && IsInsideBox(fBoxes[id], pos) && accept(id)) first = id;
+            }
+        }
+        return first;
+    }
+    std::vector<Int_t> GetVolumesAlongRay(const TVector3& pos, const TVector3& dir) const;
+};
+#endif
@@ -70,6 +70,10 @@
 /// 2019-March: First concept and implementation of TRestAxionBufferGas class.
 ///             Javier Galan
 ///
+/// 2026-October: The photon mass and absorption length of the mixture are
+///               const methods, that can be shared by several threads.
+///               Javier Galan
+///
 /// \class      TRestAxionBufferGas
 /// \author     Javier Galan
 ///
@@ -336,10 +340,10 @@ Double_t TRestAxionBufferGas::GetFormFactor(TString gasName, Double_t energy) {
 /// \brief It returns the inverse of the absorption lenght, for the gas mixture, in cm-1, for the given
 /// energy in keV.
 ///
-Double_t TRestAxionBufferGas::GetPhotonAbsorptionLength(Double_t energy) {
+Double_t TRestAxionBufferGas::GetPhotonAbsorptionLength(Double_t energy) const {
     Double_t attLength = 0;
     for (unsigned int n = 0; n < fBufferGasName.size(); n++)
-        attLength += fBufferGasDensity[n] * GetAbsorptionCoefficient(fBufferGasName[n], energy);
+        attLength += fBufferGasDensity[n] * GetGasAbsorptionCoefficient(n, energy);
 
     return attLength;
 }
@@ -348,14 +352,14 @@ Double_t TRestAxionBufferGas::GetPhotonAbsorptionLength(Double_t energy) {
 /// \brief It returns the inverse of the absorption lenght, for the gas mixture, in eV, for the given
 /// energy in keV.
 ///
-Double_t TRestAxionBufferGas::GetPhotonAbsorptionLengthIneV(Double_t energy) {
+Double_t TRestAxionBufferGas::GetPhotonAbsorptionLengthIneV(Double_t energy) const {
     return cmToeV(GetPhotonAbsorptionLength(energy));
 }
 
 ///////////////////////////////////////////////
 /// \brief It transforms cm-1 to eV
 ///
-Double_t TRestAxionBufferGas::cmToeV(double l_Inv)  // E in keV, P in bar ---> Gamma in cm-1
+Double_t TRestAxionBufferGas::cmToeV(double l_Inv) const  // E in keV, P in bar ---> Gamma in cm-1
 {
     return l_Inv / REST_Physics::PhMeterIneV / 0.01;
 }
@@ -364,7 +368,7 @@ Double_t TRestAxionBufferGas::cmToeV(double l_Inv)  // E in keV, P in bar ---> G
 /// \brief It returns the equivalent photon mass (in eV) for the gas mixture at the given input energy
 /// expressed in keV.
 ///
-Double_t TRestAxionBufferGas::GetPhotonMass(double en) {
+Double_t TRestAxionBufferGas::GetPhotonMass(double en) const {
     Double_t photonMass = 0;
     for (unsigned int n = 0; n < fBufferGasName.size(); n++) {
         Double_t W_value = 0;
@@ -375,11 +379,11 @@ Double_t TRestAxionBufferGas::GetPhotonMass(double en) {
         if (fBufferGasName[n] == "Xe") W_value = 131.293;  // g/mol
 
         if (W_value == 0) {
-            ferr << "Gas name : " << fBufferGasName[n] << " is not implemented in TRestBufferGas!!" << endl;
-            ferr << "W value must be defined in TRestAxionBufferGas::GetPhotonMass" << endl;
-            ferr << "This gas will not contribute to the calculation of the photon mass!" << endl;
+            cerr << "Gas name : " << fBufferGasName[n] << " is not implemented in TRestBufferGas!!" << endl;
+            cerr << "W value must be defined in TRestAxionBufferGas::GetPhotonMass" << endl;
+            cerr << "This gas will not contribute to the calculation of the photon mass!" << endl;
         } else {
-            photonMass += fBufferGasDensity[n] * GetFormFactor(fBufferGasName[n], en) / W_value;
+            photonMass += fBufferGasDensity[n] * GetGasFormFactor(n, en) / W_value;
         }
     }
 
@@ -435,10 +439,84 @@ Double_t TRestAxionBufferGas::GetAbsorptionCoefficient(TString gasName, Double_t
     return (m * energy + n);
 }
 
+///////////////////////////////////////////////
+/// \brief It returns the atomic form factor of the gas component at `gasIndex`, at the given energy in keV.
+///
+/// The gas data must have been read already. This method does not modify the object, and it can be called
+/// from several threads at the same time. For that reason, the errors are written to the standard error
+/// instead of the output streams of the metadata, and the execution is not paused. The non-const method
+/// TRestAxionBufferGas::GetFormFactor keeps that behaviour.
+///
+Double_t TRestAxionBufferGas::GetGasFormFactor(Int_t gasIndex, Double_t energy) const {
+    Int_t energyIndex = GetEnergyIndex(fFactorEnergy[gasIndex], energy);
+
+    if (energyIndex == -1) {
+        cerr << "TRestAxionBufferGas::GetGasFormFactor. Energy out of range" << endl;
+        exit(1);
+    }
+
+    // Absorption coefficient
+    double y2 = fGasFormFactor[gasIndex][energyIndex + 1];
+    double y1 = fGasFormFactor[gasIndex][energyIndex];
+
+    // Normalized field
+    double x2 = fFactorEnergy[gasIndex][energyIndex + 1];
+    double x1 = fFactorEnergy[gasIndex][energyIndex];
+
+    double m = (y2 - y1) / (x2 - x1);
+    double n = y1 - m * x1;
+
+    if (m * energy + n < 0) {
+        cerr << "TRestAxionBufferGas::GetGasFormFactor. Negative coefficient" << endl;
+        cerr << "y2 : " << y2 << " y1 : " << y1 << endl;
+        cerr << "x2 : " << x2 << " x1 : " << x1 << endl;
+        cerr << "m : " << m << " n : " << n << endl;
+        cerr << "E : " << energy << " bin : " << energyIndex << endl;
+    }
+
+    return (m * energy + n);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the absorption coefficient, in cm2/g, of the gas component at `gasIndex`, at the given
+/// energy in keV.
+///
+/// The gas data must have been read already, as at GetGasFormFactor.
+///
+Double_t TRestAxionBufferGas::GetGasAbsorptionCoefficient(Int_t gasIndex, Double_t energy) const {
+    Int_t energyIndex = GetEnergyIndex(fAbsEnergy[gasIndex], energy);
+
+    if (energyIndex == -1) {
+        cerr << "TRestAxionBufferGas::GetGasAbsorptionCoefficient. Energy out of range" << endl;
+        exit(1);
+    }
+
+    // Absorption coefficient
+    double y2 = fGasAbsCoefficient[gasIndex][energyIndex + 1];
+    double y1 = fGasAbsCoefficient[gasIndex][energyIndex];
+
+    // Normalized field
+    double x2 = fAbsEnergy[gasIndex][energyIndex + 1];
+    double x1 = fAbsEnergy[gasIndex][energyIndex];
+
+    double m = (y2 - y1) / (x2 - x1);
+    double n = y1 - m * x1;
+
+    if (m * energy + n < 0) {
+        cerr << "TRestAxionBufferGas::GetGasAbsorptionCoefficient. Negative coefficient" << endl;
+        cerr << "y2 : " << y2 << " y1 : " << y1 << endl;
+        cerr << "x2 : " << x2 << " x1 : " << x1 << endl;
+        cerr << "m : " << m << " n : " << n << endl;
+        cerr << "E : " << energy << " bin : " << energyIndex << endl;
+    }
+
+    return (m * energy + n);
+}
+
 ///////////////////////////////////////////////
 /// \brief It returns the vector element index, from `enVector`, that is just below the given input energy.
 ///
-Int_t TRestAxionBufferGas::GetEnergyIndex(std::vector<Double_t> enVector, Double_t energy) {
+Int_t TRestAxionBufferGas::GetEnergyIndex(const std::vector<Double_t>& enVector, Double_t energy) const {
     for (unsigned int n = 0; n < enVector.size(); n++)
         if (energy < enVector[n]) return n - 1;
 
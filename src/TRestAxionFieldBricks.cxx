@@ -0,0 +1,282 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldBricks stores the field values at the nodes of a
+/// TRestAxionFieldGrid using a resolution adapted to the variations of the
+/// field, as described at TRestAxionFieldGrid::SetAdaptive.
+///
+/// The grid is divided in bricks of `brickCells` cells along each axis. The
+/// last bricks along each axis may contain less cells. Consecutive bricks
+/// share the nodes at their common face, so that each grid cell is fully
+/// contained in a single brick. Inside each brick only one of every
+/// `stride` nodes along each axis is stored, and the field at the other
+/// nodes is obtained by trilinear interpolation of the stored nodes. The
+/// stride of each brick is the largest power of 2, not larger than the
+/// brick, for which the interpolated field differs from the original field
+/// by less than the tolerance at every node of the brick. Where the field
+/// varies linearly, i.e. most of a magnet bore, a brick of 16^3 cells is
+/// described by 8 nodes, while the bricks close to the coils keep all their
+/// nodes.
+///
+/// Since the interpolation of the stored nodes is trilinear, the field of
+/// the grid inside each interval between stored nodes, a coarse cell, is a
+/// single trilinear function. The field may be discontinuous across the
+/// faces of two bricks with different strides, by less than twice the
+/// tolerance.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the adaptive resolution storage
+///               of TRestAxionFieldGrid field maps.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldBricks
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldBricks.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "TRestAxionFieldGrid.h"
+
+using namespace std;
+
+///////////////////////////////////////////////
+/// \brief It builds the bricks from the nodes of `grid`, each brick containing `brickCells` cells along
+/// each axis, with the coarsest stride reproducing the field at every node within `tolerance`, in T.
+///
+/// The grid nodes are read once, and the grid can be released afterwards. It returns false if the grid is
+/// empty or if `brickCells` is not a power of 2.
+///
+Bool_t TRestAxionFieldBricks::Build(const TRestAxionFieldGrid& grid, Double_t tolerance, Int_t brickCells) {
+    fBricks.clear();
+    fValues.clear();
+    fMaxError = 0;
+    if (grid.IsEmpty() || brickCells < 1 || (brickCells & (brickCells - 1)) != 0) return false;
+
+    fTolerance = tolerance;
+    fBrickCells = brickCells;
+    for (int n = 0; n < 3; n++) {
+        fNodes[n] = grid.GetNodes(n);
+        fBrickCount[n] = fNodes[n] > 1 ? (fNodes[n] - 2) / brickCells + 1 : 1;
+    }
+    fBricks.resize((size_t)fBrickCount[0] * fBrickCount[1] * fBrickCount[2]);
+
+    // The original field at the nodes of one brick
+    std::vector<Double_t> original;
+    size_t id = 0;
+    for (Int_t bx = 0; bx < fBrickCount[0]; bx++)
+        for (Int_t by = 0; by < fBrickCount[1]; by++)
+            for (Int_t bz = 0; bz < fBrickCount[2]; bz++, id++) {
+                Brick& brick = fBricks[id];
+                Int_t first[3] = {bx * brickCells, by * brickCells, bz * brickCells};
+                for (int n = 0; n < 3; n++)
+                    brick.cells[n] = fNodes[n] > 1 ? min(brickCells, fNodes[n] - 1 - first[n]) : 0;
+
+                const Int_t* cells = brick.cells;
+                original.resize((size_t)(cells[0] + 1) * (cells[1] + 1) * (cells[2] + 1) * 3);
+                Double_t* v = original.data();
+                for (Int_t i = 0; i <= cells[0]; i++)
+                    for (Int_t j = 0; j <= cells[1]; j++)
+                        for (Int_t k = 0; k <= cells[2]; k++, v += 3) {
+                            TVector3 b = grid.GetNodeField(first[0] + i, first[1] + j, first[2] + k);
+                            for (int c = 0; c < 3; c++) v[c] = b[c];
+                        }
+
+                // The strides are tried from the coarsest one. A stride of 1 stores all the nodes
+                for (Int_t stride = brickCells;; stride /= 2) {
+                    brick.stride = stride;
+                    brick.offset = fValues.size();
+                    for (int n = 0; n < 3; n++) brick.nodes[n] = (cells[n] + stride - 1) / stride + 1;
+
+                    for (Int_t i = 0; i < brick.nodes[0]; i++)
+                        for (Int_t j = 0; j < brick.nodes[1]; j++)
+                            for (Int_t k = 0; k < brick.nodes[2]; k++) {
+                                Int_t u[3] = {min(i * stride, cells[0]), min(j * stride, cells[1]),
+                                              min(k * stride, cells[2])};
+                                size_t index = ((u[0] * (cells[1] + 1) + u[1]) * (cells[2] + 1) + u[2]) * 3;
+                                for (int c = 0; c < 3; c++) fValues.push_back(original[index + c]);
+                            }
+                    if (stride == 1) break;
+
+                    Double_t error = 0;
+                    v = original.data();
+                    for (Int_t i = 0; i <= cells[0]; i++)
+                        for (Int_t j = 0; j <= cells[1]; j++)
+                            for (Int_t k = 0; k <= cells[2]; k++, v += 3) {
+                                Int_t local[3] = {i, j, k};
+                                Double_t b[3];
+                                Reconstruct(brick, local, b);
+                                for (int c = 0; c < 3; c++) error = max(error, fabs(b[c] - v[c]));
+                            }
+
+                    if (error <= tolerance) {
+                        fMaxError = max(fMaxError, error);
+                        break;
+                    }
+                    fValues.resize(brick.offset);
+                }
+            }
+
+    fValues.shrink_to_fit();
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the brick containing the grid `node`, and it writes at `local` the position of the
+/// node inside the brick. A node at the common face of two bricks belongs to the upper brick.
+///
+const TRestAxionFieldBricks::Brick& TRestAxionFieldBricks::GetBrick(const Int_t* node, Int_t* local) const {
+    size_t id = 0;
+    for (int n = 0; n < 3; n++) {
+        Int_t b = fNodes[n] > 1 ? min(node[n] / fBrickCells, fBrickCount[n] - 1) : 0;
+        local[n] = node[n] - b * fBrickCells;
+        id = id * fBrickCount[n] + b;
+    }
+    return fBricks[id];
+}
+
+///////////////////////////////////////////////
+/// \brief It finds the interval between stored nodes of `brick` along the axis `n` containing the `local`
+/// node. The first stored node of the interval is written at `first`, and the relative position of the
+/// node inside it at `fraction`.
+///
+void TRestAxionFieldBricks::GetInterval(const Brick& brick, Int_t n, Int_t local, Int_t& first,
+                                        Double_t& fraction) const {
+    if (brick.nodes[n] < 2) {
+        first = 0;
+        fraction = 0;
+        return;
+    }
+
+    first = min(local / brick.stride, brick.nodes[n] - 2);
+    Int_t lower = first * brick.stride;
+    Int_t upper = min(lower + brick.stride, brick.cells[n]);
+    fraction = (Double_t)(local - lower) / (upper - lower);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the field at the `local` node of `brick`, interpolated from the stored
+/// nodes.
+///
+void TRestAxionFieldBricks::Reconstruct(const Brick& brick, const Int_t* local, Double_t* field) const {
+    Int_t first[3];
+    Double_t f[3];
+    size_t s[3] = {(size_t)brick.nodes[1] * brick.nodes[2] * 3, (size_t)brick.nodes[2] * 3, 3};
+    for (int n = 0; n < 3; n++) {
+        GetInterval(brick, n, local[n], first[n], f[n]);
+        if (brick.nodes[n] < 2) s[n] = 0;
+    }
+
+    const Double_t* v = fValues.data() + brick.offset + first[0] * s[0] + first[1] * s[1] + first[2] * s[2];
+    for (int c = 0; c < 3; c++) {
+        const Double_t* a = v + c;
+        Double_t c00 = a[0] + f[0] * (a[s[0]] - a[0]);
+        Double_t c01 = a[s[2]] + f[0] * (a[s[0] + s[2]] - a[s[2]]);
+        Double_t c10 = a[s[1]] + f[0] * (a[s[0] + s[1]] - a[s[1]]);
+        Double_t c11 = a[s[1] + s[2]] + f[0] * (a[s[0] + s[1] + s[2]] - a[s[1] + s[2]]);
+        Double_t c0 = c00 + f[1] * (c10 - c00);
+        Double_t c1 = c01 + f[1] * (c11 - c01);
+        field[c] = c0 + f[2] * (c1 - c0);
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the field components (Bx,By,Bz), in T, at the grid `node`
+///
+void TRestAxionFieldBricks::GetNode(const Int_t* node, Double_t* field) const {
+    Int_t local[3];
+    const Brick& brick = GetBrick(node, local);
+    Reconstruct(brick, local, field);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `values` the field components at the 8 corners of the grid cell whose bottom, down,
+/// left node is `node`, ordered as in FieldCellCache. All the corners are taken from the brick containing
+/// the cell.
+///
+/// If the grid has a single node along one axis, the corners along that axis are the same node.
+///
+void TRestAxionFieldBricks::GetCell(const Int_t* node, Double_t* values) const {
+    Int_t local[3];
+    const Brick& brick = GetBrick(node, local);
+
+    // Both ends of the cell are found inside the same interval between stored nodes
+    Int_t first[3];
+    Double_t f[3][2];
+    size_t s[3] = {(size_t)brick.nodes[1] * brick.nodes[2] * 3, (size_t)brick.nodes[2] * 3, 3};
+    for (int n = 0; n < 3; n++) {
+        GetInterval(brick, n, local[n], first[n], f[n][0]);
+        if (brick.nodes[n] < 2) {
+            s[n] = 0;
+            f[n][1] = 0;
+        } else {
+            Int_t lower = first[n] * brick.stride;
+            Int_t upper = min(lower + brick.stride, brick.cells[n]);
+            f[n][1] = (Double_t)(local[n] + 1 - lower) / (upper - lower);
+        }
+    }
+
+    const Double_t* v = fValues.data() + brick.offset + first[0] * s[0] + first[1] * s[1] + first[2] * s[2];
+    for (int c = 0; c < 3; c++) {
+        const Double_t* a = v + c;
+        for (int i = 0; i < 2; i++) {
+            Double_t c00 = a[0] + f[0][i] * (a[s[0]] - a[0]);
+            Double_t c01 = a[s[2]] + f[0][i] * (a[s[0] + s[2]] - a[s[2]]);
+            Double_t c10 = a[s[1]] + f[0][i] * (a[s[0] + s[1]] - a[s[1]]);
+            Double_t c11 = a[s[1] + s[2]] + f[0][i] * (a[s[0] + s[1] + s[2]] - a[s[1] + s[2]]);
+            for (int j = 0; j < 2; j++) {
+                Double_t c0 = c00 + f[1][j] * (c10 - c00);
+                Double_t c1 = c01 + f[1][j] * (c11 - c01);
+                for (int k = 0; k < 2; k++) values[3 * (i + 2 * j + 4 * k) + c] = c0 + f[2][k] * (c1 - c0);
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It returns an identifier of the interval between stored nodes, the coarse cell, containing the
+/// grid cell whose bottom, down, left node is `node`. The field inside a coarse cell is a single trilinear
+/// function.
+///
+size_t TRestAxionFieldBricks::GetCellId(const Int_t* node) const {
+    Int_t local[3];
+    const Brick& brick = GetBrick(node, local);
+
+    size_t id = &brick - fBricks.data();
+    for (int n = 0; n < 3; n++) {
+        Int_t first;
+        Double_t fraction;
+        GetInterval(brick, n, local[n], first, fraction);
+        id = id * (fBrickCells + 1) + first;
+    }
+    return id;
+}
@@ -0,0 +1,218 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldDirectionTable keeps the field integrals along a bundle of
+/// parallel rays with a fixed direction, so that the integrals along any
+/// segment with that direction are obtained by interpolation, without
+/// evaluating the field map.
+///
+/// The rays start at a plane normal to the direction, and they are placed at
+/// the nodes of a square grid covering the projection of the magnetic
+/// volumes on that plane. Along each ray the integrals from the first node,
+/// as defined at FieldLineIntegral, are stored at regular nodes. The same
+/// spacing is used between rays and between nodes along a ray.
+///
+/// The table is filled by TRestAxionMagneticField, that integrates the
+/// field map along each ray. The integrals along a segment are then
+/// obtained by the difference of the stored integrals at both ends, linearly
+/// interpolated along the ray, and bilinearly interpolated between the 4
+/// rays around the segment. The result is an approximation, that will smear
+/// the field near the boundaries of the volumes within one spacing.
+///
+/// The minimum and maximum transverse intensity are not stored, and both are
+/// set to the average transverse intensity of the segment. The callers that
+/// need them must integrate the field maps, as done by
+/// TRestAxionMagneticField::GetFieldIntegrals when `extrema` is true.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the direction table used by
+///               TRestAxionMagneticField::GetFieldIntegrals.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldDirectionTable
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldDirectionTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+///////////////////////////////////////////////
+/// \brief It defines the geometry of a table for rays along the unit vector `direction`, covering the box
+/// defined by the vertexes `boxMin` and `boxMax`, with a distance `spacing` between rays and between
+/// nodes along each ray.
+///
+/// The stored integrals are initialized to zero, and they must be filled using
+/// TRestAxionFieldDirectionTable::SetRay. If the table would take more than `maxBytes` bytes, no memory
+/// is allocated and it returns false. A zero `maxBytes` does not limit the size.
+///
+Bool_t TRestAxionFieldDirectionTable::Define(const TVector3& direction, const TVector3& boxMin,
+                                             const TVector3& boxMax, Double_t spacing, size_t maxBytes) {
+    Clear();
+    if (spacing <= 0 || direction.Mag2() == 0) return false;
+
+    fDirection = direction.Unit();
+    fAxes[0] = fDirection.Orthogonal().Unit();
+    fAxes[1] = fDirection.Cross(fAxes[0]);
+    fSpacing = spacing;
+
+    // The extent of the box along the plane axes and the direction
+    TVector3 axes[3] = {fAxes[0], fAxes[1], fDirection};
+    Double_t low[3], high[3];
+    for (int n = 0; n < 3; n++) {
+        low[n] = HUGE_VAL;
+        high[n] = -HUGE_VAL;
+    }
+    for (int c = 0; c < 8; c++) {
+        TVector3 corner((c & 1) ? boxMax.X() : boxMin.X(), (c & 2) ? boxMax.Y() : boxMin.Y(),
+                        (c & 4) ? boxMax.Z() : boxMin.Z());
+        for (int n = 0; n < 3; n++) {
+            low[n] = min(low[n], corner * axes[n]);
+            high[n] = max(high[n], corner * axes[n]);
+        }
+    }
+
+    // The size is checked before the number of nodes is converted to integers, that could overflow
+    Double_t values = kValues;
+    for (int n = 0; n < 3; n++) values *= ceil((high[n] - low[n]) / spacing) + 1;
+    if (maxBytes > 0 && values * sizeof(Double_t) > maxBytes) {
+        fDirection = TVector3(0, 0, 0);
+        return false;
+    }
+
+    fOrigin = TVector3(0, 0, 0);
+    for (int n = 0; n < 3; n++) {
+        fNodes[n] = (Int_t)ceil((high[n] - low[n]) / spacing) + 1;
+        fOrigin += low[n] * axes[n];
+    }
+
+    fValues.assign((size_t)fNodes[0] * fNodes[1] * fNodes[2] * kValues, 0);
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It releases the table
+///
+void TRestAxionFieldDirectionTable::Clear() {
+    fValues.clear();
+    fValues.shrink_to_fit();
+    fDirection = TVector3(0, 0, 0);
+    for (int n = 0; n < 3; n++) fNodes[n] = 0;
+}
+
+///////////////////////////////////////////////
+/// \brief It stores the integrals of the ray (ia, ib). The element `n` of `pieces` must contain the
+/// integrals between the nodes `n` and `n+1` of the ray.
+///
+void TRestAxionFieldDirectionTable::SetRay(Int_t ia, Int_t ib, const std::vector<FieldLineIntegral>& pieces) {
+    Double_t* values = fValues.data() + ((size_t)ia * fNodes[1] + ib) * fNodes[2] * kValues;
+
+    Double_t sum[kValues] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (Int_t n = 0; n < fNodes[2]; n++) {
+        if (n > 0 && n - 1 < (Int_t)pieces.size()) {
+            const FieldLineIntegral& piece = pieces[n - 1];
+            for (int c = 0; c < 3; c++) {
+                sum[c] += piece.field[c];
+                sum[3 + c] += piece.transverse[c];
+            }
+            sum[6] += piece.transverseMag;
+            sum[7] += piece.transverseMag2;
+        }
+        for (int c = 0; c < kValues; c++) values[n * kValues + c] = sum[c];
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `values` the integrals of the ray (ia, ib) from its first node to the distance `s`,
+/// using a linear interpolation between nodes.
+///
+void TRestAxionFieldDirectionTable::GetRayIntegrals(Int_t ia, Int_t ib, Double_t s, Double_t* values) const {
+    const Double_t* ray = fValues.data() + ((size_t)ia * fNodes[1] + ib) * fNodes[2] * kValues;
+
+    Double_t u = min(max(s / fSpacing, 0.), (Double_t)(fNodes[2] - 1));
+    Int_t n = min((Int_t)u, fNodes[2] - 2);
+    if (n < 0) n = 0;
+    Double_t f = fNodes[2] > 1 ? u - n : 0;
+    Int_t next = fNodes[2] > 1 ? n + 1 : n;
+
+    for (int c = 0; c < kValues; c++)
+        values[c] = (1 - f) * ray[n * kValues + c] + f * ray[next * kValues + c];
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the field integrals along the segment between the positions `from` and `to`,
+/// that must be parallel to the table direction.
+///
+/// Segments passing outside the rays of the table have no field.
+///
+FieldLineIntegral TRestAxionFieldDirectionTable::GetIntegral(const TVector3& from, const TVector3& to) const {
+    FieldLineIntegral integral;
+    integral.length = (to - from).Mag();
+    if (integral.length == 0 || fValues.empty()) return integral;
+
+    // The position of the segment in the plane, and its ends along the rays
+    TVector3 p = from - fOrigin;
+    Double_t a = (p * fAxes[0]) / fSpacing;
+    Double_t b = (p * fAxes[1]) / fSpacing;
+    Double_t s0 = p * fDirection;
+    Double_t s1 = (to - fOrigin) * fDirection;
+
+    Int_t ia = (Int_t)floor(a), ib = (Int_t)floor(b);
+    if (ia < 0 || ib < 0 || ia > fNodes[0] - 1 || ib > fNodes[1] - 1) {
+        integral.samples = 1;
+        return integral;
+    }
+    Double_t fa = a - ia, fb = b - ib;
+
+    Double_t sum[kValues] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int r = 0; r < 4; r++) {
+        Int_t ra = min(ia + (r & 1), fNodes[0] - 1);
+        Int_t rb = min(ib + (r >> 1), fNodes[1] - 1);
+        Double_t w = ((r & 1) ? fa : 1 - fa) * ((r >> 1) ? fb : 1 - fb);
+        if (w == 0) continue;
+
+        Double_t v0[kValues], v1[kValues];
+        GetRayIntegrals(ra, rb, s0, v0);
+        GetRayIntegrals(ra, rb, s1, v1);
+        for (int c = 0; c < kValues; c++) sum[c] += w * (v1[c] - v0[c]);
+    }
+
+    integral.field = TVector3(sum[0], sum[1], sum[2]);
+    integral.transverse = TVector3(sum[3], sum[4], sum[5]);
+    integral.transverseMag = sum[6];
+    integral.transverseMag2 = sum[7];
+    integral.transverseMin = integral.transverseMax = integral.GetTransversalFieldAverage();
+    integral.samples = 1;
+
+    return integral;
+}
@@ -0,0 +1,580 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldEvaluator is an immutable snapshot of the magnetic
+/// volumes defined at TRestAxionMagneticField, that is created once the
+/// volumes are loaded, using TRestAxionMagneticField::GetEvaluator.
+///
+/// TRestAxionMagneticField loads the field maps on demand, and some of its
+/// methods modify the object, e.g. to load the volumes, to build the field
+/// integral table or to draw the field. An evaluator only provides const
+/// methods, and it can be used by several threads at the same time. No lock
+/// is taken, except for the field maps read from a tiled grid file.
+///
+/// \code
+/// TRestAxionMagneticField* field = new TRestAxionMagneticField("fields.rml", "bFieldBabyIAXO");
+/// std::shared_ptr<const TRestAxionFieldEvaluator> evaluator = field->GetEvaluator();
+///
+/// // Any number of threads may now use the evaluator
+/// TVector3 b = evaluator->GetMagneticField(TVector3(0, 0, 100));
+/// Double_t mass = evaluator->GetPhotonMass(TVector3(0, 0, 100), 4.2);
+/// \endcode
+///
+/// The field queries at nearby positions, e.g. the steps along a ray, can
+/// be done through a FieldCursor, that is owned by each thread. It
+/// remembers the volume and the grid cell of the last position, so that the
+/// volume index is not searched, and the nodes of the cell are not read,
+/// while the positions remain inside them.
+///
+/// \code
+/// FieldCursor cursor;
+/// for (Double_t t = 0; t < length; t += 1)
+///     Bt.push_back(evaluator->GetTransversalComponent(from + t * dir, dir, cursor));
+/// \endcode
+///
+/// The field maps are shared with TRestAxionMagneticField, without copying
+/// the field data, while each evaluator keeps its own copy of the gas
+/// properties of each volume. The evaluator remains valid, and unchanged,
+/// even if the volumes of TRestAxionMagneticField are loaded again. Field
+/// maps read from a tiled grid file are read on demand through
+/// TRestAxionFieldTileCache. The cache is divided in shards with their own
+/// lock, that is held only to find a tile in memory and never while reading
+/// the file, so that the threads rarely wait for each other.
+///
+/// The query methods give the same results, within rounding, as the
+/// corresponding methods of TRestAxionMagneticField, without printing any
+/// warning. A position outside any volume has no field, and the photon mass
+/// and absorption length are -1 outside any volume. The field integrals do
+/// not use the table defined by the parameters `directionTableAxis` and
+/// `directionTableSpacing`, since the table is built on demand.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the read-only field evaluator.
+///               Javier Galan
+///
+/// 2026-October: Field cursor, reusing the volume and grid cell of the
+///               previous query.
+///               Javier Galan
+///
+/// 2026-October: Field gradient obtained together with the field.
+///               Javier Galan
+///
+/// 2026-October: Volumes with an analytic field model.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldEvaluator
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldEvaluator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+///////////////////////////////////////////////
+/// \brief Constructor that takes the description of each magnetic volume. The position of each volume in
+/// the vector defines the volume id.
+///
+TRestAxionFieldEvaluator::TRestAxionFieldEvaluator(const std::vector<Volume>& volumes) : fVolumes(volumes) {
+    std::vector<TVector3> boxMin, boxMax;
+    for (unsigned int n = 0; n < fVolumes.size(); n++) {
+        boxMin.push_back(fVolumes[n].position - fVolumes[n].boundMax);
+        boxMax.push_back(fVolumes[n].position + fVolumes[n].boundMax);
+    }
+    fVolumeIndex.Build(boxMin, boxMax);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns true if the position `pos` is inside the box, or the cylinder, of the volume `vol`.
+/// The surface of the volume is considered inside.
+///
+Bool_t TRestAxionFieldEvaluator::IsInsideVolume(const Volume& vol, const TVector3& pos) const {
+    TVector3 d = pos - vol.position;
+    if (fabs(d.Z()) > vol.boundMax.Z()) return false;
+    if (vol.cylindrical) return d.X() * d.X() + d.Y() * d.Y() <= vol.boundMax.X() * vol.boundMax.X();
+    return fabs(d.X()) <= vol.boundMax.X() && fabs(d.Y()) <= vol.boundMax.Y();
+}
+
+///////////////////////////////////////////////
+/// \brief It finds the distances, `tIn` and `tOut`, where the line defined by the position `pos` and the
+/// unit vector `dir` enters and leaves the volume `vol`. The distances are negative behind `pos`.
+///
+/// It returns false if the line does not cross the volume.
+///
+Bool_t TRestAxionFieldEvaluator::GetLineCrossing(const Volume& vol, const TVector3& pos, const TVector3& dir,
+                                                 Double_t& tIn, Double_t& tOut) const {
+    TVector3 d = pos - vol.position;
+    tIn = -HUGE_VAL;
+    tOut = HUGE_VAL;
+
+    // The slabs along z, and also along x and y for a box
+    for (int k = vol.cylindrical ? 2 : 0; k < 3; k++) {
+        if (dir[k] == 0) {
+            if (fabs(d[k]) > vol.boundMax[k]) return false;
+            continue;
+        }
+        Double_t t1 = (-vol.boundMax[k] - d[k]) / dir[k];
+        Double_t t2 = (vol.boundMax[k] - d[k]) / dir[k];
+        tIn = max(tIn, min(t1, t2));
+        tOut = min(tOut, max(t1, t2));
+    }
+
+    if (vol.cylindrical) {
+        Double_t r2 = vol.boundMax.X() * vol.boundMax.X();
+        Double_t a = dir.X() * dir.X() + dir.Y() * dir.Y();
+        Double_t b = d.X() * dir.X() + d.Y() * dir.Y();
+        Double_t c = d.X() * d.X() + d.Y() * d.Y() - r2;
+        if (a == 0) {
+            if (c > 0) return false;
+        } else {
+            Double_t disc = b * b - a * c;
+            if (disc < 0) return false;
+            Double_t s = sqrt(disc);
+            tIn = max(tIn, (-b - s) / a);
+            tOut = min(tOut, (-b + s) / a);
+        }
+    }
+
+    return tOut > tIn;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the corresponding volume index at the given position. If not found it will return
+/// -1.
+///
+Int_t TRestAxionFieldEvaluator::GetVolumeIndex(const TVector3& pos) const {
+    return fVolumeIndex.GetFirstVolumeAt(pos, [&](Int_t id) { return IsInsideVolume(fVolumes[id], pos); });
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the ids of the volumes whose bounding box is crossed by the trajectory starting at
+/// `pos` and moving along the direction `dir`, as TRestAxionMagneticField::GetVolumesAlongRay.
+///
+std::vector<Int_t> TRestAxionFieldEvaluator::GetVolumesAlongRay(const TVector3& pos,
+                                                                const TVector3& dir) const {
+    return fVolumeIndex.GetVolumesAlongRay(pos, dir);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the entry and exit points of the trajectory defined by the position `pos` and the
+/// direction `dir` at the volume `id`.
+///
+/// If no intersection is found, or the particle is not moving towards the volume, i.e. `pos` is not
+/// placed before the entry point, the returned std::vector will be empty.
+///
+std::vector<TVector3> TRestAxionFieldEvaluator::GetVolumeBoundaries(Int_t id, const TVector3& pos,
+                                                                    const TVector3& dir) const {
+    std::vector<TVector3> boundaries;
+    if (id < 0 || id >= GetNumberOfVolumes()) return boundaries;
+
+    TVector3 unit = dir.Unit();
+    Double_t tIn, tOut;
+    if (!GetLineCrossing(fVolumes[id], pos, unit, tIn, tOut) || tIn < 0) return boundaries;
+
+    boundaries.push_back(pos + tIn * unit);
+    boundaries.push_back(pos + tOut * unit);
+    return boundaries;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the first and last points of the trajectory inside the volume `id` where the
+/// transversal field is not zero, as described at TRestAxionMagneticField::GetFieldBoundaries.
+///
+std::vector<TVector3> TRestAxionFieldEvaluator::GetFieldBoundaries(Int_t id, const TVector3& pos,
+                                                                   const TVector3& dir,
+                                                                   Double_t precision) const {
+    std::vector<TVector3> volumeBoundaries = GetVolumeBoundaries(id, pos, dir);
+    if (volumeBoundaries.size() != 2) return volumeBoundaries;
+
+    return FindFieldBoundaries(id, volumeBoundaries[0], volumeBoundaries[1], precision);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the first and last points, in the segment between the points `entry` and `exit` where
+/// a trajectory crosses the volume `id`, where the transversal field is not zero.
+///
+/// If no precision is given, half the mesh size of the volume is used. The regions of the field map
+/// without field are skipped using the occupancy of the grid cells (see
+/// TRestAxionFieldGrid::GetOccupiedIntervals). The field is only evaluated inside the cells with field, in
+/// steps of half the mesh size, and the boundary is then refined by bisection if a smaller precision is
+/// required. If the field of the volume is constant, the segment limits are returned.
+///
+/// If no field is found the returned std::vector will be empty.
+///
+std::vector<TVector3> TRestAxionFieldEvaluator::FindFieldBoundaries(Int_t id, const TVector3& entry,
+                                                                    const TVector3& exit,
+                                                                    Double_t precision) const {
+    std::vector<TVector3> fieldBoundaries;
+    if (id < 0 || id >= GetNumberOfVolumes()) return fieldBoundaries;
+
+    const Volume& vol = fVolumes[id];
+    if (vol.field.IsEmpty() && vol.model.IsEmpty()) return {entry, exit};
+
+    Double_t meshStep = min(vol.meshSize.X(), min(vol.meshSize.Y(), vol.meshSize.Z())) / 2.;
+    if (precision == 0) precision = meshStep;
+    Double_t step = max(precision, meshStep);
+
+    TVector3 unit = (exit - entry).Unit();
+    TVector3 start = entry;
+    Double_t length = (exit - start).Mag();
+    if (length <= 0) return fieldBoundaries;
+
+    // A constant field is added everywhere, and an analytic field is not bound to the cells of a map. The
+    // full crossing must be explored in both cases
+    std::vector<std::pair<Double_t, Double_t>> intervals;
+    if (vol.constantField == TVector3(0, 0, 0) && vol.model.IsEmpty())
+        intervals = vol.field.GetOccupiedIntervals(start, exit);
+    else
+        intervals.push_back({0, length});
+
+    Double_t in = 0;
+    Bool_t found = false;
+    for (unsigned int n = 0; n < intervals.size() && !found; n++)
+        found = FindTransversalFieldEdge(start, unit, intervals[n].first, intervals[n].second, step,
+                                         precision, in);
+    if (!found) return fieldBoundaries;
+    fieldBoundaries.push_back(start + in * unit);
+
+    Double_t out = length;
+    found = false;
+    for (unsigned int n = intervals.size(); n > 0 && !found && intervals[n - 1].second > in; n--) {
+        Double_t last = max(intervals[n - 1].first, in);
+        found = FindTransversalFieldEdge(start, unit, intervals[n - 1].second, last, step, precision, out);
+    }
+    if (found && out > in) fieldBoundaries.push_back(start + out * unit);
+
+    return fieldBoundaries;
+}
+
+///////////////////////////////////////////////
+/// \brief It searches the closest point to `from` where the transversal field is not zero, in the line
+/// defined by the position `pos` and the unit vector `dir`, and moving from the distance `from` towards the
+/// distance `to`.
+///
+/// The field is evaluated in steps of length `step`. The first step with field is then divided by
+/// bisection until its length is below `precision`. The distance of the point found is written at `edge`.
+/// It returns false if no field is found.
+///
+Bool_t TRestAxionFieldEvaluator::FindTransversalFieldEdge(const TVector3& pos, const TVector3& dir,
+                                                          Double_t from, Double_t to, Double_t step,
+                                                          Double_t precision, Double_t& edge) const {
+    FieldCursor cursor;
+    if (GetTransversalComponent(pos + from * dir, dir, cursor) != 0) {
+        edge = from;
+        return true;
+    }
+
+    // The last distance without field, and the first one with field
+    Double_t empty = from;
+    Double_t field = from;
+    Int_t steps = (Int_t)ceil(fabs(to - from) / step);
+    for (Int_t n = 1; n <= steps && field == from; n++) {
+        Double_t t = n == steps ? to : from + n * (to > from ? step : -step);
+        if (GetTransversalComponent(pos + t * dir, dir, cursor) != 0)
+            field = t;
+        else
+            empty = t;
+    }
+    if (field == from) return false;
+
+    while (fabs(field - empty) > precision) {
+        Double_t t = 0.5 * (empty + field);
+        if (GetTransversalComponent(pos + t * dir, dir, cursor) != 0)
+            field = t;
+        else
+            empty = t;
+    }
+
+    edge = field;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at the position `pos`. The field is zero outside any
+/// volume.
+///
+TVector3 TRestAxionFieldEvaluator::GetMagneticField(const TVector3& pos) const {
+    Int_t id = GetVolumeIndex(pos);
+    if (id < 0) return TVector3(0, 0, 0);
+
+    return GetMagneticField(id, pos);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector of the volume `id` at the position `pos`, that must be
+/// found inside that volume, e.g. using TRestAxionFieldEvaluator::GetVolumeIndex.
+///
+TVector3 TRestAxionFieldEvaluator::GetMagneticField(Int_t id, const TVector3& pos) const {
+    const Volume& vol = fVolumes[id];
+    if (!vol.model.IsEmpty()) return vol.model.Evaluate(pos) + vol.constantField;
+    if (vol.field.IsEmpty()) return vol.constantField;
+    return vol.field.Interpolate(pos) + vol.constantField;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at the position `pos`, using the volume and grid cell of
+/// the previous query kept at `cursor`.
+///
+/// The result is equal within rounding to TRestAxionFieldEvaluator::GetMagneticField without cursor. The
+/// volume of the previous position is checked first, and the volume index is only used when the position
+/// leaves it. Inside a field map, the nodes of the cell are only read when the position moves to a different
+/// cell, see TRestAxionFieldGrid::Interpolate. A cursor must not be shared between threads.
+///
+TVector3 TRestAxionFieldEvaluator::GetMagneticField(const TVector3& pos, FieldCursor& cursor) const {
+    Int_t id = cursor.volume;
+    if (id < 0 || id >= GetNumberOfVolumes() || !IsInsideVolume(fVolumes[id], pos)) {
+        id = GetVolumeIndex(pos);
+        cursor.volume = id;
+    }
+    if (id < 0) return TVector3(0, 0, 0);
+
+    const Volume& vol = fVolumes[id];
+    if (!vol.model.IsEmpty()) return vol.model.Evaluate(pos) + vol.constantField;
+    if (vol.field.IsEmpty()) return vol.constantField;
+    return vol.field.Interpolate(pos, cursor.cell) + vol.constantField;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at the position `pos`, and it writes at `gradient` its
+/// derivatives, in T/mm, as described at TRestAxionMagneticField::GetMagneticFieldAndGradient.
+///
+TVector3 TRestAxionFieldEvaluator::GetMagneticFieldAndGradient(const TVector3& pos,
+                                                               TMatrixD& gradient) const {
+    FieldCursor cursor;
+    return GetMagneticFieldAndGradient(pos, gradient, cursor);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at the position `pos`, and it writes at `gradient` its
+/// derivatives, using the volume and grid cell of the previous query kept at `cursor`.
+///
+TVector3 TRestAxionFieldEvaluator::GetMagneticFieldAndGradient(const TVector3& pos, TMatrixD& gradient,
+                                                               FieldCursor& cursor) const {
+    gradient.ResizeTo(3, 3);
+    gradient.Zero();
+
+    Int_t id = cursor.volume;
+    if (id < 0 || id >= GetNumberOfVolumes() || !IsInsideVolume(fVolumes[id], pos)) {
+        id = GetVolumeIndex(pos);
+        cursor.volume = id;
+    }
+    if (id < 0) return TVector3(0, 0, 0);
+
+    const Volume& vol = fVolumes[id];
+    if (vol.field.IsEmpty() && vol.model.IsEmpty()) return vol.constantField;
+
+    Double_t p[3] = {pos.X(), pos.Y(), pos.Z()};
+    Double_t b[3], g[9];
+    if (vol.model.IsEmpty())
+        vol.field.InterpolateGradient(p, b, g, cursor.cell);
+    else
+        vol.model.Evaluate(p, b, g);
+    for (int c = 0; c < 3; c++)
+        for (int n = 0; n < 3; n++) gradient(c, n) = g[3 * c + n];
+
+    return TVector3(b[0], b[1], b[2]) + vol.constantField;
+}
+
+///////////////////////////////////////////////
+/// \brief It evaluates the magnetic field at `n` positions given by the coordinate arrays `x`, `y` and `z`,
+/// and writes the field components at the arrays `bx`, `by` and `bz`.
+///
+/// Consecutive positions found inside the same magnetic volume are interpolated together using
+/// TRestAxionFieldGrid, which will use vector instructions (AVX2/AVX-512) when available. The result is equal
+/// within rounding to the evaluation of each position, since the vector instructions may use fused
+/// multiply-adds. Positions outside any volume will get a null field.
+///
+/// It returns the number of positions found outside any volume.
+///
+Int_t TRestAxionFieldEvaluator::GetMagneticField(Int_t n, const Double_t* x, const Double_t* y,
+                                                 const Double_t* z, Double_t* bx, Double_t* by,
+                                                 Double_t* bz) const {
+    Int_t outside = 0;
+
+    Int_t p = 0;
+    Int_t id = n > 0 ? GetVolumeIndex(TVector3(x[0], y[0], z[0])) : -1;
+    while (p < n) {
+        // We find the range [p,q) of consecutive positions found at the same volume. The volume index is
+        // only searched when a position leaves the current volume
+        Int_t q = p + 1;
+        Int_t nextId = -1;
+        while (q < n) {
+            TVector3 pos(x[q], y[q], z[q]);
+            if (id < 0 || !IsInsideVolume(fVolumes[id], pos)) {
+                nextId = GetVolumeIndex(pos);
+                if (nextId != id) break;
+            }
+            q++;
+        }
+
+        if (id < 0) {
+            for (Int_t k = p; k < q; k++) bx[k] = by[k] = bz[k] = 0;
+            outside += q - p;
+        } else {
+            const Volume& vol = fVolumes[id];
+            const TVector3& offset = vol.constantField;
+            if (!vol.model.IsEmpty()) {
+                for (Int_t k = p; k < q; k++) {
+                    TVector3 b = vol.model.Evaluate(TVector3(x[k], y[k], z[k])) + offset;
+                    bx[k] = b.X();
+                    by[k] = b.Y();
+                    bz[k] = b.Z();
+                }
+            } else if (vol.field.IsEmpty()) {
+                for (Int_t k = p; k < q; k++) {
+                    bx[k] = offset.X();
+                    by[k] = offset.Y();
+                    bz[k] = offset.Z();
+                }
+            } else {
+                vol.field.Interpolate(q - p, x + p, y + p, z + p, bx + p, by + p, bz + p);
+                if (offset != TVector3(0, 0, 0)) {
+                    for (Int_t k = p; k < q; k++) {
+                        bx[k] += offset.X();
+                        by[k] += offset.Y();
+                        bz[k] += offset.Z();
+                    }
+                }
+            }
+        }
+
+        p = q;
+        id = nextId;
+    }
+
+    return outside;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the intensity of the transversal magnetic field component for the propagation
+/// direction `dir` at the position `pos`.
+///
+Double_t TRestAxionFieldEvaluator::GetTransversalComponent(const TVector3& pos, const TVector3& dir) const {
+    return abs(GetMagneticField(pos).Perp(dir));
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the intensity of the transversal magnetic field component for the propagation
+/// direction `dir` at the position `pos`, using the `cursor` as described at
+/// TRestAxionFieldEvaluator::GetMagneticField.
+///
+Double_t TRestAxionFieldEvaluator::GetTransversalComponent(const TVector3& pos, const TVector3& dir,
+                                                           FieldCursor& cursor) const {
+    return abs(GetMagneticField(pos, cursor).Perp(dir));
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the effective photon mass in eV for the given position `pos` and energy `en`, or -1 if
+/// the position is outside any volume.
+///
+Double_t TRestAxionFieldEvaluator::GetPhotonMass(const TVector3& pos, Double_t en) const {
+    return GetPhotonMass(GetVolumeIndex(pos), en);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the effective photon mass in eV at the volume `id` and energy `en`, or -1 if the id is
+/// not valid.
+///
+Double_t TRestAxionFieldEvaluator::GetPhotonMass(Int_t id, Double_t en) const {
+    if (id < 0 || id >= GetNumberOfVolumes()) return -1;
+    return fVolumes[id].gas->GetPhotonMass(en);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the photon absorption length in cm-1 for the given position `pos` and energy `en`, or
+/// -1 if the position is outside any volume.
+///
+Double_t TRestAxionFieldEvaluator::GetPhotonAbsorptionLength(const TVector3& pos, Double_t en) const {
+    return GetPhotonAbsorptionLength(GetVolumeIndex(pos), en);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the photon absorption length in cm-1 at the volume `id` and energy `en`, or -1 if the
+/// id is not valid.
+///
+Double_t TRestAxionFieldEvaluator::GetPhotonAbsorptionLength(Int_t id, Double_t en) const {
+    if (id < 0 || id >= GetNumberOfVolumes()) return -1;
+    return fVolumes[id].gas->GetPhotonAbsorptionLength(en);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the integrals of the magnetic field along the straight segment between `from` and
+/// `to`, as TRestAxionMagneticField::GetFieldIntegral.
+///
+FieldLineIntegral TRestAxionFieldEvaluator::GetFieldIntegral(const TVector3& from, const TVector3& to) const {
+    return GetFieldIntegrals({from, to})[0];
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the field integrals for each of the consecutive subsegments defined by the points in
+/// `path`, as TRestAxionMagneticField::GetFieldIntegrals.
+///
+std::vector<FieldLineIntegral> TRestAxionFieldEvaluator::GetFieldIntegrals(
+    const std::vector<TVector3>& path) const {
+    std::vector<FieldLineIntegral> integrals(path.size() > 1 ? path.size() - 1 : 0);
+    if (integrals.empty() || path.back() == path.front()) return integrals;
+
+    TVector3 from = path.front();
+    TVector3 dir = (path.back() - from).Unit();
+
+    // The position of each point along the line
+    std::vector<Double_t> t(path.size());
+    for (unsigned int n = 0; n < path.size(); n++) t[n] = (path[n] - from) * dir;
+
+    for (const auto& id : GetVolumesAlongRay(from, dir)) {
+        const Volume& vol = fVolumes[id];
+        Double_t tIn, tOut;
+        if (!GetLineCrossing(vol, from, dir, tIn, tOut)) continue;
+
+        for (unsigned int n = 0; n < integrals.size(); n++) {
+            Double_t t0 = max(tIn, t[n]);
+            Double_t t1 = min(tOut, t[n + 1]);
+            if (t1 <= t0) continue;
+
+            if (!vol.model.IsEmpty())
+                vol.model.Integrate(from + t0 * dir, from + t1 * dir, vol.constantField, integrals[n]);
+            else if (vol.field.IsEmpty())
+                integrals[n].Add(vol.constantField, dir, t1 - t0);
+            else
+                vol.field.Integrate(from + t0 * dir, from + t1 * dir, vol.constantField, integrals[n]);
+        }
+    }
+
+    for (unsigned int n = 0; n < integrals.size(); n++) {
+        // The parts of the subsegment outside any volume have no field
+        Double_t length = max(t[n + 1] - t[n], 0.);
+        if (length - integrals[n].length > 1.e-6) integrals[n].Add(TVector3(0, 0, 0), dir, 0);
+        integrals[n].length = length;
+    }
+
+    return integrals;
+}
@@ -0,0 +1,2413 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldGrid is the storage engine used by TRestAxionMagneticField
+/// to keep the field map of each magnetic volume in memory.
+///
+/// The field vectors of all the nodes in a regular grid are stored in a
+/// single memory block of plain Double_t values, aligned to a cache line.
+/// The three components (Bx,By,Bz) of one node are consecutive, and the
+/// position of a node inside the block is given by explicit strides along
+/// each axis, with z being the fastest running index. The 8 nodes required
+/// by a trilinear interpolation are therefore found in at most 4 contiguous
+/// memory segments, and no pointer indirection is needed to reach them.
+///
+/// The grid geometry is fully defined by the number of nodes, the absolute
+/// position of the first node and the node spacing along each axis. The
+/// grid does not know about volume boundaries, it is the responsibility of
+/// the caller (i.e. TRestAxionMagneticField) to decide if a position should
+/// be evaluated.
+///
+/// The data block is reference counted. Copying a grid does not duplicate
+/// the field data, both copies will point to the same memory block.
+///
+/// Positions evaluated one after the other along a ray usually fall inside
+/// the same cell. A FieldCellCache given to TRestAxionFieldGrid::Interpolate
+/// keeps the 8 nodes of the last cell, converted to double precision, and
+/// they are only read again when a position reaches a different cell. This
+/// is specially useful for tiled grids, where reading a node requires to
+/// find its tile.
+///
+/// TRestAxionFieldGrid::InterpolateGradient gives, together with the field,
+/// its derivatives along the three axes, obtained from the same nodes as the
+/// derivatives of the interpolation.
+///
+/// ### Cylindrical grids
+///
+/// After calling TRestAxionFieldGrid::SetCylindrical the three grid axes
+/// are interpreted as the cylindrical coordinates (r, phi, z), with respect
+/// to an axis parallel to z, and the components stored at each node are
+/// (Br, Bphi, Bz). The angle phi is given in radians. A grid with a single
+/// node along phi describes an axially symmetric field, and only the (r, z)
+/// plane is stored. Otherwise, the phi nodes must cover a full turn, with
+/// the last node placed at 2 pi from the first one and repeating its value.
+///
+/// The position is transformed to (r, phi, z) before the interpolation, and
+/// the interpolated components are rotated back to (Bx, By, Bz). The
+/// multi-point interpolation of a cylindrical grid is done point by point,
+/// without vector instructions.
+///
+/// ### Mirror symmetries
+///
+/// A field map symmetric with respect to the planes normal to the axes can
+/// be stored using only the nodes at one side of the planes, reducing the
+/// memory by a factor 2 for each plane. TRestAxionFieldGrid::SetSymmetry
+/// removes the redundant nodes from a full grid. The mirror plane is placed
+/// at the first stored node, and positions below it are reflected before
+/// the interpolation.
+///
+/// When a position is reflected in the plane normal to one axis, the sign of
+/// the field component along that axis is changed (e.g. Bz(x,y,-z) =
+/// -Bz(x,y,z)), following the convention used to produce the BabyIAXO field
+/// maps (see scripts/xlsToBin.py). If the flag kTangential is given for that
+/// axis, the normal component is kept and the two other components change
+/// sign instead. For instance, the field of a dipole magnet oriented along y
+/// is described using the flags `kMirrorX | kMirrorY | kTangentialY | kMirrorZ`.
+///
+/// ### Storage precision
+///
+/// The field maps are usually produced by finite element solvers providing
+/// only 4 or 5 significant digits, and double precision storage is not
+/// required to reproduce them. TRestAxionFieldGrid::SetPrecision converts
+/// the data block of a grid to one of the following types.
+///
+/// - kDoublePrecision : 8 bytes per component, the default.
+/// - kFloatPrecision : 4 bytes per component, with a relative error below
+/// 6e-8.
+/// - kInt16Precision : 2 bytes per component. The components are stored as
+/// integers multiplied by a common scale factor, chosen so that the largest
+/// component of the map is represented by 32767. The absolute error is
+/// below half the scale factor.
+///
+/// The values are converted back to Double_t inside the interpolation
+/// kernels, and the interpolation is done in double precision. The maximum
+/// error introduced by the conversion is given by
+/// TRestAxionFieldGrid::GetQuantizationError.
+///
+/// ### Blocked layout
+///
+/// By default the nodes are stored in a single array, with z being the
+/// fastest running index (kLinearLayout). Two nodes that are neighbours
+/// along x are then separated by a full (y, z) plane of the map, and a ray
+/// that is not parallel to z reaches distant memory regions at every step.
+/// TRestAxionFieldGrid::SetLayout reorders the data block in blocks of
+/// kBlockNodes nodes along each axis (kBlockedLayout). The blocks are
+/// stored one after the other, and the nodes of each block are ordered as
+/// in a small grid. The 8 nodes of a cell are then found, in most cases,
+/// inside a single block of 1.5 kB (in double precision), and consecutive
+/// positions along a ray stay in a few blocks whatever its direction. The
+/// number of nodes along each axis is rounded up to a multiple of
+/// kBlockNodes, and the extra nodes are zero.
+///
+/// For both layouts, the position of a node inside the data block is the
+/// sum of one contribution for each axis, given by
+/// TRestAxionFieldGrid::GetAxisOffset. The native grid files are always
+/// written using the linear layout, and the multi-point interpolation of
+/// a blocked grid is done point by point.
+///
+/// ### Tricubic interpolation
+///
+/// The trilinear interpolation is exact only for fields that vary linearly
+/// between the nodes, and its error decreases as the square of the node
+/// spacing. TRestAxionFieldGrid::BuildTricubic computes the derivatives of
+/// the field at each node by finite differences, and the field inside each
+/// cell is then described by a polynomial of third degree along each axis
+/// that reproduces the field and its derivatives at the 8 nodes of the cell.
+/// The interpolated field and its first derivatives are continuous across
+/// the cells, and the error decreases as the third power of the node
+/// spacing, so that a coarser field map gives the same accuracy.
+///
+/// The field and its 7 derivatives are kept in double precision, taking 8
+/// times the memory of the field values. A map with twice the spacing along
+/// each axis then needs the same memory as the original map with trilinear
+/// interpolation. The tool at pipeline/magneticField/tricubic compares the
+/// accuracy of both interpolations for different node spacings. The
+/// tricubic interpolation requires the full map, and it cannot be used with
+/// tiled grids. The multi-point interpolation is then done point by point.
+///
+/// ### Multipole expansion of the bore
+///
+/// Inside the bore of a long dipole magnet the field varies slowly, and at
+/// each position along z it is well described by a few terms of the 2D
+/// multipole expansion. TRestAxionFieldGrid::BuildMultipoles fits, at each
+/// slice of nodes along z, the expansion
+///
+/// \f[
+/// B_y + i B_x = \sum_{n=0}^{N-1} (b_n + i a_n) \zeta^n, \qquad
+/// B_z = {\rm Re} \sum_{n=0}^{N-1} (e_n + i f_n) \zeta^n, \qquad
+/// \zeta = \frac{(x - x_0) + i (y - y_0)}{R}
+/// \f]
+///
+/// to the nodes found inside a circle of radius R around the bore axis, at
+/// the center of the map. Positions inside the bore are then evaluated as a
+/// short complex polynomial, with the coefficients interpolated linearly
+/// between the two closest slices, and the nodes of the grid are not read.
+/// The grid is still used outside the bore, and at the slices where the fit
+/// does not reproduce the nodes within the requested tolerance (e.g. the
+/// fringe field at the magnet ends). The coefficients take 4 N values for
+/// each slice, instead of 3 values for each node of the slice.
+///
+/// ### Adaptive resolution
+///
+/// The field maps of the magnets are mostly smooth, and the fine node
+/// spacing required close to the coils, or at the magnet ends, is not
+/// required elsewhere. TRestAxionFieldGrid::SetAdaptive replaces the data
+/// block by a TRestAxionFieldBricks, that divides the grid in bricks of 16
+/// cells along each axis, and only keeps one of every 2, 4, 8 or 16 nodes
+/// along each axis of a brick when the field at the other nodes is then
+/// reproduced within a given tolerance by trilinear interpolation. The
+/// grid geometry and the interpolation between nodes do not change, and
+/// the interpolated field differs from the original one by less than the
+/// tolerance everywhere.
+///
+/// The nodes of an adaptive grid are obtained from the bricks when a cell
+/// is read, and the interpolation is done as with a cell cache. Inside a
+/// coarse cell, between stored nodes, the field is a single trilinear
+/// function, and TRestAxionFieldGrid::Integrate integrates each coarse cell
+/// crossed by the segment at once, instead of each grid cell. The field is
+/// stored in double precision, the layout and precision of the original
+/// grid are not kept, and the adaptive grid cannot be written to a file.
+/// The multi-point interpolation of an adaptive grid is done point by
+/// point.
+///
+/// ### The native grid file format
+///
+/// A grid can be saved to disk using TRestAxionFieldGrid::WriteFile, and it
+/// can be recovered later on using TRestAxionFieldGrid::MapFile. The file
+/// (with extension `.grid` by convention) contains a header of 128 bytes
+/// followed by the data block, exactly as it is stored in memory.
+///
+/// | Offset | Type        | Content                                           |
+/// |--------|-------------|---------------------------------------------------|
+/// | 0      | char[8]     | The identifier `RAXNGRID`                         |
+/// | 8      | UInt_t      | The format version                                |
+/// | 12     | UInt_t      | The value 0x01020304, to validate the byte order  |
+/// | 16     | UInt_t      | The offset of the data block in bytes (128)       |
+/// | 20     | UInt_t      | The symmetry flags, as given by GetSymmetry       |
+/// | 24     | Int_t[3]    | The number of nodes along x, y and z              |
+/// | 36     | UInt_t      | The number of field components per node (3)       |
+/// | 40     | Double_t[3] | The position of the first node in mm              |
+/// | 64     | Double_t[3] | The node spacing along x, y and z in mm           |
+/// | 88     | UInt_t      | The grid coordinates (0=cartesian, 1=cylindrical) |
+/// | 92     | UInt_t      | The storage precision, as given by GetPrecision   |
+/// | 96     | Double_t[2] | The (x, y) position of the cylinder axis in mm    |
+/// | 112    | Double_t    | The scale factor of the stored values             |
+/// | 120    | Double_t    | The maximum quantization error in T               |
+///
+/// For cylindrical grids the first and second axes are r and phi, with phi
+/// given in radians.
+///
+/// The file is not read, it is mapped into memory and the mapped pages are
+/// used directly as the data block of the grid. The operating system will
+/// only load the pages that are actually accessed, and the pages are shared
+/// among all the processes using the same file in a computing node. The data
+/// block of a mapped grid is read-only, TRestAxionFieldGrid::SetNode must
+/// not be used on it.
+///
+/// ### Tiled grid files
+///
+/// Field maps too large to be kept in memory can be written as tiled files,
+/// giving the number of cells per tile to TRestAxionFieldGrid::WriteFile
+/// (with extension `.tgrid` by convention). The grid is split into bricks of
+/// nodes, the tiles, stored one after the other. Consecutive tiles share the
+/// nodes at their common face, so that each cell is fully contained in a
+/// single tile. The file starts with the identifier `RAXNTILE`, instead of
+/// `RAXNGRID`, followed by the same header, and a second header of 64 bytes.
+///
+/// | Offset | Type        | Content                                           |
+/// |--------|-------------|---------------------------------------------------|
+/// | 128    | Int_t       | The number of cells along each axis of a tile     |
+/// | 132    | Int_t[3]    | The number of nodes of a tile along x, y and z    |
+/// | 144    | Int_t[3]    | The number of tiles along x, y and z              |
+///
+/// The tiles start at the data offset (192). The nodes of a tile are stored
+/// as in the data block of a grid with the tile dimensions, and the nodes of
+/// the last tiles that are beyond the grid are zero.
+///
+/// TRestAxionFieldGrid::MapFile recognizes tiled files. Instead of mapping
+/// the file, the tiles are read when a position inside them is evaluated,
+/// and kept in memory by TRestAxionFieldTileCache up to a given memory
+/// limit. The least recently used tiles are released first. Since the
+/// evaluations along a ray only visit the tiles around it, the memory used
+/// is much lower than the size of the map. The multi-point interpolation of
+/// a tiled grid is done point by point.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: Flat contiguous storage replacing the nested std::vector
+///               of TVector3 used by MagneticFieldVolume.
+///               Javier Galan
+///
+/// 2026-October: Native grid file format, memory mapped on load.
+///               Javier Galan
+///
+/// 2026-October: Mirror symmetries, storing only one octant of the map.
+///               Javier Galan
+///
+/// 2026-October: Cylindrical grids, for axially symmetric magnets.
+///               Javier Galan
+///
+/// 2026-October: Reduced storage precision (float and scaled 16-bit integers).
+///               Javier Galan
+///
+/// 2026-October: Tiled grid files, read on demand with a bounded tile cache.
+///               Javier Galan
+///
+/// 2026-October: Exact line integrals using a cell by cell traversal.
+///               Javier Galan
+///
+/// 2026-October: Occupancy of the grid cells, to skip the regions without field.
+///               Javier Galan
+///
+/// 2026-October: Integrals along z, for segments parallel to the magnet axis.
+///               Javier Galan
+///
+/// 2026-October: Blocked layout of the data block.
+///               Javier Galan
+///
+/// 2026-October: Cache of the cell nodes for consecutive interpolations.
+///               Javier Galan
+///
+/// 2026-October: Tricubic interpolation using the derivatives at the nodes.
+///               Javier Galan
+///
+/// 2026-October: Field gradient obtained from the nodes of the interpolation.
+///               Javier Galan
+///
+/// 2026-October: Multipole expansion of the field inside the bore.
+///               Javier Galan
+///
+/// 2026-October: Adaptive resolution storage of the field map.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldGrid
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldGrid.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "TRestAxionFieldBricks.h"
+#include "TRestAxionFieldTileCache.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+/// The header of the native grid file format
+struct GridFileHeader {
+    char magic[8];
+    UInt_t version;
+    UInt_t byteOrder;
+    UInt_t dataOffset;
+    UInt_t symmetry;
+    Int_t nodes[3];
+    UInt_t components;
+    Double_t origin[3];
+    Double_t spacing[3];
+    UInt_t coordinates;
+    UInt_t precision;
+    Double_t axis[2];
+    Double_t scale;
+    Double_t quantizationError;
+};
+
+static_assert(sizeof(GridFileHeader) == 128, "The grid file header must have a size of 128 bytes");
+
+/// The tile geometry, written after the header of a tiled grid file
+struct TileFileHeader {
+    Int_t tileCells;
+    Int_t tileNodes[3];
+    Int_t tileCount[3];
+    char reserved[36];
+};
+
+static_assert(sizeof(TileFileHeader) == 64, "The tile file header must have a size of 64 bytes");
+
+/// All the symmetry flags known by this version
+const UInt_t kSymmetryMask = (1 << 6) - 1;
+
+/// The identifier found at the beginning of every native grid file
+const char kFileMagic[8] = {'R', 'A', 'X', 'N', 'G', 'R', 'I', 'D'};
+
+/// The identifier found at the beginning of every tiled grid file
+const char kTileFileMagic[8] = {'R', 'A', 'X', 'N', 'T', 'I', 'L', 'E'};
+
+/// The value used to check that the file was written with the same byte order
+const UInt_t kFileByteOrder = 0x01020304;
+
+/// It finds the number of nodes along each axis of a tile containing `tileCells` cells, and the number
+/// of tiles required to cover a grid with the given number of `nodes`
+void GetTileGeometry(const Int_t* nodes, Int_t tileCells, Int_t* tileNodes, Int_t* tileCount) {
+    for (int n = 0; n < 3; n++) {
+        Int_t cells = min(max(tileCells, 1), max(nodes[n] - 1, 0));
+        tileNodes[n] = cells + 1;
+        tileCount[n] = cells > 0 ? (nodes[n] - 2) / cells + 1 : 1;
+    }
+}
+
+/// It returns the size in bytes of a tile with the given number of nodes
+size_t GetTileSize(const Int_t* tileNodes, UInt_t precision) {
+    return (size_t)tileNodes[0] * tileNodes[1] * tileNodes[2] * TRestAxionFieldGrid::kComponents *
+           TRestAxionFieldGrid::GetElementSize(precision);
+}
+
+/// The corners of a cell at both ends of each edge along each axis, with the corner (i, j, k) given by
+/// i + 2 * j + 4 * k. The edges are ordered as the corners along the other two axes
+const Int_t kCellEdges[3][4][2] = {{{0, 1}, {2, 3}, {4, 5}, {6, 7}},
+                                   {{0, 2}, {1, 3}, {4, 6}, {5, 7}},
+                                   {{0, 4}, {1, 5}, {2, 6}, {3, 7}}};
+
+/// A helper structure with the grid parameters required by the vectorized interpolation kernels
+struct GridKernelParameters {
+    const void* data;
+    Double_t scale;
+    Double_t origin[3];
+    Double_t spacing[3];
+    Double_t maxCell[3];
+    Int_t stride[3];
+    Int_t offset[3];
+    Bool_t mirror[3];
+    Bool_t flip[3][3];
+};
+
+/// It writes at `w` the cubic Hermite polynomials at the fraction `t` inside a cell. The polynomial w[b][d]
+/// multiplies the field (d = 0) or its derivative (d = 1) at the node b of the cell
+inline void GetHermiteWeights(Double_t t, Double_t w[2][2]) {
+    Double_t t2 = t * t, t3 = t2 * t;
+    w[0][0] = 2 * t3 - 3 * t2 + 1;
+    w[0][1] = t3 - 2 * t2 + t;
+    w[1][0] = 3 * t2 - 2 * t3;
+    w[1][1] = t3 - t2;
+}
+
+/// It writes at `dw` the derivatives of the cubic Hermite polynomials of GetHermiteWeights
+inline void GetHermiteDerivatives(Double_t t, Double_t dw[2][2]) {
+    Double_t t2 = t * t;
+    dw[0][0] = 6 * t2 - 6 * t;
+    dw[0][1] = 3 * t2 - 4 * t + 1;
+    dw[1][0] = 6 * t - 6 * t2;
+    dw[1][1] = 3 * t2 - 2 * t;
+}
+
+/// It combines the values at both nodes of a cell along one axis, `a` and `b`, and their derivatives placed
+/// `next` positions after them, using the Hermite polynomials `w`
+inline Double_t CombineHermite(const Double_t w[2][2], const Double_t* a, const Double_t* b, Int_t next) {
+    return w[0][0] * a[0] + w[0][1] * a[next] + w[1][0] * b[0] + w[1][1] * b[next];
+}
+
+/// It solves the symmetric linear system `a` x = `b`, of dimension `n`, using Gaussian elimination with
+/// partial pivoting. The solution is written at `b`, and `a` is modified. A small multiple of the largest
+/// diagonal element is added to the diagonal, so that the unknowns not constrained by the system are zero
+void SolveLinearSystem(std::vector<Double_t>& a, std::vector<Double_t>& b, Int_t n) {
+    Double_t diagonal = 0;
+    for (int i = 0; i < n; i++) diagonal = max(diagonal, a[i * n + i]);
+    for (int i = 0; i < n; i++) a[i * n + i] += 1.e-12 * diagonal + 1.e-300;
+
+    for (int c = 0; c < n; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < n; r++)
+            if (fabs(a[r * n + c]) > fabs(a[pivot * n + c])) pivot = r;
+        if (pivot != c) {
+            for (int k = 0; k < n; k++) swap(a[c * n + k], a[pivot * n + k]);
+            swap(b[c], b[pivot]);
+        }
+
+        for (int r = c + 1; r < n; r++) {
+            Double_t f = a[r * n + c] / a[c * n + c];
+            for (int k = c; k < n; k++) a[r * n + k] -= f * a[c * n + k];
+            b[r] -= f * b[c];
+        }
+    }
+
+    for (int r = n - 1; r >= 0; r--) {
+        for (int k = r + 1; k < n; k++) b[r] -= a[r * n + k] * b[k];
+        b[r] /= a[r * n + r];
+    }
+}
+
+/// It replaces the complex number `p` by `p` * (`zr` + i `zi`) + (`cr` + i `ci`), a step of Horner's rule
+inline void MultiplyAdd(Double_t* p, Double_t zr, Double_t zi, Double_t cr, Double_t ci) {
+    Double_t re = p[0] * zr - p[1] * zi + cr;
+    p[1] = p[0] * zi + p[1] * zr + ci;
+    p[0] = re;
+}
+
+/// It evaluates the tricubic polynomial of a cell. The field and its derivatives at the first node of the
+/// cell are placed at `d`, and the next nodes along each axis at the distances `s`. The values at each
+/// node are ordered by derivative, with the bits x = 1, y = 2 and z = 4, and then by component. The
+/// Hermite polynomials along each axis are given at `w`. If `dw` is not null, it contains their
+/// derivatives, and the derivatives of the field with respect to the fractions inside the cell are
+/// written at `gradient`, with the derivative of the component c along the axis n at 3 * c + n
+void EvaluateTricubic(const Double_t* d, const size_t* s, const Double_t w[3][2][2],
+                      const Double_t dw[3][2][2], Double_t* field, Double_t* gradient) {
+    const Int_t nc = TRestAxionFieldGrid::kComponents;
+
+    // The polynomials are first combined along z, for the 4 columns of nodes along z, using the
+    // polynomials or their derivatives
+    Double_t column[2][2][2][4 * nc];
+    for (int dz = 0; dz < (dw ? 2 : 1); dz++)
+        for (int bx = 0; bx < 2; bx++)
+            for (int by = 0; by < 2; by++) {
+                const Double_t* v = d + bx * s[0] + by * s[1];
+                for (int m = 0; m < 4 * nc; m++)
+                    column[dz][bx][by][m] = CombineHermite(dz ? dw[2] : w[2], v + m, v + s[2] + m, 4 * nc);
+            }
+
+    // then along y for the 2 rows of nodes along y. The rows are obtained for the field, its derivative
+    // along y and its derivative along z
+    Double_t row[3][2][2 * nc];
+    for (int r = 0; r < (dw ? 3 : 1); r++)
+        for (int bx = 0; bx < 2; bx++) {
+            const Double_t* a = column[r == 2][bx][0];
+            const Double_t* b = column[r == 2][bx][1];
+            for (int m = 0; m < 2 * nc; m++)
+                row[r][bx][m] = CombineHermite(r == 1 ? dw[1] : w[1], a + m, b + m, 2 * nc);
+        }
+
+    // and finally along x
+    for (int c = 0; c < nc; c++) {
+        field[c] = CombineHermite(w[0], row[0][0] + c, row[0][1] + c, nc);
+        if (!dw) continue;
+        gradient[3 * c] = CombineHermite(dw[0], row[0][0] + c, row[0][1] + c, nc);
+        gradient[3 * c + 1] = CombineHermite(w[0], row[1][0] + c, row[1][1] + c, nc);
+        gradient[3 * c + 2] = CombineHermite(w[0], row[2][0] + c, row[2][1] + c, nc);
+    }
+}
+
+/// It returns the trilinear interpolation of the field component stored at `c000`, with the neighbour
+/// nodes at the distances `sx`, `sy` and `sz`, and the fractions `f` inside the cell
+template <typename T>
+inline Double_t Trilinear(const T* c000, size_t sx, size_t sy, size_t sz, const Double_t* f) {
+    // first we interpolate along x-axis
+    Double_t c00 = c000[0] + f[0] * ((Double_t)c000[sx] - c000[0]);
+    Double_t c01 = c000[sz] + f[0] * ((Double_t)c000[sx + sz] - c000[sz]);
+    Double_t c10 = c000[sy] + f[0] * ((Double_t)c000[sx + sy] - c000[sy]);
+    Double_t c11 = c000[sy + sz] + f[0] * ((Double_t)c000[sx + sy + sz] - c000[sy + sz]);
+
+    // then we interpolate along y-axis
+    Double_t c0 = c00 + f[1] * (c10 - c00);
+    Double_t c1 = c01 + f[1] * (c11 - c01);
+
+    // finally we interpolate along z-axis
+    return c0 + f[2] * (c1 - c0);
+}
+
+#if defined(__AVX512F__)
+/// It reads the values at the positions `idx` and converts them to double precision
+inline __m512d Gather512(const Double_t* data, __m512i idx) { return _mm512_i64gather_pd(idx, data, 8); }
+
+/// It reads the values at the positions `idx` and converts them to double precision
+inline __m512d Gather512(const Float_t* data, __m512i idx) {
+    return _mm512_cvtps_pd(_mm512_i64gather_ps(idx, data, 4));
+}
+
+/// It reads the values at the positions `idx` and converts them to double precision. There is no 16-bit
+/// gather, each value is read as the upper half of the 32-bit word ending with it and sign-extended.
+/// The data block must be preceded by, at least, 2 bytes of readable memory
+inline __m512d Gather512(const Short_t* data, __m512i idx) {
+    __m256i words = _mm512_i64gather_epi32(idx, (const char*)data - 2, 2);
+    return _mm512_cvtepi32_pd(_mm256_srai_epi32(words, 16));
+}
+
+/// The sign bit of a double precision value
+const long long kSignBit = (long long)0x8000000000000000ULL;
+
+/// It interpolates the field at 8 consecutive positions using AVX-512 instructions
+template <typename T>
+inline void InterpolateAVX512(const GridKernelParameters& g, const Double_t* x, const Double_t* y,
+                              const Double_t* z, Double_t* bx, Double_t* by, Double_t* bz) {
+    const T* data = (const T*)g.data;
+    const Double_t* pos[3] = {x, y, z};
+    __m512d f[3];
+    __m512i base = _mm512_setzero_si512();
+    __m512i sign[3] = {_mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512()};
+    for (int n = 0; n < 3; n++) {
+        __m512d d = _mm512_sub_pd(_mm512_loadu_pd(pos[n]), _mm512_set1_pd(g.origin[n]));
+        if (g.mirror[n]) {
+            // Positions below the mirror plane are reflected, and the sign bit of some components is flipped
+            __mmask8 below = _mm512_cmp_pd_mask(d, _mm512_setzero_pd(), _CMP_LT_OQ);
+            d = _mm512_abs_pd(d);
+            for (int c = 0; c < 3; c++)
+                if (g.flip[n][c])
+                    sign[c] = _mm512_mask_xor_epi64(sign[c], below, sign[c], _mm512_set1_epi64(kSignBit));
+        }
+        __m512d u = _mm512_div_pd(d, _mm512_set1_pd(g.spacing[n]));
+        __m512d i = _mm512_roundscale_pd(u, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+        i = _mm512_min_pd(_mm512_max_pd(i, _mm512_setzero_pd()), _mm512_set1_pd(g.maxCell[n]));
+        f[n] = _mm512_min_pd(_mm512_max_pd(_mm512_sub_pd(u, i), _mm512_setzero_pd()), _mm512_set1_pd(1.0));
+
+        __m512i i64 = _mm512_cvtepi32_epi64(_mm512_cvttpd_epi32(i));
+        base = _mm512_add_epi64(base, _mm512_mul_epu32(i64, _mm512_set1_epi64(g.stride[n])));
+    }
+
+    Double_t* out[3] = {bx, by, bz};
+    for (int c = 0; c < 3; c++) {
+        __m512i idx = _mm512_add_epi64(base, _mm512_set1_epi64(c));
+        __m512d c000 = Gather512(data, idx);
+        __m512d c100 = Gather512(data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[0])));
+        __m512d c010 = Gather512(data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[1])));
+        __m512d c110 = Gather512(data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[0] + g.offset[1])));
+        __m512d c001 = Gather512(data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[2])));
+        __m512d c101 = Gather512(data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[0] + g.offset[2])));
+        __m512d c011 = Gather512(data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[1] + g.offset[2])));
+        __m512d c111 = Gather512(
+            data, _mm512_add_epi64(idx, _mm512_set1_epi64(g.offset[0] + g.offset[1] + g.offset[2])));
+
+        __m512d c00 = _mm512_fmadd_pd(f[0], _mm512_sub_pd(c100, c000), c000);
+        __m512d c01 = _mm512_fmadd_pd(f[0], _mm512_sub_pd(c101, c001), c001);
+        __m512d c10 = _mm512_fmadd_pd(f[0], _mm512_sub_pd(c110, c010), c010);
+        __m512d c11 = _mm512_fmadd_pd(f[0], _mm512_sub_pd(c111, c011), c011);
+
+        __m512d c0 = _mm512_fmadd_pd(f[1], _mm512_sub_pd(c10, c00), c00);
+        __m512d c1 = _mm512_fmadd_pd(f[1], _mm512_sub_pd(c11, c01), c01);
+
+        __m512d b = _mm512_mul_pd(_mm512_fmadd_pd(f[2], _mm512_sub_pd(c1, c0), c0), _mm512_set1_pd(g.scale));
+        _mm512_storeu_pd(out[c], _mm512_castsi512_pd(_mm512_xor_epi64(_mm512_castpd_si512(b), sign[c])));
+    }
+}
+#endif
+
+#if defined(__AVX2__)
+/// It reads the values at the positions `idx` and converts them to double precision
+inline __m256d Gather256(const Double_t* data, __m256i idx) { return _mm256_i64gather_pd(data, idx, 8); }
+
+/// It reads the values at the positions `idx` and converts them to double precision
+inline __m256d Gather256(const Float_t* data, __m256i idx) {
+    return _mm256_cvtps_pd(_mm256_i64gather_ps(data, idx, 4));
+}
+
+/// It reads the values at the positions `idx` and converts them to double precision, as done by the
+/// AVX-512 version
+inline __m256d Gather256(const Short_t* data, __m256i idx) {
+    __m128i words = _mm256_i64gather_epi32((const int*)((const char*)data - 2), idx, 2);
+    return _mm256_cvtepi32_pd(_mm_srai_epi32(words, 16));
+}
+
+/// It returns a + f * (b - a). The FMA instructions are not part of AVX2, and they are used only when the
+/// library is compiled with support for them
+inline __m256d Lerp256(__m256d f, __m256d a, __m256d b) {
+#if defined(__FMA__)
+    return _mm256_fmadd_pd(f, _mm256_sub_pd(b, a), a);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(f, _mm256_sub_pd(b, a)), a);
+#endif
+}
+
+/// It interpolates the field at 4 consecutive positions using AVX2 instructions
+template <typename T>
+inline void InterpolateAVX2(const GridKernelParameters& g, const Double_t* x, const Double_t* y,
+                            const Double_t* z, Double_t* bx, Double_t* by, Double_t* bz) {
+    const T* data = (const T*)g.data;
+    const Double_t* pos[3] = {x, y, z};
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    __m256d f[3];
+    __m256i base = _mm256_setzero_si256();
+    __m256d sign[3] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+    for (int n = 0; n < 3; n++) {
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(pos[n]), _mm256_set1_pd(g.origin[n]));
+        if (g.mirror[n]) {
+            // Positions below the mirror plane are reflected, and the sign bit of some components is flipped
+            __m256d below = _mm256_and_pd(_mm256_cmp_pd(d, _mm256_setzero_pd(), _CMP_LT_OQ), signBit);
+            d = _mm256_andnot_pd(signBit, d);
+            for (int c = 0; c < 3; c++)
+                if (g.flip[n][c]) sign[c] = _mm256_xor_pd(sign[c], below);
+        }
+        __m256d u = _mm256_div_pd(d, _mm256_set1_pd(g.spacing[n]));
+        __m256d i = _mm256_floor_pd(u);
+        i = _mm256_min_pd(_mm256_max_pd(i, _mm256_setzero_pd()), _mm256_set1_pd(g.maxCell[n]));
+        f[n] = _mm256_min_pd(_mm256_max_pd(_mm256_sub_pd(u, i), _mm256_setzero_pd()), _mm256_set1_pd(1.0));
+
+        __m256i i64 = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(i));
+        base = _mm256_add_epi64(base, _mm256_mul_epu32(i64, _mm256_set1_epi64x(g.stride[n])));
+    }
+
+    Double_t* out[3] = {bx, by, bz};
+    for (int c = 0; c < 3; c++) {
+        __m256i idx = _mm256_add_epi64(base, _mm256_set1_epi64x(c));
+        __m256d c000 = Gather256(data, idx);
+        __m256d c100 = Gather256(data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[0])));
+        __m256d c010 = Gather256(data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[1])));
+        __m256d c110 = Gather256(data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[0] + g.offset[1])));
+        __m256d c001 = Gather256(data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[2])));
+        __m256d c101 = Gather256(data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[0] + g.offset[2])));
+        __m256d c011 = Gather256(data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[1] + g.offset[2])));
+        __m256d c111 = Gather256(
+            data, _mm256_add_epi64(idx, _mm256_set1_epi64x(g.offset[0] + g.offset[1] + g.offset[2])));
+
+        __m256d c00 = Lerp256(f[0], c000, c100);
+        __m256d c01 = Lerp256(f[0], c001, c101);
+        __m256d c10 = Lerp256(f[0], c010, c110);
+        __m256d c11 = Lerp256(f[0], c011, c111);
+
+        __m256d c0 = Lerp256(f[1], c00, c10);
+        __m256d c1 = Lerp256(f[1], c01, c11);
+
+        __m256d b = _mm256_mul_pd(Lerp256(f[2], c0, c1), _mm256_set1_pd(g.scale));
+        _mm256_storeu_pd(out[c], _mm256_xor_pd(b, sign[c]));
+    }
+}
+#endif
+
+/// It interpolates the field at groups of consecutive positions using the widest vector instructions
+/// available, and it returns the number of positions evaluated
+template <typename T>
+inline Int_t InterpolateVector(const GridKernelParameters& g, Int_t n, const Double_t* x, const Double_t* y,
+                               const Double_t* z, Double_t* bx, Double_t* by, Double_t* bz) {
+    Int_t p = 0;
+#if defined(__AVX512F__)
+    for (; p + 8 <= n; p += 8) InterpolateAVX512<T>(g, x + p, y + p, z + p, bx + p, by + p, bz + p);
+#endif
+#if defined(__AVX2__)
+    for (; p + 4 <= n; p += 4) InterpolateAVX2<T>(g, x + p, y + p, z + p, bx + p, by + p, bz + p);
+#endif
+    return p;
+}
+}  // namespace
+
+///////////////////////////////////////////////
+/// \brief It allocates the memory block for a grid with `nx`, `ny` and `nz` nodes.
+///
+/// The `origin` is the absolute position of the node (0,0,0), and `spacing` the distance between
+/// consecutive nodes along each axis. All the field values are initialized to zero.
+///
+void TRestAxionFieldGrid::Allocate(Int_t nx, Int_t ny, Int_t nz, const TVector3& origin,
+                                   const TVector3& spacing) {
+    fNodes[0] = nx;
+    fNodes[1] = ny;
+    fNodes[2] = nz;
+    fSymmetry = 0;
+    fCylindrical = false;
+    fAxis[0] = fAxis[1] = 0;
+    fPrecision = kDoublePrecision;
+    fScale = 1;
+    fQuantizationError = 0;
+    fTileCache.reset();
+    fBricks.reset();
+    fOccupancy.reset();
+    fAxialSums.reset();
+    fTricubic.reset();
+    fMultipoles.reset();
+    SetStrides(kLinearLayout);
+
+    for (int n = 0; n < 3; n++) {
+        fOrigin[n] = origin[n];
+        fSpacing[n] = spacing[n];
+    }
+
+    size_t bytes = GetNumberOfElements() * sizeof(Double_t);
+    void* block = nullptr;
+    if (posix_memalign(&block, kAlignment, bytes) != 0) throw std::bad_alloc();
+    memset(block, 0, bytes);
+
+    fData = std::shared_ptr<void>(block, free);
+}
+
+///////////////////////////////////////////////
+/// \brief It maps the native grid file `filename` into memory and uses it as the data block of this grid.
+///
+/// The `offset` is added to the position of the first node stored in the file, so that a field map
+/// defined in its own reference system can be placed at the absolute position of a volume. It returns
+/// false, leaving the grid unchanged, if the file cannot be mapped or if the header is not valid.
+///
+/// If the file was written using tiles, the file is not mapped. The tiles will be read on demand, and at
+/// most `cacheSize` bytes of tiles will be kept in memory.
+///
+Bool_t TRestAxionFieldGrid::MapFile(const std::string& filename, const TVector3& offset, size_t cacheSize) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "TRestAxionFieldGrid::MapFile. Cannot open file : " << filename << endl;
+        return false;
+    }
+
+    struct stat st;
+    GridFileHeader header;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(GridFileHeader) ||
+        pread(fd, &header, sizeof(GridFileHeader), 0) != sizeof(GridFileHeader)) {
+        cerr << "TRestAxionFieldGrid::MapFile. File too small : " << filename << endl;
+        close(fd);
+        return false;
+    }
+    size_t length = st.st_size;
+
+    Bool_t tiled = memcmp(header.magic, kTileFileMagic, sizeof(kTileFileMagic)) == 0;
+    if ((!tiled && memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0) ||
+        header.byteOrder != kFileByteOrder) {
+        cerr << "TRestAxionFieldGrid::MapFile. Not a grid file, or wrong byte order : " << filename << endl;
+        close(fd);
+        return false;
+    }
+
+    // Version 1 files have no precision, and they are read as double precision grids
+    if (header.version < 1 || header.version > kFileVersion) {
+        cerr << "TRestAxionFieldGrid::MapFile. Grid file version not supported : " << filename << endl;
+        close(fd);
+        return false;
+    }
+    if (header.version < 2) {
+        header.precision = kDoublePrecision;
+        header.scale = 1;
+        header.quantizationError = 0;
+    }
+
+    if (header.components != kComponents || (header.symmetry & ~kSymmetryMask) != 0 ||
+        header.coordinates > 1 || header.precision > kInt16Precision) {
+        cerr << "TRestAxionFieldGrid::MapFile. Grid file version or content not supported : " << filename
+             << endl;
+        close(fd);
+        return false;
+    }
+
+    if (header.nodes[0] < 1 || header.nodes[1] < 1 || header.nodes[2] < 1 ||
+        header.dataOffset % kAlignment != 0) {
+        cerr << "TRestAxionFieldGrid::MapFile. Wrong grid definition : " << filename << endl;
+        close(fd);
+        return false;
+    }
+
+    // A tiled file contains a second header with the tile geometry
+    TileFileHeader tileHeader;
+    memset(&tileHeader, 0, sizeof(TileFileHeader));
+    size_t bytes = (size_t)header.nodes[0] * header.nodes[1] * header.nodes[2] * kComponents *
+                   GetElementSize(header.precision);
+    if (tiled) {
+        Int_t tileNodes[3], tileCount[3];
+        Bool_t ok = pread(fd, &tileHeader, sizeof(TileFileHeader), sizeof(GridFileHeader)) ==
+                    sizeof(TileFileHeader);
+        if (ok) GetTileGeometry(header.nodes, tileHeader.tileCells, tileNodes, tileCount);
+        for (int n = 0; n < 3 && ok; n++)
+            ok = tileHeader.tileNodes[n] == tileNodes[n] && tileHeader.tileCount[n] == tileCount[n];
+        if (!ok) {
+            cerr << "TRestAxionFieldGrid::MapFile. Wrong tile definition : " << filename << endl;
+            close(fd);
+            return false;
+        }
+        bytes = GetTileSize(tileNodes, header.precision) * tileCount[0] * tileCount[1] * tileCount[2];
+    }
+
+    if (length < header.dataOffset + bytes) {
+        cerr << "TRestAxionFieldGrid::MapFile. The file is truncated : " << filename << endl;
+        close(fd);
+        return false;
+    }
+
+    std::shared_ptr<void> data;
+    std::shared_ptr<TRestAxionFieldTileCache> tileCache;
+    if (tiled) {
+        tileCache = std::make_shared<TRestAxionFieldTileCache>();
+        size_t tiles = (size_t)tileHeader.tileCount[0] * tileHeader.tileCount[1] * tileHeader.tileCount[2];
+        if (!tileCache->Open(filename, header.dataOffset, GetTileSize(tileHeader.tileNodes, header.precision),
+                             tiles, cacheSize)) {
+            close(fd);
+            return false;
+        }
+    } else {
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            cerr << "TRestAxionFieldGrid::MapFile. Cannot map file : " << filename << endl;
+            close(fd);
+            return false;
+        }
+
+        // The data block shares the ownership of the mapping, that will be released with the last copy
+        std::shared_ptr<char> mapping((char*)addr, [length](char* p) { munmap(p, length); });
+        data = std::shared_ptr<void>(mapping, mapping.get() + header.dataOffset);
+    }
+    close(fd);
+
+    for (int n = 0; n < 3; n++) {
+        fNodes[n] = header.nodes[n];
+        fOrigin[n] = header.origin[n] + offset[n];
+        fSpacing[n] = header.spacing[n];
+        fTileNodes[n] = tileHeader.tileNodes[n];
+        fTileCount[n] = tileHeader.tileCount[n];
+    }
+    fSymmetry = header.symmetry;
+    fCylindrical = header.coordinates == 1;
+    fAxis[0] = header.axis[0] + (fCylindrical ? offset.X() : 0);
+    fAxis[1] = header.axis[1] + (fCylindrical ? offset.Y() : 0);
+    if (fCylindrical) {
+        fOrigin[0] = header.origin[0];
+        fOrigin[1] = header.origin[1];
+    }
+    fPrecision = header.precision;
+    fScale = header.scale;
+    fQuantizationError = header.quantizationError;
+    SetStrides(kLinearLayout);
+
+    fTileStride[2] = kComponents;
+    fTileStride[1] = fTileStride[2] * fTileNodes[2];
+    fTileStride[0] = fTileStride[1] * fTileNodes[1];
+
+    fData = data;
+    fTileCache = tileCache;
+    fBricks.reset();
+    fOccupancy.reset();
+    fAxialSums.reset();
+    fTricubic.reset();
+    fMultipoles.reset();
+
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It writes the grid to the file `filename` using the native grid file format.
+///
+/// The `offset` is subtracted from the position of the first node, so that the field map can be stored
+/// in its own reference system, e.g. centered at zero. It returns false if the file cannot be written.
+///
+/// If `tileCells` is larger than 0, the grid is written as a tiled file, where each tile contains
+/// `tileCells` cells along each axis. See the class documentation.
+///
+/// The nodes of a grid using the blocked layout are written in the linear order.
+///
+Bool_t TRestAxionFieldGrid::WriteFile(const std::string& filename, const TVector3& offset,
+                                      Int_t tileCells) const {
+    if (IsEmpty() || IsTiled() || IsAdaptive()) return false;
+
+    if (fLayout != kLinearLayout) {
+        TRestAxionFieldGrid linear = *this;
+        return linear.SetLayout(kLinearLayout) && linear.WriteFile(filename, offset, tileCells);
+    }
+
+    GridFileHeader header;
+    memset(&header, 0, sizeof(GridFileHeader));
+    memcpy(header.magic, tileCells > 0 ? kTileFileMagic : kFileMagic, sizeof(kFileMagic));
+    header.version = kFileVersion;
+    header.byteOrder = kFileByteOrder;
+    header.dataOffset = sizeof(GridFileHeader) + (tileCells > 0 ? sizeof(TileFileHeader) : 0);
+    header.symmetry = fSymmetry;
+    header.components = kComponents;
+    for (int n = 0; n < 3; n++) {
+        header.nodes[n] = fNodes[n];
+        header.origin[n] = fOrigin[n] - (fCylindrical && n < 2 ? 0 : offset[n]);
+        header.spacing[n] = fSpacing[n];
+    }
+    header.coordinates = fCylindrical ? 1 : 0;
+    header.axis[0] = fCylindrical ? fAxis[0] - offset.X() : 0;
+    header.axis[1] = fCylindrical ? fAxis[1] - offset.Y() : 0;
+    header.precision = fPrecision;
+    header.scale = fScale;
+    header.quantizationError = fQuantizationError;
+
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        cerr << "TRestAxionFieldGrid::WriteFile. Cannot open file : " << filename << endl;
+        return false;
+    }
+
+    size_t elementSize = GetElementSize(fPrecision);
+    Bool_t ok = fwrite(&header, sizeof(GridFileHeader), 1, file) == 1;
+    if (tileCells <= 0) {
+        size_t elements = GetNumberOfNodes() * kComponents;
+        ok = ok && fwrite(GetData(), elementSize, elements, file) == elements;
+    } else {
+        TileFileHeader tileHeader;
+        memset(&tileHeader, 0, sizeof(TileFileHeader));
+        tileHeader.tileCells = tileCells;
+        GetTileGeometry(fNodes, tileCells, tileHeader.tileNodes, tileHeader.tileCount);
+        ok = ok && fwrite(&tileHeader, sizeof(TileFileHeader), 1, file) == 1;
+
+        const Int_t* tn = tileHeader.tileNodes;
+        std::vector<char> tile(GetTileSize(tn, fPrecision));
+        const char* data = (const char*)GetData();
+        for (Int_t tx = 0; tx < tileHeader.tileCount[0] && ok; tx++)
+            for (Int_t ty = 0; ty < tileHeader.tileCount[1] && ok; ty++)
+                for (Int_t tz = 0; tz < tileHeader.tileCount[2] && ok; tz++) {
+                    // Consecutive tiles share the nodes at their common face. Nodes beyond the grid are zero
+                    memset(tile.data(), 0, tile.size());
+                    char* out = tile.data();
+                    for (Int_t i = tx * (tn[0] - 1); i < tx * (tn[0] - 1) + tn[0]; i++)
+                        for (Int_t j = ty * (tn[1] - 1); j < ty * (tn[1] - 1) + tn[1]; j++) {
+                            Int_t k = tz * (tn[2] - 1);
+                            Int_t count = min(tn[2], fNodes[2] - k);
+                            if (i < fNodes[0] && j < fNodes[1])
+                                memcpy(out, data + GetIndex(i, j, k) * elementSize,
+                                       count * kComponents * elementSize);
+                            out += tn[2] * kComponents * elementSize;
+                        }
+                    ok = fwrite(tile.data(), 1, tile.size(), file) == tile.size();
+                }
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok) cerr << "TRestAxionFieldGrid::WriteFile. Problem writing file : " << filename << endl;
+    return ok;
+}
+
+///////////////////////////////////////////////
+/// \brief It defines the mirror symmetries of the field, removing the nodes that become redundant.
+///
+/// The `symmetry` is a combination of the flags kMirrorX, kMirrorY, kMirrorZ, kTangentialX,
+/// kTangentialY and kTangentialZ. The grid must contain the full field map, with a node at the center of
+/// each mirrored axis, where the mirror plane will be placed. Only the nodes at the center and above it
+/// are kept in a new data block, the original block is not modified.
+///
+/// It returns false, leaving the grid unchanged, if the grid already has symmetries or if the number of
+/// nodes along a mirrored axis is even. Cylindrical grids can only be mirrored along z. The symmetries
+/// must be defined before reducing the precision of the grid, and before changing its layout.
+///
+Bool_t TRestAxionFieldGrid::SetSymmetry(UInt_t symmetry) {
+    if (IsEmpty() || IsTiled() || IsAdaptive() || fSymmetry != 0 || (symmetry & ~kSymmetryMask) != 0)
+        return false;
+    if (fPrecision != kDoublePrecision || fLayout != kLinearLayout) return false;
+    if (fCylindrical && (symmetry & (kMirrorX | kMirrorY)) != 0) return false;
+
+    Int_t first[3], nodes[3];
+    for (int n = 0; n < 3; n++) {
+        Bool_t mirrored = symmetry & (kMirrorX << n);
+        if (mirrored && fNodes[n] % 2 == 0) return false;
+        first[n] = mirrored ? fNodes[n] / 2 : 0;
+        nodes[n] = fNodes[n] - first[n];
+    }
+
+    TRestAxionFieldGrid folded;
+    folded.Allocate(nodes[0], nodes[1], nodes[2],
+                    TVector3(fOrigin[0] + first[0] * fSpacing[0], fOrigin[1] + first[1] * fSpacing[1],
+                             fOrigin[2] + first[2] * fSpacing[2]),
+                    TVector3(fSpacing[0], fSpacing[1], fSpacing[2]));
+
+    // The nodes along z are contiguous in both grids
+    for (Int_t i = 0; i < nodes[0]; i++)
+        for (Int_t j = 0; j < nodes[1]; j++)
+            memcpy((Double_t*)folded.fData.get() + folded.GetIndex(i, j, 0),
+                   GetNode(first[0] + i, first[1] + j, first[2]), nodes[2] * kComponents * sizeof(Double_t));
+
+    Bool_t cylindrical = fCylindrical;
+    Double_t axis[2] = {fAxis[0], fAxis[1]};
+
+    *this = folded;
+    fSymmetry = symmetry;
+    fCylindrical = cylindrical;
+    fAxis[0] = axis[0];
+    fAxis[1] = axis[1];
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It converts the field components to the storage `precision` given by kDoublePrecision,
+/// kFloatPrecision or kInt16Precision.
+///
+/// The converted values are written to a new data block, the original block is not modified. The maximum
+/// absolute difference between the original and the stored components is available afterwards through
+/// TRestAxionFieldGrid::GetQuantizationError.
+///
+/// It returns false, leaving the grid unchanged, if the precision is not valid, if the grid has been
+/// already converted to a different precision, or if the grid is tiled.
+///
+Bool_t TRestAxionFieldGrid::SetPrecision(UInt_t precision) {
+    if (IsEmpty() || precision > kInt16Precision) return false;
+    if (IsTiled() || IsAdaptive()) return precision == fPrecision;
+    if (precision == fPrecision) return true;
+    if (fPrecision != kDoublePrecision) return false;
+
+    size_t elements = GetNumberOfElements();
+    const Double_t* data = (const Double_t*)fData.get();
+
+    // The largest component is represented by the largest 16-bit integer
+    Double_t scale = 1;
+    if (precision == kInt16Precision) {
+        Double_t maxValue = 0;
+        for (size_t i = 0; i < elements; i++) maxValue = max(maxValue, fabs(data[i]));
+        if (maxValue > 0) scale = maxValue / 32767.;
+    }
+
+    // The values start one alignment unit after the allocated block, so that the vectorized kernels can
+    // read the 2 bytes before the first 16-bit value
+    size_t bytes = kAlignment + elements * GetElementSize(precision);
+    void* block = nullptr;
+    if (posix_memalign(&block, kAlignment, bytes) != 0) throw std::bad_alloc();
+    memset(block, 0, kAlignment);
+    std::shared_ptr<char> memory((char*)block, free);
+
+    Double_t error = 0;
+    if (precision == kFloatPrecision) {
+        Float_t* values = (Float_t*)(memory.get() + kAlignment);
+        for (size_t i = 0; i < elements; i++) {
+            values[i] = (Float_t)data[i];
+            error = max(error, fabs(values[i] - data[i]));
+        }
+    } else {
+        Short_t* values = (Short_t*)(memory.get() + kAlignment);
+        for (size_t i = 0; i < elements; i++) {
+            values[i] = (Short_t)lround(data[i] / scale);
+            error = max(error, fabs(values[i] * scale - data[i]));
+        }
+    }
+
+    fData = std::shared_ptr<void>(memory, memory.get() + kAlignment);
+    fPrecision = precision;
+    fScale = scale;
+    fQuantizationError = error;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It reorders the data block following the `layout` given by kLinearLayout or kBlockedLayout.
+///
+/// The reordered values are written to a new data block, the original block is not modified. A grid
+/// mapped from a file is therefore copied to memory. It returns false, leaving the grid unchanged, if the
+/// layout is not valid or if the grid is tiled.
+///
+Bool_t TRestAxionFieldGrid::SetLayout(UInt_t layout) {
+    if (IsEmpty() || IsTiled() || IsAdaptive() || layout > kBlockedLayout) return false;
+    if (layout == fLayout) return true;
+
+    TRestAxionFieldGrid source = *this;
+    SetStrides(layout);
+
+    // As done by SetPrecision, the values start one alignment unit after the allocated block
+    size_t elementSize = GetElementSize(fPrecision);
+    size_t bytes = kAlignment + GetNumberOfElements() * elementSize;
+    void* block = nullptr;
+    if (posix_memalign(&block, kAlignment, bytes) != 0) throw std::bad_alloc();
+    memset(block, 0, bytes);
+    std::shared_ptr<char> memory((char*)block, free);
+
+    char* out = memory.get() + kAlignment;
+    const char* in = (const char*)source.GetData();
+    for (Int_t i = 0; i < fNodes[0]; i++)
+        for (Int_t j = 0; j < fNodes[1]; j++)
+            for (Int_t k = 0; k < fNodes[2]; k++)
+                memcpy(out + GetIndex(i, j, k) * elementSize, in + source.GetIndex(i, j, k) * elementSize,
+                       kComponents * elementSize);
+
+    fData = std::shared_ptr<void>(memory, out);
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It replaces the field data of the grid by a TRestAxionFieldBricks, keeping the field at each
+/// node within `tolerance`, in T, with a resolution adapted to the variations of the field.
+///
+/// The grid is divided in bricks of TRestAxionFieldBricks::kDefaultBrickCells cells along each axis, and
+/// each brick only keeps the coarsest subset of its nodes from which the field at all its nodes is
+/// reproduced by trilinear interpolation within the tolerance. See the class documentation. The original
+/// data block is released by this grid, and a tiled grid is read once and closed. The adaptive grid
+/// uses double precision and the linear layout.
+///
+/// The occupancy, the axial sums, the tricubic derivatives and the multipole expansion are removed, and
+/// they must be built again afterwards if required. It returns false, leaving the grid unchanged, if the
+/// grid is empty.
+///
+Bool_t TRestAxionFieldGrid::SetAdaptive(Double_t tolerance) {
+    if (IsEmpty()) return false;
+
+    auto bricks = std::make_shared<TRestAxionFieldBricks>();
+    if (!bricks->Build(*this, tolerance)) return false;
+
+    fData.reset();
+    fTileCache.reset();
+    fBricks = bricks;
+    fPrecision = kDoublePrecision;
+    fScale = 1;
+    SetStrides(kLinearLayout);
+    fOccupancy.reset();
+    fAxialSums.reset();
+    fTricubic.reset();
+    fMultipoles.reset();
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It defines the strides of the data block for the given `layout`, using the number of nodes of the
+/// grid.
+///
+void TRestAxionFieldGrid::SetStrides(UInt_t layout) {
+    fLayout = layout;
+
+    // Inside a block the nodes are ordered as in a grid with kBlockNodes nodes along each axis
+    Int_t nodes[3];
+    for (int n = 0; n < 3; n++) nodes[n] = layout == kBlockedLayout ? kBlockNodes : fNodes[n];
+
+    fStride[2] = kComponents;
+    fStride[1] = fStride[2] * nodes[2];
+    fStride[0] = fStride[1] * nodes[1];
+
+    for (int n = 0; n < 3; n++) fBlockStride[n] = 0;
+    if (layout != kBlockedLayout) return;
+
+    fBlockStride[2] = fStride[0] * kBlockNodes;
+    fBlockStride[1] = fBlockStride[2] * ((fNodes[2] + kBlockNodes - 1) / kBlockNodes);
+    fBlockStride[0] = fBlockStride[1] * ((fNodes[1] + kBlockNodes - 1) / kBlockNodes);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the number of values stored at the data block, including the extra nodes added by
+/// the blocked layout
+///
+size_t TRestAxionFieldGrid::GetNumberOfElements() const {
+    if (fLayout == kBlockedLayout) return fBlockStride[0] * ((fNodes[0] + kBlockNodes - 1) / kBlockNodes);
+    return GetNumberOfNodes() * kComponents;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the field vector stored at the node (nx,ny,nz), converted to double precision
+///
+TVector3 TRestAxionFieldGrid::GetNodeField(Int_t nx, Int_t ny, Int_t nz) const {
+    if (fBricks) {
+        Int_t node[3] = {nx, ny, nz};
+        Double_t b[kComponents];
+        fBricks->GetNode(node, b);
+        return TVector3(b[0], b[1], b[2]);
+    }
+
+    size_t index = GetIndex(nx, ny, nz);
+    std::shared_ptr<const void> data = fData;
+    if (IsTiled()) {
+        Int_t node[3] = {nx, ny, nz};
+        data = GetTile(node, index);
+    }
+
+    Double_t b[kComponents];
+    for (int c = 0; c < kComponents; c++) {
+        if (fPrecision == kFloatPrecision)
+            b[c] = ((const Float_t*)data.get())[index + c];
+        else if (fPrecision == kInt16Precision)
+            b[c] = ((const Short_t*)data.get())[index + c] * fScale;
+        else
+            b[c] = ((const Double_t*)data.get())[index + c];
+    }
+    return TVector3(b[0], b[1], b[2]);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the tile of a tiled grid containing the `node`, that will be also the bottom, down,
+/// left node of a cell when possible, and it writes at `index` the position of the node inside the tile.
+///
+std::shared_ptr<const void> TRestAxionFieldGrid::GetTile(const Int_t* node, size_t& index) const {
+    size_t id = 0;
+    index = 0;
+    for (int n = 0; n < 3; n++) {
+        Int_t cells = fTileNodes[n] - 1;
+        Int_t t = cells > 0 ? min(node[n] / cells, fTileCount[n] - 1) : 0;
+        id = id * fTileCount[n] + t;
+        index += (node[n] - t * cells) * fTileStride[n];
+    }
+    return fTileCache->GetTile(id);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the memory used by the field data in bytes. For tiled grids, it is the memory used
+/// by the tiles currently kept in memory.
+///
+size_t TRestAxionFieldGrid::GetMemorySize() const {
+    if (IsTiled()) return fTileCache->GetResidentSize();
+    if (IsAdaptive()) return fBricks->GetMemorySize();
+    return IsEmpty() ? 0 : GetNumberOfElements() * GetElementSize(fPrecision);
+}
+
+///////////////////////////////////////////////
+/// \brief It defines the grid axes as the cylindrical coordinates (r, phi, z), with the cylinder axis
+/// parallel to z and placed at (`xAxis`, `yAxis`).
+///
+/// It must be called after TRestAxionFieldGrid::Allocate, that receives the grid origin and spacing in
+/// cylindrical coordinates, (r, phi, z).
+///
+void TRestAxionFieldGrid::SetCylindrical(Double_t xAxis, Double_t yAxis) {
+    fCylindrical = true;
+    fAxis[0] = xAxis;
+    fAxis[1] = yAxis;
+}
+
+///////////////////////////////////////////////
+/// \brief It moves the position `pos` to the stored side of the mirror planes.
+///
+/// The sign changes required by the reflections are multiplied into `sign`, that contains one value for
+/// each field component.
+///
+void TRestAxionFieldGrid::Reflect(Double_t* pos, Double_t* sign) const {
+    for (int n = 0; n < 3; n++) {
+        if (!IsMirrored(n) || pos[n] >= fOrigin[n]) continue;
+
+        pos[n] = 2 * fOrigin[n] - pos[n];
+        Bool_t tangential = fSymmetry & (kTangentialX << n);
+        for (int c = 0; c < kComponents; c++)
+            if ((c == n) != tangential) sign[c] = -sign[c];
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It finds the grid cell containing the position `pos`, given in grid coordinates. For cartesian
+/// grids it is the absolute position.
+///
+/// On return `node` contains the indexes of the bottom, down, left node of the cell, and `frac` the
+/// relative position, between 0 and 1, inside the cell along each axis. Positions outside the grid are
+/// moved to the closest cell. If the grid has a single node along one axis, the fraction will be 0.
+///
+/// Mirror symmetries are not applied, `pos` should be at the stored side of the mirror planes.
+///
+void TRestAxionFieldGrid::GetCell(const Double_t* pos, Int_t* node, Double_t* frac) const {
+    for (int n = 0; n < 3; n++) {
+        if (fNodes[n] < 2) {
+            node[n] = 0;
+            frac[n] = 0;
+            continue;
+        }
+
+        Double_t u = (pos[n] - fOrigin[n]) / fSpacing[n];
+        Int_t i = (Int_t)u;
+        if (u < 0) i = 0;
+        if (i > fNodes[n] - 2) i = fNodes[n] - 2;
+
+        node[n] = i;
+        frac[n] = u - i;
+        if (frac[n] < 0) frac[n] = 0;
+        if (frac[n] > 1) frac[n] = 1;
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the trilinear interpolation of the field at the absolute position `pos`.
+///
+/// The interpolation follows the instructions given at
+/// https://en.wikipedia.org/wiki/Trilinear_interpolation
+///
+void TRestAxionFieldGrid::Interpolate(const Double_t* pos, Double_t* field) const {
+    InterpolateAt(pos, field, nullptr);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the trilinear interpolation of the field at the absolute position `pos`.
+///
+TVector3 TRestAxionFieldGrid::Interpolate(const TVector3& pos) const {
+    Double_t p[3] = {pos.X(), pos.Y(), pos.Z()};
+    Double_t b[3];
+    InterpolateAt(p, b, nullptr);
+    return TVector3(b[0], b[1], b[2]);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the trilinear interpolation of the field at the absolute position `pos`,
+/// reusing the node values kept at `cache` by the previous call if the position is inside the same cell.
+///
+/// The result is equal within rounding to TRestAxionFieldGrid::Interpolate without cache. The 8 nodes of a
+/// cell are only read when a position is found in a different cell, what saves most of the memory accesses
+/// when a ray is sampled in steps shorter than the node spacing. The cache can be used with different grids,
+/// and it is refilled when the grid data changes. It is not shared between threads, each thread must use its
+/// own cache.
+///
+void TRestAxionFieldGrid::Interpolate(const Double_t* pos, Double_t* field, FieldCellCache& cache) const {
+    InterpolateAt(pos, field, &cache);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the trilinear interpolation of the field at the absolute position `pos`, using the
+/// node values kept at `cache` as described at TRestAxionFieldGrid::Interpolate.
+///
+TVector3 TRestAxionFieldGrid::Interpolate(const TVector3& pos, FieldCellCache& cache) const {
+    Double_t p[3] = {pos.X(), pos.Y(), pos.Z()};
+    Double_t b[3];
+    InterpolateAt(p, b, &cache);
+    return TVector3(b[0], b[1], b[2]);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the interpolation of the field at the absolute position `pos`, and at
+/// `gradient` its derivatives, in T/mm, obtained from the same nodes.
+///
+/// The derivative of the component c along the axis n is placed at `gradient[3 * c + n]`, i.e. the gradient
+/// is the 3x3 Jacobian matrix of the field ordered by rows. The field is equal within rounding to the one
+/// given by TRestAxionFieldGrid::Interpolate, and the derivatives are the exact derivatives of the
+/// interpolation. They are constant along each axis inside a cell with the trilinear interpolation, and
+/// continuous with the tricubic interpolation (see TRestAxionFieldGrid::BuildTricubic). The derivatives along
+/// an axis with a single node are zero, and for a cylindrical grid the derivatives along phi are neglected at
+/// the cylinder axis.
+///
+/// The nodes of the cell are read only once, and the cost is about 3 times a single trilinear
+/// interpolation, and less than 2 times a tricubic interpolation, while the gradient obtained by finite
+/// differences would require 6 additional interpolations.
+///
+void TRestAxionFieldGrid::InterpolateGradient(const Double_t* pos, Double_t* field,
+                                              Double_t* gradient) const {
+    InterpolateAt(pos, field, nullptr, gradient);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` and `gradient` the field and its derivatives at the absolute position `pos`,
+/// as described at TRestAxionFieldGrid::InterpolateGradient, reusing the node values kept at `cache` by
+/// the previous call if the position is inside the same cell.
+///
+void TRestAxionFieldGrid::InterpolateGradient(const Double_t* pos, Double_t* field, Double_t* gradient,
+                                              FieldCellCache& cache) const {
+    InterpolateAt(pos, field, &cache, gradient);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the trilinear interpolation of the field at the absolute position `pos`. The
+/// node values are taken from `cache`, if it is not null, as described at TRestAxionFieldGrid::Interpolate.
+/// If `gradient` is not null, the derivatives of the field are written there, as described at
+/// TRestAxionFieldGrid::InterpolateGradient.
+///
+void TRestAxionFieldGrid::InterpolateAt(const Double_t* pos, Double_t* field, FieldCellCache* cache,
+                                        Double_t* gradient) const {
+    // Inside the bore the field is given by the multipole expansion, if it was built
+    if (fMultipoles && InterpolateMultipoles(pos, field, gradient)) return;
+
+    if (!fCylindrical) {
+        InterpolateNodes(pos, field, cache, gradient);
+        return;
+    }
+
+    Double_t dx = pos[0] - fAxis[0];
+    Double_t dy = pos[1] - fAxis[1];
+    Double_t r = sqrt(dx * dx + dy * dy);
+
+    // The angle is only required if the field is not axially symmetric
+    Double_t phi = fOrigin[1];
+    if (fNodes[1] > 1) phi += fmod(atan2(dy, dx) - fOrigin[1] + 4 * M_PI, 2 * M_PI);
+
+    Double_t p[3] = {r, phi, pos[2]};
+    Double_t b[3], g[3 * kComponents];
+    InterpolateNodes(p, b, cache, gradient ? g : nullptr);
+
+    Double_t cosPhi = r > 0 ? dx / r : 1;
+    Double_t sinPhi = r > 0 ? dy / r : 0;
+    field[0] = b[0] * cosPhi - b[1] * sinPhi;
+    field[1] = b[0] * sinPhi + b[1] * cosPhi;
+    field[2] = b[2];
+    if (!gradient) return;
+
+    // The derivatives of (r, phi) along x and y. The derivatives of phi are not defined at the axis, and
+    // they are neglected there
+    Double_t dr[2] = {cosPhi, sinPhi};
+    Double_t dphi[2] = {r > 0 ? -sinPhi / r : 0, r > 0 ? cosPhi / r : 0};
+    for (int n = 0; n < 3; n++) {
+        // The derivatives of (Br, Bphi, Bz) along the axis n. The rotation of (Br, Bphi) to (Bx, By) also
+        // depends on phi
+        Double_t d[kComponents], angle = n < 2 ? dphi[n] : 0;
+        for (int c = 0; c < kComponents; c++)
+            d[c] = n < 2 ? g[3 * c] * dr[n] + g[3 * c + 1] * angle : g[3 * c + 2];
+
+        gradient[n] = d[0] * cosPhi - d[1] * sinPhi - field[1] * angle;
+        gradient[3 + n] = d[0] * sinPhi + d[1] * cosPhi + field[0] * angle;
+        gradient[6 + n] = d[2];
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It transforms the derivatives of the stored components at the position `pos`, given in grid
+/// coordinates, with respect to the fractions inside the cell, into derivatives along the grid axes. The
+/// `sign` of each component, and the reflections of the position, are given by the mirror symmetries.
+///
+void TRestAxionFieldGrid::ScaleGradient(const Double_t* pos, const Double_t* sign, Double_t* gradient) const {
+    for (int n = 0; n < 3; n++) {
+        // A reflected position moves in the opposite direction
+        Double_t factor = fNodes[n] > 1 ? 1 / fSpacing[n] : 0;
+        if (IsMirrored(n) && pos[n] < fOrigin[n]) factor = -factor;
+        for (int c = 0; c < kComponents; c++) gradient[3 * c + n] *= sign[c] * factor;
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the interpolation of the stored components at the position `pos`, given in
+/// grid coordinates, applying the mirror symmetries. If `gradient` is not null, the derivatives of the
+/// components along the grid axes are written there, as described at
+/// TRestAxionFieldGrid::InterpolateGradient.
+///
+void TRestAxionFieldGrid::InterpolateNodes(const Double_t* pos, Double_t* field, FieldCellCache* cache,
+                                           Double_t* gradient) const {
+    Double_t p[3] = {pos[0], pos[1], pos[2]};
+    Double_t sign[3] = {1, 1, 1};
+    if (fSymmetry != 0) Reflect(p, sign);
+
+    Int_t node[3];
+    Double_t f[3];
+    GetCell(p, node, f);
+
+    if (fTricubic) {
+        // The cubic Hermite polynomials along each axis. If the grid has a single node along one axis, only
+        // the field at that node is used
+        Double_t w[3][2][2], dw[3][2][2];
+        size_t s[3] = {(size_t)fNodes[1] * fNodes[2] * kTricubicValues, (size_t)fNodes[2] * kTricubicValues,
+                       kTricubicValues};
+        for (int n = 0; n < 3; n++) {
+            GetHermiteWeights(f[n], w[n]);
+            GetHermiteDerivatives(f[n], dw[n]);
+            if (fNodes[n] < 2) s[n] = 0;
+        }
+
+        const Double_t* d = fTricubic->data() + node[0] * s[0] + node[1] * s[1] + node[2] * s[2];
+        EvaluateTricubic(d, s, w, gradient ? dw : nullptr, field, gradient);
+        for (int c = 0; c < kComponents; c++) field[c] *= sign[c];
+        if (gradient) ScaleGradient(pos, sign, gradient);
+        return;
+    }
+
+    if (cache || gradient || fBricks) {
+        // The gradient, and the nodes of an adaptive grid, are obtained from the nodes of the cell, kept in a
+        // local cache if none is given
+        FieldCellCache local;
+        if (!cache) cache = &local;
+
+        const void* source = fData.get();
+        if (IsTiled()) source = fTileCache.get();
+        if (IsAdaptive()) source = fBricks.get();
+        if (cache->source != source || cache->node[0] != node[0] || cache->node[1] != node[1] ||
+            cache->node[2] != node[2]) {
+            ReadCell(node, *cache);
+            cache->source = source;
+        }
+
+        // The corners are placed as the nodes of a grid with 2 nodes along each axis
+        for (int c = 0; c < kComponents; c++)
+            field[c] = sign[c] * fScale * Trilinear(cache->values + c, 3, 6, 12, f);
+        if (!gradient) return;
+
+        // The derivative along one axis is the difference between the nodes at both ends of the 4 cell
+        // edges along that axis, interpolated along the other two axes
+        for (int n = 0; n < 3; n++) {
+            Double_t u = f[n == 0 ? 1 : 0], v = f[n == 2 ? 1 : 2];
+            for (int c = 0; c < kComponents; c++) {
+                const Double_t* values = cache->values + c;
+                Double_t d[4];
+                for (int e = 0; e < 4; e++)
+                    d[e] = values[3 * kCellEdges[n][e][1]] - values[3 * kCellEdges[n][e][0]];
+                Double_t d0 = d[0] + u * (d[1] - d[0]);
+                Double_t d1 = d[2] + u * (d[3] - d[2]);
+                gradient[3 * c + n] = fScale * (d0 + v * (d1 - d0));
+            }
+        }
+        ScaleGradient(pos, sign, gradient);
+        return;
+    }
+
+    // The position of the cell, and the distance to the next node along each axis. If the grid has a
+    // single node along one axis the next node is the same one
+    size_t index = 0, s[3];
+    const void* data = fData.get();
+
+    // The tile containing the cell is kept in memory until the interpolation is done
+    std::shared_ptr<const void> tile;
+    if (IsTiled()) {
+        tile = GetTile(node, index);
+        data = tile.get();
+        for (int n = 0; n < 3; n++) s[n] = fNodes[n] > 1 ? fTileStride[n] : 0;
+    } else {
+        for (int n = 0; n < 3; n++) {
+            size_t offset = GetAxisOffset(n, node[n]);
+            index += offset;
+            s[n] = fNodes[n] > 1 ? GetAxisOffset(n, node[n] + 1) - offset : 0;
+        }
+    }
+
+    // The stored values are converted to double precision before the interpolation
+    for (int c = 0; c < kComponents; c++) {
+        Double_t b;
+        if (fPrecision == kFloatPrecision)
+            b = Trilinear((const Float_t*)data + index + c, s[0], s[1], s[2], f);
+        else if (fPrecision == kInt16Precision)
+            b = Trilinear((const Short_t*)data + index + c, s[0], s[1], s[2], f);
+        else
+            b = Trilinear((const Double_t*)data + index + c, s[0], s[1], s[2], f);
+
+        field[c] = sign[c] * fScale * b;
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It reads the stored components at the 8 corners of the cell whose bottom, down, left node is
+/// `node`, and writes them at `cache` converted to double precision.
+///
+/// If the grid has a single node along one axis, the corners along that axis are the same node.
+///
+void TRestAxionFieldGrid::ReadCell(const Int_t* node, FieldCellCache& cache) const {
+    for (int n = 0; n < 3; n++) cache.node[n] = node[n];
+    if (fBricks) {
+        fBricks->GetCell(node, cache.values);
+        return;
+    }
+
+    size_t index = 0, s[3];
+    const void* data = fData.get();
+
+    std::shared_ptr<const void> tile;
+    if (IsTiled()) {
+        tile = GetTile(node, index);
+        data = tile.get();
+        for (int n = 0; n < 3; n++) s[n] = fNodes[n] > 1 ? fTileStride[n] : 0;
+    } else {
+        for (int n = 0; n < 3; n++) {
+            size_t offset = GetAxisOffset(n, node[n]);
+            index += offset;
+            s[n] = fNodes[n] > 1 ? GetAxisOffset(n, node[n] + 1) - offset : 0;
+        }
+    }
+
+    for (int corner = 0; corner < 8; corner++) {
+        size_t at = index + (corner & 1) * s[0] + ((corner >> 1) & 1) * s[1] + (corner >> 2) * s[2];
+        for (int c = 0; c < kComponents; c++) {
+            Double_t& value = cache.values[kComponents * corner + c];
+            if (fPrecision == kFloatPrecision)
+                value = ((const Float_t*)data)[at + c];
+            else if (fPrecision == kInt16Precision)
+                value = ((const Short_t*)data)[at + c];
+            else
+                value = ((const Double_t*)data)[at + c];
+        }
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It evaluates the trilinear interpolation at `n` absolute positions given as separate arrays of
+/// coordinates, `x`, `y` and `z`, and writes the field components at `bx`, `by` and `bz`.
+///
+/// Groups of consecutive positions are evaluated in parallel using AVX-512 or AVX2 instructions when the
+/// library has been compiled with support for them (e.g. using `-march=native`). The remaining positions
+/// are evaluated one by one. The vectorized and scalar kernels agree up to floating point rounding.
+///
+void TRestAxionFieldGrid::Interpolate(Int_t n, const Double_t* x, const Double_t* y, const Double_t* z,
+                                      Double_t* bx, Double_t* by, Double_t* bz) const {
+    Int_t p = 0;
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+    GridKernelParameters g;
+    g.data = fData.get();
+    g.scale = fScale;
+    for (int k = 0; k < 3; k++) {
+        g.origin[k] = fOrigin[k];
+        // A single node along one axis is described with an infinite spacing, so that the fraction is 0
+        g.spacing[k] = fNodes[k] > 1 ? fSpacing[k] : HUGE_VAL;
+        g.maxCell[k] = fNodes[k] > 1 ? fNodes[k] - 2 : 0;
+        g.stride[k] = (Int_t)fStride[k];
+        g.offset[k] = fNodes[k] > 1 ? (Int_t)fStride[k] : 0;
+        g.mirror[k] = IsMirrored(k);
+        Bool_t tangential = fSymmetry & (kTangentialX << k);
+        for (int c = 0; c < kComponents; c++) g.flip[k][c] = (c == k) != tangential;
+    }
+
+    // The cylindrical, tiled, adaptive, blocked, tricubic and multipole grids are evaluated point by point
+    Bool_t scalar = fCylindrical || IsTiled() || IsAdaptive() || fLayout != kLinearLayout || HasTricubic() ||
+                    HasMultipoles();
+    Int_t nVector = scalar ? 0 : n;
+
+    if (fPrecision == kFloatPrecision)
+        p = InterpolateVector<Float_t>(g, nVector, x, y, z, bx, by, bz);
+    else if (fPrecision == kInt16Precision)
+        p = InterpolateVector<Short_t>(g, nVector, x, y, z, bx, by, bz);
+    else
+        p = InterpolateVector<Double_t>(g, nVector, x, y, z, bx, by, bz);
+#endif
+
+    // Consecutive positions are usually found in the same cell, whose nodes are then read only once
+    FieldCellCache cache;
+    for (; p < n; p++) {
+        Double_t pos[3] = {x[p], y[p], z[p]};
+        Double_t b[3];
+        InterpolateAt(pos, b, &cache);
+        bx[p] = b[0];
+        by[p] = b[1];
+        bz[p] = b[2];
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It adds to `integral` the integrals of the interpolated field, plus a constant `offset` field,
+/// along the straight segment between the absolute positions `from` and `to`.
+///
+/// The segment is walked cell by cell using a 3D-DDA traversal (Amanatides and Woo), finding the
+/// positions where it crosses the planes separating the grid cells, including the planes beyond the grid
+/// and at the reflected side of the mirror planes. Inside each cell the trilinear field is a polynomial
+/// of third degree along the segment, and its integral is calculated using a 4-point Gauss-Legendre
+/// quadrature. The integrals of the field, of its transverse component and of the squared transverse
+/// intensity are exact, and the result does not depend on any integration step. The integral of the
+/// transverse intensity is not a polynomial, and it is approximated by the same quadrature. The minimum
+/// and maximum transverse intensity are the ones found at the quadrature points.
+///
+/// The cells of a cylindrical grid are not crossed along straight lines. In that case the segment is
+/// divided at the planes separating the cells along z, and in pieces not longer than half the radial
+/// node spacing, and the result is only approximated. The same quadrature is used with the tricubic
+/// interpolation, of ninth degree along the segment, and the result is then also an approximation.
+///
+/// For an adaptive grid, the pieces of the segment inside the same coarse cell are joined, since the field
+/// is there a single trilinear function. See TRestAxionFieldGrid::SetAdaptive.
+///
+/// If the axial sums were built, and the segment is parallel to z, the integrals are obtained directly
+/// from them. See TRestAxionFieldGrid::BuildAxialSums.
+///
+void TRestAxionFieldGrid::Integrate(const TVector3& from, const TVector3& to, const TVector3& offset,
+                                    FieldLineIntegral& integral) const {
+    Double_t length = (to - from).Mag();
+    if (length == 0) return;
+    if (IsEmpty()) {
+        integral.Add(offset, (to - from).Unit(), length);
+        return;
+    }
+
+    if (HasAxialSums() && offset == TVector3(0, 0, 0) && IsAxial(from, to)) {
+        IntegrateAxial(from, to, integral);
+        return;
+    }
+
+    TVector3 u = (to - from).Unit();
+
+    // The 4-point Gauss-Legendre nodes and weights in [-1, 1]
+    const Double_t x[4] = {-0.8611363115940526, -0.3399810435848563, 0.3399810435848563, 0.8611363115940526};
+    const Double_t w[4] = {0.3478548451374538, 0.6521451548625461, 0.6521451548625461, 0.3478548451374538};
+
+    // The 4 points of each piece are found inside the same cell, and its nodes are only read once
+    FieldCellCache cache;
+    std::vector<Double_t> t = GetCrossings(from, to);
+    if (IsAdaptive() && !fCylindrical && !HasTricubic() && !HasMultipoles())
+        t = GetCoarseCrossings(from, to, t);
+    for (size_t c = 0; c + 1 < t.size(); c++) {
+        Double_t half = (t[c + 1] - t[c]) / 2;
+        for (int n = 0; n < 4; n++) {
+            TVector3 pos = from + (t[c] + half * (1 + x[n])) * u;
+            integral.Add(Interpolate(pos, cache) + offset, u, w[n] * half);
+        }
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the distances, from `from`, where the segment between the absolute positions `from`
+/// and `to` crosses the planes separating the grid cells, including 0 and the segment length.
+///
+/// The crossings are found using a 3D-DDA traversal (Amanatides and Woo) of the infinite lattice of cell
+/// planes, that also contains the planes beyond the grid and at the reflected side of the mirror planes.
+/// For cylindrical grids only the planes along z are used, and the segment is further divided in pieces
+/// not longer than half the radial node spacing.
+///
+std::vector<Double_t> TRestAxionFieldGrid::GetCrossings(const TVector3& from, const TVector3& to) const {
+    Double_t length = (to - from).Mag();
+    std::vector<Double_t> crossings = {0};
+    if (length == 0) return crossings;
+
+    TVector3 u = (to - from).Unit();
+
+    // The next crossing of a cell plane along each axis, and the distance between consecutive crossings
+    Double_t tNext[3], tDelta[3];
+    for (int k = 0; k < 3; k++) {
+        tNext[k] = tDelta[k] = HUGE_VAL;
+        if (fNodes[k] < 2 || u[k] == 0 || (fCylindrical && k < 2)) continue;
+
+        Double_t c = (from[k] - fOrigin[k]) / fSpacing[k];
+        Double_t next = u[k] > 0 ? floor(c) + 1 : ceil(c) - 1;
+        tNext[k] = (fOrigin[k] + next * fSpacing[k] - from[k]) / u[k];
+        tDelta[k] = fSpacing[k] / fabs(u[k]);
+    }
+
+    // The cylindrical cells are approximated by pieces of fixed length
+    Double_t maxStep = HUGE_VAL;
+    if (fCylindrical && fNodes[0] > 1) maxStep = fSpacing[0] / 2;
+
+    Double_t t = 0;
+    while (t < length) {
+        Double_t t1 = min(min(tNext[0], tNext[1]), min(tNext[2], length));
+        t1 = min(t1, t + maxStep);
+        crossings.push_back(t1);
+
+        for (int k = 0; k < 3; k++)
+            if (tNext[k] <= t1) tNext[k] += tDelta[k];
+        t = t1;
+    }
+    return crossings;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the `crossings`, found by TRestAxionFieldGrid::GetCrossings for the segment between
+/// the absolute positions `from` and `to`, that separate different coarse cells of an adaptive grid.
+///
+/// Consecutive pieces of the segment are joined if their centers are found inside the same coarse cell, at
+/// the same side of the mirror planes and of the grid boundaries.
+///
+std::vector<Double_t> TRestAxionFieldGrid::GetCoarseCrossings(const TVector3& from, const TVector3& to,
+                                                              const std::vector<Double_t>& crossings) const {
+    std::vector<Double_t> coarse = {crossings.front()};
+    TVector3 u = (to - from).Unit();
+
+    size_t previous = 0;
+    for (size_t c = 0; c + 1 < crossings.size(); c++) {
+        TVector3 center = from + 0.5 * (crossings[c] + crossings[c + 1]) * u;
+        Double_t pos[3] = {center.X(), center.Y(), center.Z()};
+        Double_t sign[3] = {1, 1, 1};
+
+        // The reflections, and the positions beyond the grid, are given by 3 bits along each axis
+        size_t sides = 0;
+        for (int n = 0; n < 3; n++)
+            if (IsMirrored(n) && pos[n] < fOrigin[n]) sides |= 1 << (3 * n);
+        if (fSymmetry != 0) Reflect(pos, sign);
+        for (int n = 0; n < 3; n++) {
+            if (pos[n] < fOrigin[n]) sides |= 2 << (3 * n);
+            if (pos[n] > GetUpperBound(n)) sides |= 4 << (3 * n);
+        }
+
+        Int_t node[3];
+        Double_t frac[3];
+        GetCell(pos, node, frac);
+        size_t id = (fBricks->GetCellId(node) << 9) | sides;
+
+        if (c > 0 && id != previous) coarse.push_back(crossings[c]);
+        previous = id;
+    }
+
+    coarse.push_back(crossings.back());
+    return coarse;
+}
+
+/// The occupancy of the grid cells, built on first use and shared by the copies of a grid
+struct FieldOccupancy {
+    /// It makes sure that the occupancy is only computed once, even if several threads request it
+    std::once_flag built;
+
+    /// One bit for each grid cell, set if the field is not zero at any node of the cell
+    std::vector<bool> cells;
+};
+
+///////////////////////////////////////////////
+/// \brief It enables the occupancy of the grid cells, a bit mask marking the cells where the field is not
+/// zero at any of its nodes.
+///
+/// The trilinear interpolation is zero everywhere inside a cell with no field at its nodes, so that the
+/// regions of the map without field can be skipped by TRestAxionFieldGrid::GetOccupiedIntervals. The
+/// mask is not computed here, since it requires reading all the nodes, which would load in memory the
+/// full data of a memory mapped grid file. It is computed the first time it is required by
+/// TRestAxionFieldGrid::GetOccupiedIntervals, and it is shared by the copies of the grid. It must be
+/// enabled again if the field is modified afterwards with TRestAxionFieldGrid::SetNode.
+///
+/// The tricubic interpolation also depends on the nodes of the neighbour cells. If the tricubic
+/// derivatives were built, the cells next to a cell with field are marked too. The occupancy must be
+/// enabled after TRestAxionFieldGrid::BuildTricubic.
+///
+/// Tiled and cylindrical grids have no occupancy, since building it would require reading the full tiled
+/// file, and the cylindrical cells are not crossed along straight lines.
+///
+void TRestAxionFieldGrid::BuildOccupancy() {
+    fOccupancy.reset();
+    if (IsEmpty() || IsTiled() || fCylindrical) return;
+
+    fOccupancy = std::make_shared<FieldOccupancy>();
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the occupancy of the grid cells, computing it if it is the first time it is required.
+/// See TRestAxionFieldGrid::BuildOccupancy.
+///
+const std::vector<bool>& TRestAxionFieldGrid::GetOccupancy() const {
+    std::call_once(fOccupancy->built, [this]() {
+        Int_t cells[3];
+        for (int n = 0; n < 3; n++) cells[n] = max(fNodes[n] - 1, 1);
+
+        std::vector<bool>& occupancy = fOccupancy->cells;
+        occupancy.assign((size_t)cells[0] * cells[1] * cells[2], false);
+        Int_t reach = HasTricubic() ? 1 : 0;
+        for (Int_t i = 0; i < fNodes[0]; i++)
+            for (Int_t j = 0; j < fNodes[1]; j++)
+                for (Int_t k = 0; k < fNodes[2]; k++) {
+                    if (GetNodeField(i, j, k) == TVector3(0, 0, 0)) continue;
+
+                    // A node belongs to the cells at both sides along each axis. The tricubic interpolation
+                    // also uses the derivatives at the nodes, and it reaches one more cell at each side
+                    for (Int_t ci = max(i - 1 - reach, 0); ci <= min(i + reach, cells[0] - 1); ci++)
+                        for (Int_t cj = max(j - 1 - reach, 0); cj <= min(j + reach, cells[1] - 1); cj++)
+                            for (Int_t ck = max(k - 1 - reach, 0); ck <= min(k + reach, cells[2] - 1); ck++)
+                                occupancy[((size_t)ci * cells[1] + cj) * cells[2] + ck] = true;
+                }
+    });
+    return fOccupancy->cells;
+}
+
+///////////////////////////////////////////////
+/// \brief It builds the integrals along z of the field components, of the transverse intensity and of the
+/// squared transverse intensity, for each column of nodes with fixed x and y.
+///
+/// The integrals are cumulated from the first node of each column, so that the integrals along any
+/// segment parallel to z are obtained from the difference of the values at both ends, as in a summed
+/// area table. The field components are linear along z between nodes, and their integrals are exact.
+/// The transverse intensity, sqrt(Bx^2 + By^2), and its square are taken at the nodes and interpolated
+/// linearly, what is only an approximation between nodes.
+///
+/// The sums use kAxialValues Double_t values for each node, i.e. 5/3 of the memory of a double precision
+/// map. The sums are shared by the copies of the grid, and they must be built again if the field is
+/// modified afterwards with TRestAxionFieldGrid::SetNode. Tiled and cylindrical grids have no axial sums.
+///
+void TRestAxionFieldGrid::BuildAxialSums() {
+    fAxialSums.reset();
+    if (IsEmpty() || IsTiled() || fCylindrical) return;
+
+    auto sums = std::make_shared<std::vector<Double_t>>(GetNumberOfNodes() * kAxialValues, 0.);
+    Double_t* s = sums->data();
+    for (Int_t i = 0; i < fNodes[0]; i++)
+        for (Int_t j = 0; j < fNodes[1]; j++) {
+            Double_t previous[kAxialValues], values[kAxialValues];
+            GetAxialValues(i, j, 0, previous);
+            for (Int_t k = 1; k < fNodes[2]; k++) {
+                GetAxialValues(i, j, k, values);
+                for (int c = 0; c < kAxialValues; c++) {
+                    s[kAxialValues + c] = s[c] + 0.5 * fSpacing[2] * (previous[c] + values[c]);
+                    previous[c] = values[c];
+                }
+                s += kAxialValues;
+            }
+            s += kAxialValues;
+        }
+
+    fAxialSums = sums;
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `values` the quantities integrated by TRestAxionFieldGrid::BuildAxialSums at the node
+/// (nx,ny,nz)
+///
+void TRestAxionFieldGrid::GetAxialValues(Int_t nx, Int_t ny, Int_t nz, Double_t* values) const {
+    TVector3 b = GetNodeField(nx, ny, nz);
+    Double_t bt2 = b.X() * b.X() + b.Y() * b.Y();
+    values[0] = b.X();
+    values[1] = b.Y();
+    values[2] = b.Z();
+    values[3] = sqrt(bt2);
+    values[4] = bt2;
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `values` the integrals along the column of nodes (nx,ny), from its first node to
+/// the coordinate `z`, given in grid coordinates. The field outside the grid is the field at the closest
+/// node.
+///
+void TRestAxionFieldGrid::GetColumnIntegral(Int_t nx, Int_t ny, Double_t z, Double_t* values) const {
+    Double_t v0[kAxialValues], v1[kAxialValues];
+    Int_t last = fNodes[2] - 1;
+    Double_t zLast = fOrigin[2] + last * fSpacing[2];
+
+    if (last == 0 || z <= fOrigin[2]) {
+        GetAxialValues(nx, ny, 0, v0);
+        for (int c = 0; c < kAxialValues; c++) values[c] = (z - fOrigin[2]) * v0[c];
+        return;
+    }
+
+    const Double_t* sums = fAxialSums->data() + (size_t)(nx * fNodes[1] + ny) * fNodes[2] * kAxialValues;
+    if (z >= zLast) {
+        GetAxialValues(nx, ny, last, v0);
+        for (int c = 0; c < kAxialValues; c++)
+            values[c] = sums[last * kAxialValues + c] + (z - zLast) * v0[c];
+        return;
+    }
+
+    Double_t u = (z - fOrigin[2]) / fSpacing[2];
+    Int_t k = min((Int_t)u, last - 1);
+    Double_t f = u - k;
+    GetAxialValues(nx, ny, k, v0);
+    GetAxialValues(nx, ny, k + 1, v1);
+    for (int c = 0; c < kAxialValues; c++)
+        values[c] = sums[k * kAxialValues + c] + fSpacing[2] * f * (v0[c] + 0.5 * f * (v1[c] - v0[c]));
+}
+
+///////////////////////////////////////////////
+/// \brief It computes the derivatives of the field at each node required by the tricubic interpolation
+/// proposed by F. Lekien and J. Marsden, Int. J. Numer. Meth. Engng 63 (2005) 455.
+///
+/// Inside each cell, each field component is described by a polynomial of third degree along each axis,
+/// with 64 coefficients. The polynomial reproduces the field and its derivatives, dB/dx, dB/dy, dB/dz,
+/// d2B/dxdy, d2B/dxdz, d2B/dydz and d3B/dxdydz, at the 8 nodes of the cell. With these constraints the
+/// polynomial is the product of the cubic Hermite polynomials along each axis, and it is evaluated
+/// directly from the values at the nodes, without computing its coefficients.
+///
+/// The derivatives are obtained by central finite differences between the neighbour nodes, or by
+/// one-sided differences of the same order at the grid boundaries, so that a quadratic field is
+/// reproduced exactly. The nodes at the reflected side of a mirror plane are used as neighbours. Since
+/// the cells sharing a node use the same values, the interpolated field and its first derivatives are
+/// continuous across the cell faces.
+///
+/// Once the derivatives are computed, they are used by TRestAxionFieldGrid::Interpolate instead of the
+/// trilinear interpolation. The error of the tricubic interpolation of a smooth field decreases as the
+/// third power of the node spacing, instead of the second power, so that a coarser grid gives the same
+/// accuracy. The field and its derivatives take kTricubicValues Double_t values for each node, i.e. 8
+/// times the memory of a double precision map. They are shared by the copies of the grid, and they must
+/// be computed again if the field is modified afterwards with TRestAxionFieldGrid::SetNode. The occupancy
+/// of the cells, if required, must be enabled afterwards.
+///
+/// It returns false if the grid is empty or tiled, since the full map is required.
+///
+Bool_t TRestAxionFieldGrid::BuildTricubic() {
+    fTricubic.reset();
+    if (IsEmpty() || IsTiled()) return false;
+
+    auto derivatives = std::make_shared<std::vector<Double_t>>(GetNumberOfNodes() * kTricubicValues, 0.);
+    Double_t* d = derivatives->data();
+
+    // A node exists if it is inside the grid or at the reflected side of a mirror plane
+    auto exists = [this](int n, Int_t node) {
+        return (node >= 0 || IsMirrored(n)) && abs(node) < fNodes[n];
+    };
+
+    const Int_t none = 0;
+    const Double_t one = 1;
+    for (Int_t i = 0; i < fNodes[0]; i++)
+        for (Int_t j = 0; j < fNodes[1]; j++)
+            for (Int_t k = 0; k < fNodes[2]; k++) {
+                // The finite difference along each axis, given by the offsets of up to 3 nodes and their
+                // weights. It is zero if the grid has a single node along the axis
+                Int_t node[3] = {i, j, k}, terms[3], offset[3][3];
+                Double_t weight[3][3];
+                for (int n = 0; n < 3; n++) {
+                    Bool_t left = exists(n, node[n] - 1), right = exists(n, node[n] + 1);
+                    if (left && right) {
+                        terms[n] = 2;
+                        offset[n][0] = -1, offset[n][1] = 1;
+                        weight[n][0] = -0.5, weight[n][1] = 0.5;
+                    } else if (right && exists(n, node[n] + 2)) {
+                        terms[n] = 3;
+                        offset[n][0] = 0, offset[n][1] = 1, offset[n][2] = 2;
+                        weight[n][0] = -1.5, weight[n][1] = 2, weight[n][2] = -0.5;
+                    } else if (left && exists(n, node[n] - 2)) {
+                        terms[n] = 3;
+                        offset[n][0] = -2, offset[n][1] = -1, offset[n][2] = 0;
+                        weight[n][0] = 0.5, weight[n][1] = -2, weight[n][2] = 1.5;
+                    } else if (left || right) {
+                        terms[n] = 2;
+                        offset[n][0] = right ? 0 : -1, offset[n][1] = right ? 1 : 0;
+                        weight[n][0] = -1, weight[n][1] = 1;
+                    } else {
+                        terms[n] = 0;
+                    }
+                }
+
+                // The derivative t takes the differences along the axes given by its bits (x = 1, y = 2,
+                // z = 4), and the field at the node along the other axes
+                for (int t = 0; t < 8; t++) {
+                    Int_t count[3];
+                    const Int_t* offsets[3];
+                    const Double_t* weights[3];
+                    for (int n = 0; n < 3; n++) {
+                        Bool_t derived = (t >> n) & 1;
+                        count[n] = derived ? terms[n] : 1;
+                        offsets[n] = derived ? offset[n] : &none;
+                        weights[n] = derived ? weight[n] : &one;
+                    }
+
+                    Double_t* v = d + kComponents * t;
+                    for (int a = 0; a < count[0]; a++)
+                        for (int b = 0; b < count[1]; b++)
+                            for (int c = 0; c < count[2]; c++) {
+                                Int_t neighbour[3] = {i + offsets[0][a], j + offsets[1][b],
+                                                      k + offsets[2][c]};
+                                Double_t w = weights[0][a] * weights[1][b] * weights[2][c];
+                                Double_t field[kComponents];
+                                GetNeighbourField(neighbour, field);
+                                for (int m = 0; m < kComponents; m++) v[m] += w * field[m];
+                            }
+                }
+                d += kTricubicValues;
+            }
+
+    fTricubic = derivatives;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the field vector, in T, at the `node`. Negative indexes along the axes with a
+/// mirror symmetry give the nodes at the reflected side. It returns false if the node does not exist.
+///
+Bool_t TRestAxionFieldGrid::GetNeighbourField(const Int_t* node, Double_t* field) const {
+    Int_t n[3];
+    Double_t sign[kComponents] = {1, 1, 1};
+    for (int k = 0; k < 3; k++) {
+        n[k] = node[k];
+        if (n[k] < 0 && IsMirrored(k)) {
+            n[k] = -n[k];
+            Bool_t tangential = fSymmetry & (kTangentialX << k);
+            for (int c = 0; c < kComponents; c++)
+                if ((c == k) != tangential) sign[c] = -sign[c];
+        }
+        if (n[k] < 0 || n[k] >= fNodes[k]) return false;
+    }
+
+    TVector3 b = GetNodeField(n[0], n[1], n[2]);
+    for (int c = 0; c < kComponents; c++) field[c] = sign[c] * b[c];
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It fits the multipole expansion described at TRestAxionFieldGrid, with `order` terms for each
+/// field component, to the nodes of each slice along z inside a bore of `radius` mm around the center of
+/// the map. If `radius` is 0, the largest circle inside the map is used.
+///
+/// The coefficients of each slice are obtained by a linear least squares fit to the field at the nodes
+/// inside the bore, including the nodes at the reflected side of the mirror planes. A slice is valid if
+/// the largest difference between the expansion and any field component at those nodes is below
+/// `tolerance`, in T. The positions inside the bore and between two consecutive valid slices are then
+/// evaluated using the expansion, and the grid is used elsewhere.
+///
+/// The expansion is shared by the copies of the grid, and it must be built again if the field is modified
+/// afterwards with TRestAxionFieldGrid::SetNode. It returns false if the grid is empty or cylindrical, if
+/// the bore contains less than 2 `order` nodes at each slice, or if no slice is valid.
+///
+Bool_t TRestAxionFieldGrid::BuildMultipoles(Int_t order, Double_t radius, Double_t tolerance) {
+    fMultipoles.reset();
+    if (IsEmpty() || fCylindrical || order < 1) return false;
+
+    // The nodes covered by the map along each axis, including the reflected side of the mirror planes
+    Int_t nodes[3];
+    Double_t lower[3];
+    for (int n = 0; n < 3; n++) {
+        nodes[n] = IsMirrored(n) ? 2 * fNodes[n] - 1 : fNodes[n];
+        lower[n] = GetLowerBound(n);
+    }
+
+    // The bore axis is placed at the center of the map
+    Double_t center[2];
+    for (int n = 0; n < 2; n++) center[n] = 0.5 * (lower[n] + GetUpperBound(n));
+    if (radius <= 0) radius = min(GetUpperBound(0) - center[0], GetUpperBound(1) - center[1]);
+    if (radius <= 0) return false;
+
+    auto m = std::make_shared<FieldMultipoles>();
+    m->order = order;
+    m->radius = radius;
+    m->origin[0] = center[0] - fOrigin[0];
+    m->origin[1] = center[1] - fOrigin[1];
+    m->origin[2] = lower[2] - fOrigin[2];
+    m->spacing = fSpacing[2];
+    m->slices = nodes[2];
+
+    // The position (x, y) of the nodes inside the bore, and the powers of zeta, (u, v), at each of them
+    std::vector<Double_t> xy, powers;
+    for (Int_t i = 0; i < nodes[0]; i++)
+        for (Int_t j = 0; j < nodes[1]; j++) {
+            Double_t x = lower[0] + i * fSpacing[0];
+            Double_t y = lower[1] + j * fSpacing[1];
+            Double_t zr = (x - center[0]) / radius, zi = (y - center[1]) / radius;
+            if (zr * zr + zi * zi > 1) continue;
+
+            xy.push_back(x);
+            xy.push_back(y);
+            Double_t p[2] = {1, 0};
+            for (int n = 0; n < order; n++) {
+                powers.push_back(p[0]);
+                powers.push_back(p[1]);
+                MultiplyAdd(p, zr, zi, 0, 0);
+            }
+        }
+
+    size_t samples = xy.size() / 2;
+    if (samples < 2 * (size_t)order) return false;
+
+    // The rows of the fit at each node, for the transverse unknowns (b_n, a_n) and the axial unknowns
+    // (e_n, f_n). By and Bz have the same rows, (u_n, -v_n), and Bx has the rows (v_n, u_n)
+    const Int_t size = 2 * order;
+    auto rowY = [&](size_t s, Int_t c) { return c % 2 ? -powers[s * size + c] : powers[s * size + c]; };
+    auto rowX = [&](size_t s, Int_t c) { return powers[s * size + (c ^ 1)]; };
+
+    // The normal equations are the same for all the slices
+    std::vector<Double_t> transverse(size * size, 0.), axial(size * size, 0.);
+    for (size_t s = 0; s < samples; s++)
+        for (int a = 0; a < size; a++)
+            for (int b = 0; b < size; b++) {
+                transverse[a * size + b] += rowY(s, a) * rowY(s, b) + rowX(s, a) * rowX(s, b);
+                axial[a * size + b] += rowY(s, a) * rowY(s, b);
+            }
+
+    m->coefficients.assign((size_t)m->slices * kMultipoleValues * order, 0.);
+    m->valid.assign(m->slices, false);
+    Bool_t valid = false;
+    FieldCellCache cache;
+    std::vector<Double_t> field(kComponents * samples);
+    for (Int_t k = 0; k < m->slices; k++) {
+        std::vector<Double_t> bt(size, 0.), bz(size, 0.);
+        for (size_t s = 0; s < samples; s++) {
+            Double_t pos[3] = {xy[2 * s], xy[2 * s + 1], lower[2] + k * fSpacing[2]};
+            Double_t* b = &field[kComponents * s];
+            InterpolateAt(pos, b, &cache);
+            for (int c = 0; c < size; c++) {
+                bt[c] += rowY(s, c) * b[1] + rowX(s, c) * b[0];
+                bz[c] += rowY(s, c) * b[2];
+            }
+        }
+
+        std::vector<Double_t> a = transverse;
+        SolveLinearSystem(a, bt, size);
+        a = axial;
+        SolveLinearSystem(a, bz, size);
+
+        Double_t* coefficients = &m->coefficients[(size_t)k * kMultipoleValues * order];
+        for (int n = 0; n < order; n++) {
+            coefficients[kMultipoleValues * n] = bt[2 * n];
+            coefficients[kMultipoleValues * n + 1] = bt[2 * n + 1];
+            coefficients[kMultipoleValues * n + 2] = bz[2 * n];
+            coefficients[kMultipoleValues * n + 3] = bz[2 * n + 1];
+        }
+
+        // The largest difference between the expansion and the field at the nodes of the slice
+        Double_t residual = 0;
+        for (size_t s = 0; s < samples; s++) {
+            Double_t fit[kComponents] = {0, 0, 0};
+            for (int c = 0; c < size; c++) {
+                fit[0] += rowX(s, c) * bt[c];
+                fit[1] += rowY(s, c) * bt[c];
+                fit[2] += rowY(s, c) * bz[c];
+            }
+            for (int c = 0; c < kComponents; c++)
+                residual = max(residual, fabs(fit[c] - field[kComponents * s + c]));
+        }
+
+        if (residual > tolerance) continue;
+        m->valid[k] = true;
+        m->residual = max(m->residual, residual);
+        valid = true;
+    }
+
+    if (!valid) return false;
+    fMultipoles = m;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the multipole expansion of the field at the absolute position `pos`, and at
+/// `gradient`, if it is not null, its derivatives as described at TRestAxionFieldGrid::InterpolateGradient.
+///
+/// It returns false, and nothing is written, if the position is outside the bore or if one of the slices
+/// around it is not valid.
+///
+Bool_t TRestAxionFieldGrid::InterpolateMultipoles(const Double_t* pos, Double_t* field,
+                                                  Double_t* gradient) const {
+    const FieldMultipoles& m = *fMultipoles;
+    Double_t zr = (pos[0] - fOrigin[0] - m.origin[0]) / m.radius;
+    Double_t zi = (pos[1] - fOrigin[1] - m.origin[1]) / m.radius;
+    if (zr * zr + zi * zi > 1) return false;
+
+    Int_t k = 0;
+    Double_t t = 0;
+    if (m.slices > 1) {
+        Double_t u = (pos[2] - fOrigin[2] - m.origin[2]) / m.spacing;
+        if (!(u >= 0 && u <= m.slices - 1)) return false;
+        k = min((Int_t)u, m.slices - 2);
+        t = u - k;
+        if (!m.valid[k + 1]) return false;
+    }
+    if (!m.valid[k]) return false;
+
+    const Int_t size = kMultipoleValues * m.order;
+    const Double_t* a = m.coefficients.data() + (size_t)k * size;
+    const Double_t* b = m.slices > 1 ? a + size : a;
+
+    // The transverse (w) and axial (f) polynomials, their derivatives with respect to zeta (dw, df), and
+    // with respect to the position between both slices (sw, sf), evaluated using Horner's rule
+    Double_t w[2] = {0, 0}, f[2] = {0, 0};
+    Double_t dw[2] = {0, 0}, df[2] = {0, 0}, sw[2] = {0, 0}, sf[2] = {0, 0};
+    for (int n = m.order - 1; n >= 0; n--) {
+        const Double_t* ca = a + kMultipoleValues * n;
+        const Double_t* cb = b + kMultipoleValues * n;
+        if (gradient) {
+            MultiplyAdd(dw, zr, zi, w[0], w[1]);
+            MultiplyAdd(df, zr, zi, f[0], f[1]);
+            MultiplyAdd(sw, zr, zi, cb[0] - ca[0], cb[1] - ca[1]);
+            MultiplyAdd(sf, zr, zi, cb[2] - ca[2], cb[3] - ca[3]);
+        }
+        MultiplyAdd(w, zr, zi, ca[0] + t * (cb[0] - ca[0]), ca[1] + t * (cb[1] - ca[1]));
+        MultiplyAdd(f, zr, zi, ca[2] + t * (cb[2] - ca[2]), ca[3] + t * (cb[3] - ca[3]));
+    }
+
+    field[0] = w[1];
+    field[1] = w[0];
+    field[2] = f[0];
+    if (!gradient) return true;
+
+    // The polynomials are analytic in zeta, and the derivative along y is i times the derivative along x
+    Double_t dr = 1 / m.radius;
+    Double_t dz = m.slices > 1 ? 1 / m.spacing : 0;
+    gradient[0] = dw[1] * dr;
+    gradient[1] = dw[0] * dr;
+    gradient[2] = sw[1] * dz;
+    gradient[3] = dw[0] * dr;
+    gradient[4] = -dw[1] * dr;
+    gradient[5] = sw[0] * dz;
+    gradient[6] = df[0] * dr;
+    gradient[7] = -df[1] * dr;
+    gradient[8] = sf[0] * dz;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns true if the segment between the absolute positions `from` and `to` can be integrated
+/// using the axial sums, i.e. if its displacement along x and y is below the axial tolerance times the node
+/// spacing. The axial sums integrate the trilinear interpolation, and they are not used if the grid is
+/// interpolated with the tricubic polynomials or the multipole expansion.
+///
+/// The segment is integrated as if it was parallel to z at its average x and y. For a displacement `d`
+/// in the xy plane the error of the field integrals is at most `L*G*d/2`, where `L` is the length of the
+/// segment and `G` the largest derivative of the field vector along a direction in the xy plane. The
+/// default tolerance, kAxialTolerance, keeps this error negligible, and it can be increased with
+/// TRestAxionFieldGrid::SetAxialTolerance.
+///
+Bool_t TRestAxionFieldGrid::IsAxial(const TVector3& from, const TVector3& to) const {
+    if (fCylindrical || HasTricubic() || HasMultipoles() || to.Z() == from.Z()) return false;
+    for (int n = 0; n < 2; n++)
+        if (fNodes[n] > 1 && fabs(to[n] - from[n]) > fAxialTolerance * fSpacing[n]) return false;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It adds to `integral` the integrals along a segment parallel to z between the absolute positions
+/// `from` and `to`, using the axial sums.
+///
+/// The integrals of the four columns around the segment are interpolated bilinearly, what is exact for the
+/// field components. The segment is placed at the average x and y of its ends. The minimum and maximum
+/// transverse intensity are set to the average intensity.
+///
+void TRestAxionFieldGrid::IntegrateAxial(const TVector3& from, const TVector3& to,
+                                         FieldLineIntegral& integral) const {
+    TVector3 u = (to - from).Unit();
+
+    // The columns around the segment, after the reflections in x and y
+    Double_t pos[3] = {0.5 * (from.X() + to.X()), 0.5 * (from.Y() + to.Y()), fOrigin[2]};
+    Double_t sign[3] = {1, 1, 1};
+    if (fSymmetry != 0) Reflect(pos, sign);
+
+    Int_t node[3];
+    Double_t frac[3];
+    GetCell(pos, node, frac);
+
+    // The stored side of the segment, and the reflected side if it crosses the mirror plane in z
+    Double_t zLow = min(from.Z(), to.Z());
+    Double_t zHigh = max(from.Z(), to.Z());
+    Double_t pieces[2][2] = {{zLow, zHigh}, {0, 0}};
+    Double_t zSign[3] = {1, 1, 1};
+    Int_t nPieces = 1;
+    if (IsMirrored(2) && zLow < fOrigin[2]) {
+        pieces[0][0] = max(zLow, fOrigin[2]);
+        pieces[0][1] = max(zHigh, fOrigin[2]);
+        pieces[1][0] = 2 * fOrigin[2] - min(zHigh, fOrigin[2]);
+        pieces[1][1] = 2 * fOrigin[2] - zLow;
+        nPieces = 2;
+
+        Bool_t tangential = fSymmetry & kTangentialZ;
+        for (int c = 0; c < kComponents; c++)
+            if ((c == 2) != tangential) zSign[c] = -1;
+    }
+
+    Double_t sum[kAxialValues] = {0, 0, 0, 0, 0};
+    for (int r = 0; r < 4; r++) {
+        Int_t nx = min(node[0] + (r & 1), fNodes[0] - 1);
+        Int_t ny = min(node[1] + (r >> 1), fNodes[1] - 1);
+        Double_t w = ((r & 1) ? frac[0] : 1 - frac[0]) * ((r >> 1) ? frac[1] : 1 - frac[1]);
+        if (w == 0) continue;
+
+        for (int p = 0; p < nPieces; p++) {
+            Double_t v0[kAxialValues], v1[kAxialValues];
+            GetColumnIntegral(nx, ny, pieces[p][0], v0);
+            GetColumnIntegral(nx, ny, pieces[p][1], v1);
+            for (int c = 0; c < kAxialValues; c++) {
+                Double_t s = c < kComponents && p == 1 ? zSign[c] : 1;
+                sum[c] += s * w * (v1[c] - v0[c]);
+            }
+        }
+    }
+
+    // The integrals along z are converted to integrals along the segment
+    Double_t length = (to - from).Mag();
+    Double_t scale = length / (zHigh - zLow);
+
+    TVector3 field = scale * TVector3(sign[0] * sum[0], sign[1] * sum[1], sign[2] * sum[2]);
+    integral.length += length;
+    integral.field += field;
+    integral.transverse += field - (field * u) * u;
+    integral.transverseMag += scale * sum[3];
+    integral.transverseMag2 += scale * sum[4];
+
+    Double_t average = sum[3] / (zHigh - zLow);
+    if (integral.samples == 0 || average < integral.transverseMin) integral.transverseMin = average;
+    if (integral.samples == 0 || average > integral.transverseMax) integral.transverseMax = average;
+    integral.samples++;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the intervals of the segment between the absolute positions `from` and `to` that
+/// cross grid cells with field, given as distances from `from`.
+///
+/// The cells along the segment are found as in TRestAxionFieldGrid::Integrate, and consecutive cells with
+/// field are joined in a single interval. The field is zero outside the returned intervals. If the
+/// occupancy was not enabled, the full segment is returned. The occupancy is computed at the first call.
+///
+std::vector<std::pair<Double_t, Double_t>> TRestAxionFieldGrid::GetOccupiedIntervals(
+    const TVector3& from, const TVector3& to) const {
+    std::vector<std::pair<Double_t, Double_t>> intervals;
+    Double_t length = (to - from).Mag();
+    if (length == 0 || IsEmpty()) return intervals;
+
+    if (!HasOccupancy()) {
+        intervals.push_back({0, length});
+        return intervals;
+    }
+
+    const std::vector<bool>& occupancy = GetOccupancy();
+    Int_t cells[3];
+    for (int n = 0; n < 3; n++) cells[n] = max(fNodes[n] - 1, 1);
+
+    TVector3 u = (to - from).Unit();
+    std::vector<Double_t> t = GetCrossings(from, to);
+    for (size_t c = 0; c + 1 < t.size(); c++) {
+        if (t[c + 1] <= t[c]) continue;
+
+        // The center of the piece is inside a single cell
+        TVector3 center = from + 0.5 * (t[c] + t[c + 1]) * u;
+        Double_t pos[3] = {center.X(), center.Y(), center.Z()};
+        Double_t sign[3] = {1, 1, 1};
+        if (fSymmetry != 0) Reflect(pos, sign);
+
+        Int_t node[3];
+        Double_t frac[3];
+        GetCell(pos, node, frac);
+        if (!occupancy[((size_t)node[0] * cells[1] + node[1]) * cells[2] + node[2]]) continue;
+
+        if (!intervals.empty() && intervals.back().second == t[c])
+            intervals.back().second = t[c + 1];
+        else
+            intervals.push_back({t[c], t[c + 1]});
+    }
+    return intervals;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the name of the vector instruction set used by the multi-point interpolation
+///
+const char* TRestAxionFieldGrid::GetVectorInstructionSet() {
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#else
+    return "none";
+#endif
+}
@@ -0,0 +1,200 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldMapRegistry keeps track of the field maps loaded by all the
+/// TRestAxionMagneticField instances in the process, so that a map referenced
+/// by several volumes, or by several instances, is only loaded once.
+///
+/// The maps are registered using a key built from the resolved path of the
+/// file, its device and inode, its size and its modification time with
+/// nanosecond resolution, obtained with TRestAxionFieldMapRegistry::GetKey. The contents of the file are not
+/// read, so that a memory mapped or tiled grid file is still loaded without
+/// reading it. Modifying the file on disk produces a different key, and the
+/// new contents will be loaded.
+///
+/// The grids are stored in the reference system of the field map, i.e.
+/// before applying the volume position. The volumes receive a copy of the
+/// grid, that shares the field data and can be translated to its own
+/// position using TRestAxionFieldGrid::Translate. The shared field data must
+/// not be modified.
+///
+/// The registry does not own the field data, neither the structures built
+/// from it (the occupancy, the axial sums, the tricubic derivatives and the
+/// multipole expansion), it only keeps weak references. The memory is
+/// released when the last volume using a map is destroyed, and the map will
+/// be loaded again if it is required later on.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the shared field map registry.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldMapRegistry
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldMapRegistry.h"
+
+#include "TRestAxionFieldBricks.h"
+#include "TRestAxionFieldTileCache.h"
+
+#include <sys/stat.h>
+
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+/// A registered field map. The grid keeps the geometry, and the data, the tiles of a tiled grid or the
+/// bricks of an adaptive grid, and the structures built from them are only weakly referenced
+struct RegistryEntry {
+    TRestAxionFieldGrid grid;
+    std::weak_ptr<void> data;
+    std::weak_ptr<TRestAxionFieldTileCache> tiles;
+    std::weak_ptr<const TRestAxionFieldBricks> bricks;
+    std::weak_ptr<FieldOccupancy> occupancy;
+    std::weak_ptr<const std::vector<Double_t>> axialSums;
+    std::weak_ptr<const std::vector<Double_t>> tricubic;
+    std::weak_ptr<const FieldMultipoles> multipoles;
+
+    /// True if the registered grid was interpolated with the tricubic polynomials or the multipole expansion
+    Bool_t hasTricubic = false;
+    Bool_t hasMultipoles = false;
+
+    /// It returns true if the field data is not used anymore
+    Bool_t IsExpired() const { return data.expired() && tiles.expired() && bricks.expired(); }
+};
+
+/// It returns the registered maps, created on first use
+std::map<std::string, RegistryEntry>& GetEntries() {
+    static std::map<std::string, RegistryEntry> entries;
+    return entries;
+}
+
+/// It returns the mutex protecting the registered maps
+std::mutex& GetMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+}  // namespace
+
+///////////////////////////////////////////////
+/// \brief It returns the key identifying the field map stored at `filename`.
+///
+/// The key contains the resolved absolute path, without symbolic links, the device and inode of the file,
+/// its size and its modification time in nanoseconds, so that a file replaced or rewritten within the
+/// same second gets a different key. The file contents are not read. It returns an empty string if the
+/// file does not exist.
+///
+std::string TRestAxionFieldMapRegistry::GetKey(const std::string& filename) {
+    char path[PATH_MAX];
+    if (realpath(filename.c_str(), path) == nullptr) return "";
+
+    struct stat status;
+    if (stat(path, &status) != 0) return "";
+
+    std::ostringstream key;
+    key << path << ":" << status.st_dev << ":" << status.st_ino << ":" << status.st_size << ":"
+        << status.st_mtim.tv_sec << "." << status.st_mtim.tv_nsec;
+    return key.str();
+}
+
+///////////////////////////////////////////////
+/// \brief It searches the map registered with the given `key`. If it is found, and its data is still
+/// in use, it is copied to `grid` and it returns true.
+///
+/// If the tricubic derivatives or the multipole expansion of the registered map were released, while its
+/// data is still in use, it returns false, and the map must be loaded again to build them.
+///
+Bool_t TRestAxionFieldMapRegistry::Find(const std::string& key, TRestAxionFieldGrid& grid) {
+    if (key.empty()) return false;
+
+    std::lock_guard<std::mutex> lock(GetMutex());
+    auto entry = GetEntries().find(key);
+    if (entry == GetEntries().end()) return false;
+
+    std::shared_ptr<void> data = entry->second.data.lock();
+    std::shared_ptr<TRestAxionFieldTileCache> tiles = entry->second.tiles.lock();
+    std::shared_ptr<const TRestAxionFieldBricks> bricks = entry->second.bricks.lock();
+    if (data == nullptr && tiles == nullptr && bricks == nullptr) {
+        GetEntries().erase(entry);
+        return false;
+    }
+
+    grid = entry->second.grid;
+    grid.fData = data;
+    grid.fTileCache = tiles;
+    grid.fBricks = bricks;
+    grid.fOccupancy = entry->second.occupancy.lock();
+    grid.fAxialSums = entry->second.axialSums.lock();
+    grid.fTricubic = entry->second.tricubic.lock();
+    grid.fMultipoles = entry->second.multipoles.lock();
+    if ((entry->second.hasTricubic && !grid.HasTricubic()) ||
+        (entry->second.hasMultipoles && !grid.HasMultipoles())) {
+        grid = TRestAxionFieldGrid();
+        return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It registers the field map `grid` with the given `key`, replacing any previous entry.
+///
+void TRestAxionFieldMapRegistry::Add(const std::string& key, const TRestAxionFieldGrid& grid) {
+    if (key.empty() || grid.IsEmpty()) return;
+
+    std::lock_guard<std::mutex> lock(GetMutex());
+    RegistryEntry& entry = GetEntries()[key];
+    entry.grid = grid;
+    entry.grid.Reset();
+    entry.data = grid.fData;
+    entry.tiles = grid.fTileCache;
+    entry.bricks = grid.fBricks;
+    entry.occupancy = grid.fOccupancy;
+    entry.axialSums = grid.fAxialSums;
+    entry.tricubic = grid.fTricubic;
+    entry.multipoles = grid.fMultipoles;
+    entry.hasTricubic = grid.HasTricubic();
+    entry.hasMultipoles = grid.HasMultipoles();
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the number of registered maps whose data is still in use
+///
+Int_t TRestAxionFieldMapRegistry::GetNumberOfMaps() {
+    std::lock_guard<std::mutex> lock(GetMutex());
+    Int_t n = 0;
+    for (auto& entry : GetEntries())
+        if (!entry.second.IsExpired()) n++;
+    return n;
+}
@@ -0,0 +1,388 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldModel describes the magnetic field of an ideal magnet in
+/// closed form, using a few parameters instead of a field map. It is used
+/// by TRestAxionMagneticField for the volumes defined with the `model`
+/// parameter.
+///
+/// The field is evaluated with a few tens of floating point operations, and
+/// no memory is required, so that the magnet geometry can be modified and
+/// evaluated again at no cost, e.g. when scanning the magnet length or the
+/// bore radius in a design study. The models are expressed in the reference
+/// system of the magnet, with the magnet axis along z and centered at the
+/// position given by TRestAxionFieldModel::Translate. All distances are given
+/// in mm, and the field in T.
+///
+/// ### Dipole and multipole
+///
+/// The transverse field of a multipole is given by the usual 2-dimensional
+/// expansion
+///
+/// \f[
+/// B_y + i B_x = \sum_{n=1}^{N} (b_n + i a_n) \left( \frac{x + i y}{R} \right)^{n-1}
+/// \f]
+///
+/// where \f$b_n\f$ and \f$a_n\f$ are the normal and skew coefficients, and
+/// \f$R\f$ is the reference radius. The first term is the dipole, the second
+/// the quadrupole, and so on. The dipole model is the particular case with a
+/// single coefficient, and a uniform field \f$(a_1, b_1)\f$.
+///
+/// The transverse field is multiplied by the longitudinal profile of the
+/// magnet, of magnetic length \f$L\f$ and fringe length \f$a\f$,
+///
+/// \f[
+/// P(z) = \frac{1}{2} \left[ \tanh\left(\frac{z + L/2}{a}\right) - \tanh\left(\frac{z - L/2}{a}\right)
+/// \right]
+/// \f]
+///
+/// that is 1 inside a magnet much longer than \f$a\f$, 1/2 at its ends, and
+/// it vanishes outside over a distance of a few \f$a\f$. The longitudinal
+/// component of the fringe fields is included to first order in the distance
+/// to the axis, \f$B_z = P'(z) \psi(x,y)\f$, where \f$\psi\f$ is the
+/// potential of the transverse field. The field is then free of curl, and its
+/// divergence, \f$P''(z) \psi(x,y)\f$, is only present in the fringe region.
+/// If the fringe length is zero, the field ends abruptly at \f$z = \pm L/2\f$.
+/// If the magnetic length is zero, the magnet is infinitely long.
+///
+/// ### Solenoid
+///
+/// The field on the axis of a solenoid of radius \f$R\f$ and length \f$L\f$
+/// is
+///
+/// \f[
+/// B_0(z) = \frac{B}{2} \left[ \frac{z + L/2}{\sqrt{(z + L/2)^2 + R^2}} - \frac{z - L/2}{\sqrt{(z - L/2)^2 +
+/// R^2}} \right]
+/// \f]
+///
+/// where \f$B = \mu_0 n I\f$ is the field of an infinitely long solenoid.
+/// The field off the axis is obtained from the expansion in the distance to
+/// the axis, \f$r\f$, as \f$B_z = B_0 - r^2 B_0''/4\f$ and \f$B_r = -r
+/// B_0'/2\f$, that is accurate well inside the solenoid, for \f$r\f$ up to
+/// about \f$R/2\f$. If the length is zero, the solenoid is infinitely long,
+/// and the field is uniform.
+///
+/// ### Gradient and integrals
+///
+/// The derivatives of the field are also given in closed form by
+/// TRestAxionFieldModel::Evaluate. The field integrals along a segment,
+/// TRestAxionFieldModel::Integrate, are computed with a 4-point
+/// Gauss-Legendre quadrature in pieces no longer than half the fringe length
+/// or half the radius, as given by TRestAxionFieldModel::GetIntegrationStep.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the analytic field models used by
+///               TRestAxionMagneticField volumes.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldModel
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+/// The 4-point Gauss-Legendre nodes in [-1, 1]
+const Double_t kQuadratureNodes[4] = {-0.8611363115940526, -0.3399810435848563, 0.3399810435848563,
+                                      0.8611363115940526};
+
+/// The 4-point Gauss-Legendre weights
+const Double_t kQuadratureWeights[4] = {0.3478548451374538, 0.6521451548625461, 0.6521451548625461,
+                                        0.3478548451374538};
+}  // namespace
+
+///////////////////////////////////////////////
+/// \brief It defines an ideal dipole with the transverse `field` at its center, in T, the magnetic
+/// `length` and the `fringe` length, in mm.
+///
+/// The z component of `field` is ignored. See the class description for the meaning of a zero length.
+///
+void TRestAxionFieldModel::SetDipole(const TVector3& field, Double_t length, Double_t fringe) {
+    SetMultipole({field.Y()}, {field.X()}, 0, length, fringe);
+    fType = kDipole;
+}
+
+///////////////////////////////////////////////
+/// \brief It defines a solenoid along z with the `field` of an infinitely long solenoid, in T, and with
+/// the given `length` and `radius`, in mm.
+///
+void TRestAxionFieldModel::SetSolenoid(Double_t field, Double_t length, Double_t radius) {
+    Clear();
+    fType = kSolenoid;
+    fSolenoidField = field;
+    fLength = length;
+    fRadius = radius;
+}
+
+///////////////////////////////////////////////
+/// \brief It defines a multipole with the `normal` and `skew` coefficients, in T, at the reference
+/// `radius`, and with the magnetic `length` and `fringe` length, in mm.
+///
+/// The first coefficient of each vector is the dipole, the second the quadrupole, and so on. The missing
+/// coefficients of the shortest vector are zero.
+///
+void TRestAxionFieldModel::SetMultipole(const std::vector<Double_t>& normal,
+                                        const std::vector<Double_t>& skew, Double_t radius, Double_t length,
+                                        Double_t fringe) {
+    Clear();
+    fType = kMultipole;
+    fNormal = normal;
+    fSkew = skew;
+    size_t order = max(normal.size(), skew.size());
+    fNormal.resize(order, 0.);
+    fSkew.resize(order, 0.);
+    fRadius = radius;
+    fLength = length;
+    fFringe = fringe;
+}
+
+///////////////////////////////////////////////
+/// \brief It removes the model definition. The field will be zero everywhere
+///
+void TRestAxionFieldModel::Clear() {
+    fType = kNone;
+    for (int n = 0; n < 3; n++) fCenter[n] = 0;
+    fLength = fFringe = fRadius = fSolenoidField = 0;
+    fNormal.clear();
+    fSkew.clear();
+}
+
+///////////////////////////////////////////////
+/// \brief It moves the center of the magnet by `offset`
+///
+void TRestAxionFieldModel::Translate(const TVector3& offset) {
+    for (int n = 0; n < 3; n++) fCenter[n] += offset[n];
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `profile` the longitudinal profile, P(z), of a dipole or multipole and its first
+/// and second derivatives, at the distance `z` from the center of the magnet.
+///
+void TRestAxionFieldModel::GetProfile(Double_t z, Double_t* profile) const {
+    profile[1] = profile[2] = 0;
+    if (fLength <= 0) {
+        profile[0] = 1;
+    } else if (fFringe <= 0) {
+        profile[0] = fabs(z) < fLength / 2 ? 1 : 0;
+    } else {
+        Double_t up = tanh((z + fLength / 2) / fFringe);
+        Double_t down = tanh((z - fLength / 2) / fFringe);
+        profile[0] = (up - down) / 2;
+        profile[1] = ((1 - up * up) - (1 - down * down)) / (2 * fFringe);
+        profile[2] = (down * (1 - down * down) - up * (1 - up * up)) / (fFringe * fFringe);
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the field, in T, at the absolute position `pos`, in mm
+///
+TVector3 TRestAxionFieldModel::Evaluate(const TVector3& pos) const {
+    Double_t p[3] = {pos.X(), pos.Y(), pos.Z()};
+    Double_t b[3];
+    Evaluate(p, b);
+    return TVector3(b[0], b[1], b[2]);
+}
+
+///////////////////////////////////////////////
+/// \brief It writes at `field` the field components, in T, at the absolute position `pos`, in mm.
+///
+/// If `gradient` is given, the derivatives of the field are written there in T/mm, with
+/// `gradient[3 * c + n]` the derivative of the component `c` along the axis `n`, as given by
+/// TRestAxionFieldGrid::InterpolateGradient.
+///
+void TRestAxionFieldModel::Evaluate(const Double_t* pos, Double_t* field, Double_t* gradient) const {
+    Double_t local[3];
+    for (int n = 0; n < 3; n++) local[n] = pos[n] - fCenter[n];
+
+    if (fType == kSolenoid) {
+        EvaluateSolenoid(local, field, gradient);
+    } else if (fType == kDipole || fType == kMultipole) {
+        EvaluateMultipole(local, field, gradient);
+    } else {
+        for (int n = 0; n < 3; n++) field[n] = 0;
+        if (gradient)
+            for (int n = 0; n < 9; n++) gradient[n] = 0;
+    }
+}
+
+///////////////////////////////////////////////
+/// \brief It evaluates the dipole or multipole field, and optionally its gradient, at the position `pos`
+/// relative to the center of the magnet.
+///
+void TRestAxionFieldModel::EvaluateMultipole(const Double_t* pos, Double_t* field, Double_t* gradient) const {
+    // The reference radius does not change the dipole field, and it is not required in that case
+    Double_t radius = fRadius > 0 ? fRadius : 1;
+    Double_t wr = pos[0] / radius, wi = pos[1] / radius;
+
+    // The transverse field (By + i Bx), its derivative along x, and the complex potential whose imaginary
+    // part gives the transverse field as its gradient. The complex products are written explicitly, since
+    // std::complex checks for infinite values at each product
+    Double_t br = 0, bi = 0, dr = 0, di = 0, ar = 0, ai = 0;
+    Double_t pr = 1, pi = 0, qr = 0, qi = 0;
+    for (size_t n = 0; n < fNormal.size(); n++) {
+        // The coefficient times w^n (p) and times w^(n-1) (q)
+        Double_t cr = fNormal[n], ci = fSkew[n];
+        Double_t tr = cr * pr - ci * pi, ti = cr * pi + ci * pr;
+        br += tr;
+        bi += ti;
+        dr += n * (cr * qr - ci * qi);
+        di += n * (cr * qi + ci * qr);
+        ar += (tr * wr - ti * wi) / (n + 1);
+        ai += (tr * wi + ti * wr) / (n + 1);
+
+        qr = pr;
+        qi = pi;
+        pr = qr * wr - qi * wi;
+        pi = qr * wi + qi * wr;
+    }
+    dr /= radius;
+    di /= radius;
+    Double_t psi = ai * radius;
+
+    Double_t profile[3];
+    GetProfile(pos[2], profile);
+
+    field[0] = profile[0] * bi;
+    field[1] = profile[0] * br;
+    field[2] = profile[1] * psi;
+
+    if (!gradient) return;
+    gradient[0] = profile[0] * di;
+    gradient[1] = profile[0] * dr;
+    gradient[2] = profile[1] * bi;
+    gradient[3] = profile[0] * dr;
+    gradient[4] = -profile[0] * di;
+    gradient[5] = profile[1] * br;
+    gradient[6] = profile[1] * bi;
+    gradient[7] = profile[1] * br;
+    gradient[8] = profile[2] * psi;
+}
+
+///////////////////////////////////////////////
+/// \brief It evaluates the solenoid field, and optionally its gradient, at the position `pos` relative to
+/// the center of the magnet.
+///
+void TRestAxionFieldModel::EvaluateSolenoid(const Double_t* pos, Double_t* field, Double_t* gradient) const {
+    // The field on the axis and its first 3 derivatives along z
+    Double_t axis[4] = {fSolenoidField, 0, 0, 0};
+    if (fLength > 0) {
+        // The contributions of both ends, at the distances z + L/2 and z - L/2, have opposite signs
+        axis[0] = 0;
+        Double_t r2 = fRadius * fRadius;
+        Double_t ends[2] = {pos[2] + fLength / 2, pos[2] - fLength / 2};
+        for (int e = 0; e < 2; e++) {
+            Double_t u = ends[e];
+            Double_t s = u * u + r2;
+            Double_t root = sqrt(s);
+            Double_t half = e == 0 ? fSolenoidField / 2 : -fSolenoidField / 2;
+
+            axis[0] += half * u / root;
+            axis[1] += half * r2 / (s * root);
+            axis[2] -= half * 3 * u * r2 / (s * s * root);
+            axis[3] -= half * 3 * r2 * (r2 - 4 * u * u) / (s * s * s * root);
+        }
+    }
+
+    Double_t rho2 = pos[0] * pos[0] + pos[1] * pos[1];
+    field[0] = -pos[0] / 2 * axis[1];
+    field[1] = -pos[1] / 2 * axis[1];
+    field[2] = axis[0] - rho2 / 4 * axis[2];
+
+    if (!gradient) return;
+    gradient[0] = -axis[1] / 2;
+    gradient[1] = 0;
+    gradient[2] = -pos[0] / 2 * axis[2];
+    gradient[3] = 0;
+    gradient[4] = -axis[1] / 2;
+    gradient[5] = -pos[1] / 2 * axis[2];
+    gradient[6] = -pos[0] / 2 * axis[2];
+    gradient[7] = -pos[1] / 2 * axis[2];
+    gradient[8] = axis[1] - rho2 / 4 * axis[3];
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the maximum length, in mm, of the pieces of a segment integrated by
+/// TRestAxionFieldModel::Integrate.
+///
+/// It is half the fringe length or half the radius, the distances where the field changes. It is infinite
+/// for a uniform field.
+///
+Double_t TRestAxionFieldModel::GetIntegrationStep() const {
+    Double_t step = HUGE_VAL;
+    if (fType == kSolenoid && fLength > 0 && fRadius > 0) step = fRadius / 2;
+    if (fType == kDipole || fType == kMultipole) {
+        if (fLength > 0 && fFringe > 0) step = fFringe / 2;
+        if (fNormal.size() > 1 && fRadius > 0) step = min(step, fRadius / 2);
+    }
+    return step;
+}
+
+///////////////////////////////////////////////
+/// \brief It adds to `integral` the integrals of the field, plus a constant `offset` field, along the
+/// straight segment between the absolute positions `from` and `to`.
+///
+/// The segment is divided at the ends of a magnet without fringe fields, and in pieces not longer than
+/// TRestAxionFieldModel::GetIntegrationStep. The integrals of each piece are obtained using a 4-point
+/// Gauss-Legendre quadrature, as done by TRestAxionFieldGrid::Integrate.
+///
+void TRestAxionFieldModel::Integrate(const TVector3& from, const TVector3& to, const TVector3& offset,
+                                     FieldLineIntegral& integral) const {
+    Double_t length = (to - from).Mag();
+    if (length == 0) return;
+    TVector3 u = (to - from).Unit();
+
+    // The field of a magnet without fringe fields is discontinuous at its ends
+    std::vector<Double_t> t = {0, length};
+    if (fType != kSolenoid && fLength > 0 && fFringe <= 0 && u.Z() != 0) {
+        for (int e = -1; e <= 1; e += 2) {
+            Double_t end = (fCenter[2] + e * fLength / 2 - from.Z()) / u.Z();
+            if (end > 0 && end < length) t.push_back(end);
+        }
+        sort(t.begin(), t.end());
+    }
+
+    Double_t step = GetIntegrationStep();
+    for (size_t c = 0; c + 1 < t.size(); c++) {
+        Int_t pieces = step < HUGE_VAL ? max((Int_t)ceil((t[c + 1] - t[c]) / step), 1) : 1;
+        Double_t half = (t[c + 1] - t[c]) / pieces / 2;
+        for (Int_t p = 0; p < pieces; p++) {
+            Double_t start = t[c] + 2 * half * p;
+            for (int n = 0; n < 4; n++) {
+                TVector3 pos = from + (start + half * (1 + kQuadratureNodes[n])) * u;
+                integral.Add(Evaluate(pos) + offset, u, kQuadratureWeights[n] * half);
+            }
+        }
+    }
+}
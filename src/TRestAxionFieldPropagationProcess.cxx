@@ -536,11 +536,12 @@ std::vector<std::vector<TVector3>> TRestAxionFieldPropagationProcess::FindFieldB
 
     // Find field boundaries volume
 
-    Int_t N = fAxionMagneticField->GetNumberOfVolumes();
+    // Only the volumes crossed by the trajectory are considered
+    std::vector<Int_t> ids = fAxionMagneticField->GetVolumesAlongRay(posInitial, direction);
 
-    for (Int_t p = 0; p < N; p++) {
+    for (unsigned int p = 0; p < ids.size(); p++) {
         buffVect.clear();
-        buffVect = fAxionMagneticField->GetFieldBoundaries(p, posInitial, direction);
+        buffVect = fAxionMagneticField->GetFieldBoundaries(ids[p], posInitial, direction);
         if (buffVect.size() == 2) {
             boundaryFinalCollection.push_back(buffVect);
         }
@@ -619,6 +620,9 @@ void TRestAxionFieldPropagationProcess::PrintComplex(ComplexReal p) {
 ///
 /// NOTE: The amplitudes are calculated for the axion-photon coupling constant g_agg = 10^-10 GeV-1
 /// The length of the subsegment is defined by variable `step`. It is currently set to 200 mm.
+/// The field averages along all the subsegments are obtained in a single traversal of the segment from the
+/// exact line integrals given by TRestAxionMagneticField::GetFieldIntegrals, so that they do not depend on
+/// an integration step.
 
 void TRestAxionFieldPropagationProcess::CalculateAmplitudesInSegment(
     ComplexReal& faxionAmplitude, ComplexReal& fparallelPhotonAmplitude,
@@ -643,7 +647,6 @@ void TRestAxionFieldPropagationProcess::CalculateAmplitudesInSegment(
     Double_t BTangle;  // angle between the transverse component of the average magnetic field in one
                        // subsegment and the one in the previous subsegment
 
-    subsegment_start = from;
     subsegment_A0_par = fparallelPhotonAmplitude;    // parallel photon amplitude at the beginning of the
                                                      // segment, i.e., at the point `from`
     subsegment_A0_ort = forthogonalPhotonAmplitude;  // orthogonal photon amplitude at the beginning of the
@@ -651,20 +654,30 @@ void TRestAxionFieldPropagationProcess::CalculateAmplitudesInSegment(
     averageBT_0 = averageBT;
     TVector3 dir = (to - from).Unit();  // direction of the particle propagation
 
-    while ((subsegment_start - from).Mag() < segment_length) {  // loop over subsegments in one segment
-        subsegment_end = subsegment_start + step * dir;
-        if ((subsegment_end - from).Mag() >= segment_length) subsegment_end = to;
+    // the field integrals along all the subsegments are calculated at once
+    std::vector<TVector3> path = {from};
+    while ((path.back() - from).Mag() < segment_length) {
+        TVector3 next = path.back() + step * dir;
+        if ((next - from).Mag() >= segment_length) next = to;
+        path.push_back(next);
+    }
+    // The minimum and maximum transverse intensity are only shown at the debug output
+    std::vector<FieldLineIntegral> integrals =
+        fAxionMagneticField->GetFieldIntegrals(path, GetVerboseLevel() >= REST_Debug);
+
+    for (unsigned int n = 0; n < integrals.size(); n++) {  // loop over subsegments in one segment
+        subsegment_start = path[n];
+        subsegment_end = path[n + 1];
         subsegment_length = (subsegment_end - subsegment_start).Mag();
         subsegment_length = subsegment_length / 1000.0;  // default REST units are mm
 
         // calculation of the average magnitude of the transverse magnetic field along the subsegment, i.e.,
         // between coordinates `subsegment_start` and `subsegment_end`
-        BTmag =
-            fAxionMagneticField->GetTransversalFieldAverage(subsegment_start, subsegment_end);  // in Tesla
+        BTmag = integrals[n].GetTransversalFieldAverage();  // in Tesla
 
         // calculation of the transverse component of the average magnetic field vector along the subsegment,
         // i.e., between coordinates `subsegment_start` and `subsegment_end`
-        averageBT = fAxionMagneticField->GetFieldAverageTransverseVector(subsegment_start, subsegment_end);
+        averageBT = integrals[n].GetFieldAverageTransverseVector();
 
         // calculation of the angle between the transverse component of the average magnetic field in one
         // subsegment and the one in the previous subsegment
@@ -702,6 +715,8 @@ void TRestAxionFieldPropagationProcess::CalculateAmplitudesInSegment(
 
         debug << " average magnitude of the transverse component of the magnetic field in the subsegment : "
               << BTmag << " T" << endl;
+        debug << " min/max transverse field intensity in the subsegment : " << integrals[n].transverseMin
+              << " / " << integrals[n].transverseMax << " T (" << integrals[n].samples << " points)" << endl;
         debug << " angle of the transverse component of the average magnetic field in the subsegment with "
                  "respect to the previous subsegment : "
               << BTangle << " rad" << endl;
@@ -732,7 +747,6 @@ void TRestAxionFieldPropagationProcess::CalculateAmplitudesInSegment(
         PrintComplex(fparallelPhotonAmplitude);
         debug << " AFTER calculating in subsegment: orthogonal photon component amplitude : ";
         PrintComplex(forthogonalPhotonAmplitude);
-        subsegment_start = subsegment_end;
     }
 }
 
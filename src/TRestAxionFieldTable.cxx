@@ -0,0 +1,284 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldTable keeps a field map table, with the 6 columns x, y,
+/// z, Bx, By and Bz, as a single block of values, instead of one vector
+/// per row.
+///
+/// TRestAxionFieldTable::ReadASCII reads the plain-text tables (`.dat`)
+/// used by TRestAxionMagneticField, that may take several GB for the
+/// field maps of a full magnet. The file is mapped in memory and split in
+/// consecutive parts, starting at the beginning of a line, that are read by
+/// different threads. A first pass counts the rows of each part, so that
+/// every thread writes its rows directly at their final position in the
+/// table, and the rows keep the order of the file.
+///
+/// Each row must contain 6 numbers, separated by spaces, tabs, commas or
+/// semicolons. Empty lines, and lines starting with `#`, are ignored. The
+/// numbers are converted by a dedicated routine, that obtains the correctly
+/// rounded value for numbers with up to 19 significant digits and an
+/// exponent up to 22 in absolute value, which covers the usual tables.
+/// Other numbers are converted with `strtod`. In both cases the value is
+/// the one given by `strtod`, rounded to single precision.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the parallel reading of the
+///               plain-text field map tables.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldTable
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldTable.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+/// The powers of 10 that are exactly represented in double precision
+const Double_t kPowers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/// The maximum number of significant digits accumulated in the mantissa
+const Int_t kMaxDigits = 19;
+
+/// It returns true if `c` separates two numbers of a row
+inline Bool_t IsSeparator(char c) { return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r'; }
+
+/// It returns true if `c` is a decimal digit
+inline Bool_t IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+/// It converts the number starting at `p`, in the text ending at `end`. It returns the position after the
+/// number, or nullptr if there is no valid number at `p`.
+const char* ParseNumber(const char* p, const char* end, Float_t& value) {
+    const char* start = p;
+
+    Bool_t negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    // The significant digits are accumulated in the mantissa, and the decimal point moves the exponent
+    ULong64_t mantissa = 0;
+    Int_t digits = 0, exponent = 0;
+    Bool_t found = false, exact = true;
+    for (; p < end && IsDigit(*p); p++) {
+        found = true;
+        if (digits < kMaxDigits) {
+            mantissa = 10 * mantissa + (*p - '0');
+            if (mantissa > 0) digits++;
+        } else {
+            exact = false;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && IsDigit(*p); p++) {
+            found = true;
+            if (digits < kMaxDigits) {
+                mantissa = 10 * mantissa + (*p - '0');
+                if (mantissa > 0) digits++;
+                exponent--;
+            } else {
+                exact = false;
+            }
+        }
+    }
+    if (!found) return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        Bool_t negativeExponent = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        if (p == end || !IsDigit(*p)) return nullptr;
+
+        Int_t e = 0;
+        for (; p < end && IsDigit(*p); p++)
+            if (e < 100000) e = 10 * e + (*p - '0');
+        exponent += negativeExponent ? -e : e;
+    }
+    if (p < end && !IsSeparator(*p) && *p != '\n') return nullptr;
+
+    // A mantissa below 2^53 and a power of 10 are exact in double precision, and their product or
+    // quotient is correctly rounded. Otherwise the conversion is done by strtod
+    Double_t result;
+    if (exact && mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        result = exponent < 0 ? mantissa / kPowers[-exponent] : mantissa * kPowers[exponent];
+        if (negative) result = -result;
+    } else {
+        char buffer[128];
+        size_t length = p - start;
+        if (length >= sizeof(buffer)) return nullptr;
+        memcpy(buffer, start, length);
+        buffer[length] = '\0';
+        result = strtod(buffer, nullptr);
+    }
+
+    value = (Float_t)result;
+    return p;
+}
+
+/// It returns the first character of the line starting at `p` that is not a separator. If the line is
+/// empty, or it is a comment, it returns the end of the line
+const char* GetLineContent(const char* p, const char* end) {
+    while (p < end && IsSeparator(*p)) p++;
+    if (p < end && *p == '#') {
+        const char* next = (const char*)memchr(p, '\n', end - p);
+        return next == nullptr ? end : next;
+    }
+    return p;
+}
+
+/// It returns the position after the end of the line containing `p`
+const char* GetNextLine(const char* p, const char* end) {
+    const char* next = (const char*)memchr(p, '\n', end - p);
+    return next == nullptr ? end : next + 1;
+}
+}  // namespace
+
+///////////////////////////////////////////////
+/// \brief It reads the plain-text table `filename`, splitting the file between `threads` threads.
+///
+/// It returns false if the file cannot be read, or if a line is not a row of 6 numbers. The line is
+/// reported, and the table is left empty.
+///
+Bool_t TRestAxionFieldTable::ReadASCII(const std::string& filename, Int_t threads) {
+    Clear();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "TRestAxionFieldTable::ReadASCII. Cannot open file : " << filename << endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        cerr << "TRestAxionFieldTable::ReadASCII. Cannot read file : " << filename << endl;
+        close(fd);
+        return false;
+    }
+    size_t length = st.st_size;
+    if (length == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        cerr << "TRestAxionFieldTable::ReadASCII. Cannot map file : " << filename << endl;
+        return false;
+    }
+    madvise(addr, length, MADV_SEQUENTIAL);
+    const char* text = (const char*)addr;
+    const char* end = text + length;
+
+    // The parts start at the beginning of a line
+    Int_t parts = (Int_t)max((size_t)1, min((size_t)max(threads, 1), length / 4096 + 1));
+    std::vector<const char*> first(parts + 1, end);
+    first[0] = text;
+    for (Int_t t = 1; t < parts; t++)
+        first[t] = max(first[t - 1], GetNextLine(text + length * t / parts - 1, end));
+
+    // It runs `function(t)` for each part in its own thread
+    auto runParts = [parts](std::function<void(Int_t)> function) {
+        std::vector<std::thread> workers;
+        for (Int_t t = 1; t < parts; t++) workers.emplace_back(function, t);
+        function(0);
+        for (auto& worker : workers) worker.join();
+    };
+
+    // The number of rows of each part gives the position of its first row
+    std::vector<size_t> rows(parts + 1, 0);
+    runParts([&](Int_t t) {
+        for (const char* p = first[t]; p < first[t + 1]; p = GetNextLine(p, end)) {
+            const char* content = GetLineContent(p, end);
+            if (content < end && *content != '\n') rows[t + 1]++;
+        }
+    });
+    for (Int_t t = 0; t < parts; t++) rows[t + 1] += rows[t];
+
+    fValues.resize(rows[parts] * kColumns);
+
+    // The first line of each part that is not a valid row, if any
+    std::vector<const char*> wrong(parts, nullptr);
+    runParts([&](Int_t t) {
+        Float_t* row = fValues.data() + rows[t] * kColumns;
+        for (const char* p = first[t]; p < first[t + 1]; p = GetNextLine(p, end)) {
+            const char* q = GetLineContent(p, end);
+            if (q == end || *q == '\n') continue;
+
+            Int_t n = 0;
+            while (q != nullptr && q < end && *q != '\n') {
+                if (n == kColumns) {
+                    q = nullptr;
+                    break;
+                }
+                q = ParseNumber(q, end, row[n++]);
+                while (q != nullptr && q < end && IsSeparator(*q)) q++;
+            }
+            if (q == nullptr || n < kColumns) {
+                wrong[t] = p;
+                return;
+            }
+            row += kColumns;
+        }
+    });
+
+    Bool_t valid = true;
+    for (Int_t t = 0; t < parts && valid; t++) {
+        if (wrong[t] == nullptr) continue;
+        cerr << "TRestAxionFieldTable::ReadASCII. The line " << count(text, wrong[t], '\n') + 1
+             << " is not a row of " << kColumns << " numbers. File : " << filename << endl;
+        Clear();
+        valid = false;
+    }
+    munmap(addr, length);
+
+    return valid;
+}
+
+///////////////////////////////////////////////
+/// \brief It copies the first 6 columns of the rows of `data`. Missing columns are set to zero.
+///
+void TRestAxionFieldTable::SetRows(const std::vector<std::vector<Float_t>>& data) {
+    fValues.assign(data.size() * kColumns, 0);
+    for (size_t n = 0; n < data.size(); n++)
+        copy_n(data[n].begin(), min(data[n].size(), (size_t)kColumns), fValues.begin() + n * kColumns);
+}
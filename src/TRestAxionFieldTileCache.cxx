@@ -0,0 +1,230 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionFieldTileCache reads on demand the tiles of a tiled field map
+/// file, written by TRestAxionFieldGrid::WriteFile, and keeps the most
+/// recently used tiles in memory.
+///
+/// The tiles are read from the file the first time they are requested. When
+/// the number of tiles in memory reaches the limit given at
+/// TRestAxionFieldTileCache::Open, the least recently used tile is released.
+/// A tile that is still being used by the caller is not destroyed until the
+/// caller releases it, since the tiles are returned as shared pointers.
+///
+/// The cache can be used by several threads at the same time. The tiles are
+/// distributed in up to 16 shards, and each shard has its own least recently
+/// used list protected by its own mutex. The memory limit is divided between
+/// the shards. A lookup only locks the shard of the tile, and the lock is not
+/// held while a tile is read from the file, so that the threads reading
+/// different tiles, or using tiles already in memory, do not wait for each
+/// other.
+///
+/// The shard of a tile is given by a hash of its id. The consecutive tiles
+/// along a ray have ids separated by a constant stride, e.g. the number of
+/// tiles along z for a ray along y, and the hash spreads them over all the
+/// shards, so that the full memory limit is used. A small cache uses fewer
+/// shards, each one keeping at least 8 tiles.
+///
+/// A tile that cannot be read, e.g. due to an input/output error, is
+/// reported and replaced by a tile filled with zeros. It is not kept in
+/// memory, so that it is read again when it is requested later.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the tile cache used by tiled
+///               TRestAxionFieldGrid field maps.
+///               Javier Galan
+///
+/// \class      TRestAxionFieldTileCache
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionFieldTileCache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+using namespace std;
+
+namespace {
+/// The byte alignment of the tile blocks, as used by TRestAxionFieldGrid
+const size_t kTileAlignment = 64;
+}  // namespace
+
+///////////////////////////////////////////////
+/// \brief It opens the tiled file `filename`, containing `numberOfTiles` tiles of `tileBytes` bytes each,
+/// placed consecutively after the first `dataOffset` bytes.
+///
+/// At most `maxBytes` bytes of tile data will be kept in memory. At least one tile is always kept. It
+/// returns false if the file cannot be opened.
+///
+Bool_t TRestAxionFieldTileCache::Open(const std::string& filename, size_t dataOffset, size_t tileBytes,
+                                      size_t numberOfTiles, size_t maxBytes) {
+    for (size_t n = 0; n < kShards; n++) {
+        lock_guard<mutex> lock(fShards[n].mutex);
+        fShards[n].recent.clear();
+        fShards[n].tiles.clear();
+    }
+    fLoads = 0;
+    fHits = 0;
+    fErrors = 0;
+
+    if (fFile >= 0) close(fFile);
+    fFile = open(filename.c_str(), O_RDONLY);
+    if (fFile < 0) {
+        cerr << "TRestAxionFieldTileCache::Open. Cannot open file : " << filename << endl;
+        return false;
+    }
+
+    fDataOffset = dataOffset;
+    fTileBytes = tileBytes;
+    fNumberOfTiles = numberOfTiles;
+    fMaxTiles = tileBytes > 0 ? maxBytes / tileBytes : 1;
+    if (fMaxTiles < 1) fMaxTiles = 1;
+
+    // The limit is divided between the shards, so that the total number of tiles never exceeds it
+    fNumberOfShards = max((size_t)1, min(kShards, fMaxTiles / kMinShardTiles));
+    for (size_t n = 0; n < fNumberOfShards; n++)
+        fShards[n].maxTiles = fMaxTiles / fNumberOfShards + (n < fMaxTiles % fNumberOfShards ? 1 : 0);
+
+    std::shared_ptr<void> empty = AllocateTile();
+    memset(empty.get(), 0, fTileBytes);
+    fEmptyTile = empty;
+
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the shard keeping the tile `id`.
+///
+/// The id is mixed with the finalizer of the SplitMix64 generator before taking the modulo, so that ids
+/// separated by a constant stride are not placed at the same shard.
+///
+size_t TRestAxionFieldTileCache::GetShard(size_t id) const {
+    uint64_t h = id;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h = h ^ (h >> 31);
+    return h % fNumberOfShards;
+}
+
+///////////////////////////////////////////////
+/// \brief It allocates the memory of one tile, aligned as the data blocks of TRestAxionFieldGrid.
+///
+std::shared_ptr<void> TRestAxionFieldTileCache::AllocateTile() const {
+    void* block = nullptr;
+    if (posix_memalign(&block, kTileAlignment, max(fTileBytes, (size_t)1)) != 0) throw std::bad_alloc();
+    return std::shared_ptr<void>(block, free);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the data of the tile `id`, reading it from the file if it is not in memory.
+///
+/// The tile data remains valid while the returned pointer is kept, even if the tile is removed from the
+/// cache in the meantime. If the tile cannot be read, a tile filled with zeros is returned. The first error
+/// is reported, and all of them are counted, see TRestAxionFieldTileCache::GetNumberOfErrors.
+///
+/// The lock of the shard is released while the tile is read. If several threads request the same missing
+/// tile at the same time, each of them reads it, and the first copy stored is kept.
+///
+std::shared_ptr<const void> TRestAxionFieldTileCache::GetTile(size_t id) {
+    Shard& shard = fShards[GetShard(id)];
+    {
+        lock_guard<mutex> lock(shard.mutex);
+        auto found = shard.tiles.find(id);
+        if (found != shard.tiles.end()) {
+            // The tile becomes the most recently used one
+            shard.recent.splice(shard.recent.begin(), shard.recent, found->second.position);
+            fHits++;
+            return found->second.data;
+        }
+    }
+
+    if (id >= fNumberOfTiles) {
+        if (fErrors++ == 0)
+            cerr << "TRestAxionFieldTileCache::GetTile. Tile " << id << " out of range" << endl;
+        return fEmptyTile;
+    }
+
+    std::shared_ptr<void> data = AllocateTile();
+    size_t done = 0;
+    while (done < fTileBytes) {
+        size_t position = fDataOffset + id * fTileBytes + done;
+        ssize_t n = pread(fFile, (char*)data.get() + done, fTileBytes - done, position);
+        if (n <= 0) {
+            if (fErrors++ == 0)
+                cerr << "TRestAxionFieldTileCache::GetTile. Problem reading tile " << id
+                     << ". The field of the tile is taken as zero" << endl;
+            return fEmptyTile;
+        }
+        done += n;
+    }
+    fLoads++;
+
+    lock_guard<mutex> lock(shard.mutex);
+    auto found = shard.tiles.find(id);
+    if (found != shard.tiles.end()) return found->second.data;
+
+    if (shard.tiles.size() >= shard.maxTiles) {
+        shard.tiles.erase(shard.recent.back());
+        shard.recent.pop_back();
+    }
+
+    shard.recent.push_front(id);
+    Tile& tile = shard.tiles[id];
+    tile.data = data;
+    tile.position = shard.recent.begin();
+
+    return data;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the memory used by the tiles kept in memory, in bytes
+///
+size_t TRestAxionFieldTileCache::GetResidentSize() {
+    size_t tiles = 0;
+    for (size_t n = 0; n < fNumberOfShards; n++) {
+        lock_guard<mutex> lock(fShards[n].mutex);
+        tiles += fShards[n].tiles.size();
+    }
+    return tiles * fTileBytes;
+}
+
+///////////////////////////////////////////////
+/// \brief Default destructor
+///
+TRestAxionFieldTileCache::~TRestAxionFieldTileCache() {
+    if (fFile >= 0) close(fFile);
+}
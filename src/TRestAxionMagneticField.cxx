@@ -28,7 +28,11 @@
 /// If the coordinate (x,y,z) is ourside any defined region, the returned
 /// field will be (0,0,0).
 ///
-/// TODO Description of magnetic field interpolation
+/// The field map of each volume is stored in a TRestAxionFieldGrid, a single
+/// contiguous block of memory containing the field components of each node in
+/// the grid. The field at any position inside the volume is obtained by
+/// trilinear interpolation using the 8 nodes of the grid cell containing that
+/// position.
 ///
 /// ### RML definition
 ///
@@ -82,6 +86,92 @@
 /// of the field, which will only happen when the evaluated coordinates are
 /// inside the bounding volume.
 ///
+/// - *symmetry* : The mirror symmetries of the field map, given as a list of
+/// axes, e.g. `symmetry="xz"`. For each axis given, only the half of the map
+/// with positive coordinates is kept in memory, and the field at negative
+/// coordinates is obtained by reflection. A lower case axis letter means
+/// that the field component along that axis changes sign when reflecting
+/// (e.g. Bz(x,y,-z) = -Bz(x,y,z)), as in the BabyIAXO field maps. An upper
+/// case letter means that the component along that axis is kept, and the
+/// two other components change sign. For instance, a dipole field oriented
+/// along y is described by `symmetry="xYz"`. The field map must be centered
+/// at zero with a node at zero along each symmetric axis. It is not
+/// required that the file contains both halves of the map. By default no
+/// symmetry is applied.
+///
+/// - *gridType* : It defines the coordinates used by the field map. The
+/// default value is `cartesian`. If `cylindrical` is given, the columns of
+/// the field map file are interpreted as `r`, `phi`, `z`, `Br`, `Bphi`, `Bz`,
+/// with phi in radians, and the field is stored and interpolated in
+/// cylindrical coordinates around the z-axis of the volume. If all the rows
+/// have the same phi value, the field is axially symmetric and only the
+/// (r, z) plane is stored, reducing the number of nodes by orders of
+/// magnitude for solenoid-like magnets. Otherwise, the phi nodes must cover
+/// a full turn. Only the `z` symmetry can be combined with this grid type.
+///
+/// - *precision* : The numerical type used to keep the field map in memory.
+/// The default value is `double`. Using `float` the memory is reduced by a
+/// factor 2, and using `int16` by a factor 4. In the later case the field
+/// components are stored as 16-bit integers multiplied by a scale factor
+/// common to the whole map, with an absolute error below 1.5e-5 times the
+/// largest field component. The values are converted back to double
+/// precision during the interpolation. The maximum error introduced is
+/// shown by TRestAxionMagneticField::PrintMetadata. A grid file (`.grid`)
+/// written with a reduced precision is used as it is.
+///
+/// - *layout* : The order of the field map nodes in memory. The default value
+/// is `linear`, with the nodes ordered as in the field map file. If `blocked`
+/// is given, the nodes are grouped in small blocks, as described at
+/// TRestAxionFieldGrid, so that the nodes evaluated along a ray are close in
+/// memory whatever the ray direction. It is recommended for large field maps
+/// crossed by rays that are not parallel to z. It is ignored for tiled grid
+/// files (`.tgrid`), and a grid file (`.grid`) is copied to memory.
+///
+/// - *adaptiveTolerance* : If larger than 0, the field map is stored with a
+/// resolution adapted to the field, as described at
+/// TRestAxionFieldGrid::SetAdaptive. The map is divided in bricks of 16
+/// cells along each axis, and only the nodes required to reproduce the
+/// field at every node of a brick within this tolerance, in T, are kept,
+/// e.g. a few nodes where the field is uniform, and all of them close to
+/// the coils. The memory is reduced, and the field integrals are faster,
+/// since the field is integrated at once between the kept nodes. The
+/// `layout` is not used by the adaptive storage, that keeps the field in
+/// double precision. A reduced `precision` cannot be combined with the
+/// adaptive storage, it is replaced by `double` with a warning, since the
+/// reduced precision map could take less memory. The default value is 0.
+///
+/// - *interpolation* : The interpolation of the field map between the nodes.
+/// The default value is `trilinear`. If `tricubic` is given, the derivatives
+/// of the field at the nodes are computed when the field map is loaded, and
+/// the field is interpolated with a polynomial of third degree along each
+/// axis, as described at TRestAxionFieldGrid::BuildTricubic. The field and
+/// its first derivatives are then continuous, and the interpolation error
+/// decreases much faster with the node spacing, so that a coarser field map
+/// can be used. The derivatives take 8 times the memory of the field map in
+/// double precision. It is ignored for tiled grid files (`.tgrid`).
+///
+/// - *multipoleOrder* : The number of terms of a multipole expansion of the
+/// field inside the bore, fitted to the field map when it is loaded. The
+/// default value is 0, and no expansion is used. The field at each slice of
+/// nodes along z is described by a short complex polynomial, as described
+/// at TRestAxionFieldGrid::BuildMultipoles, that is evaluated instead of
+/// the field map inside a circle of radius `multipoleRadius` around the map
+/// center. The default radius, 0, takes the largest circle inside the map.
+/// The slices where the expansion differs from any node inside the bore by
+/// more than `multipoleTolerance` (by default 1e-4 T) are not used, e.g. at
+/// the magnet ends, and the field map is used there and outside the bore.
+///
+/// - *cacheSize* : The maximum memory, in MB, used to keep the tiles of a
+/// tiled grid file (`.tgrid`) in memory. The default value is 256 MB. It is
+/// ignored for other file formats.
+///
+/// - *model* : An analytic field used instead of a field map, `dipole`,
+/// `solenoid` or `multipole`. The default value is `none`. The model is
+/// defined by the parameters `modelField`, `modelLength`, `modelFringe`,
+/// `modelRadius`, `modelNormal` and `modelSkew`, as described in the section
+/// about analytic field models below. It cannot be combined with a field map
+/// file.
+///
 /// All parameteres are optional, and if not provided they will take their default
 /// values.
 ///
@@ -90,7 +180,8 @@
 /// and mesh size through the `boundMax` and `meshSize` parameters. We still have
 /// the possibility to define a constant magnetic field vector for that volume
 /// using the `field` parameter. In that case the method
-/// TRestMagneticField::IsFieldConstant will return true.
+/// TRestMagneticField::IsFieldConstant will return true, unless an analytic
+/// field `model` was defined.
 ///
 /// ### Adding gas properties to each of the magnetic volumes.
 ///
@@ -129,6 +220,25 @@
 /// (xMax,yMax,zMax). Each element is built using the 3-coordinates `x`, `y`, `z`
 /// and the 3-field `Bx`, `By`, `Bz` values expressed in 4-bytes size, Float_t.
 ///
+/// * **Native grid format (.grid)** : A header describing the grid (number of
+/// nodes, position of the first node and node spacing) followed by the field
+/// values, exactly as they are stored in memory. See TRestAxionFieldGrid for
+/// a description of the format. The file is memory mapped instead of being
+/// read, so that no parsing or copy is required, and the startup time does
+/// not depend on the size of the map. This is the recommended format for
+/// large field maps. The `restAxionConvertFieldMap` program, compiled
+/// together with this library, converts a `.dat` or `.bin` field map into a
+/// `.grid` file, validating the grid regularity, and reporting duplicated or
+/// missing nodes.
+///
+/// * **Tiled grid format (.tgrid)** : The native grid format, with the grid
+/// split into tiles that are read from the file only when a position inside
+/// them is evaluated. At most `cacheSize` MB of tiles are kept in memory, and
+/// the least recently used tiles are released first. This format allows to
+/// use field maps that do not fit in memory, since the rays crossing the
+/// magnet bore only visit a narrow tube of tiles. It is produced by
+/// `restAxionConvertFieldMap` when the output filename ends with `.tgrid`.
+///
 /// ### A more detailed example
 ///
 /// The following example shows different allowed volume definition entries.
@@ -151,6 +261,178 @@
 ///    </TRestAxionMagneticField>
 /// \endcode
 ///
+/// \note Volumes using the same field map file share a single copy of the
+/// field data, even if they are defined at different TRestAxionMagneticField
+/// instances. See TRestAxionFieldMapRegistry.
+///
+/// \note The bounding boxes of all the volumes are registered in a
+/// TRestAxionVolumeIndex when the volumes are loaded. The volume containing a
+/// position, or the volumes crossed by a trajectory, are found using this
+/// index, so that the cost does not grow linearly with the number of volumes.
+///
+/// ### Evaluating the field at many positions
+///
+/// The field can be evaluated at a large number of positions in a single call
+/// by providing the coordinates as separate arrays (x, y and z). This avoids
+/// the creation of a TVector3 for each position, and allows the interpolation
+/// to be vectorized. AVX2 or AVX-512 kernels will be used if the library was
+/// compiled with support for those instructions, e.g. using the CMake option
+/// `-DREST_AXION_NATIVE=ON`.
+///
+/// \code
+///    std::vector<Double_t> x(N), y(N), z(N), bx(N), by(N), bz(N), bt(N);
+///    field->GetMagneticField(N, x.data(), y.data(), z.data(), bx.data(), by.data(), bz.data());
+///    field->GetTransversalComponent(N, x.data(), y.data(), z.data(), direction, bt.data());
+/// \endcode
+///
+/// ### Integrating the field along parallel rays
+///
+/// When most of the trajectories share the same direction, e.g. the solar axions generated by
+/// TRestAxionGeneratorProcess with `angularDistribution="flux"`, the field integrals used by
+/// TRestAxionMagneticField::GetFieldIntegrals can be precomputed for that direction. This is enabled by
+/// the parameters `directionTableAxis`, giving the fixed direction, and `directionTableSpacing`, giving
+/// the distance between the rays of the table in mm. The parameter `directionTableMaxSize` limits the
+/// memory used by the table, in MB. It is 512 MB by default.
+///
+/// \code
+///    <TRestAxionMagneticField name="bFieldBabyIAXO" directionTableAxis="(0,0,1)"
+///                             directionTableSpacing="20mm" directionTableMaxSize="256" >
+/// \endcode
+///
+/// The first time a segment with that direction is integrated, the field map is integrated along a
+/// bundle of parallel rays covering all the volumes, as described at TRestAxionFieldDirectionTable. The
+/// integrals along any later segment with the same direction are obtained by interpolation between the
+/// rays, without evaluating the field map. The segments with any other direction are integrated as if no
+/// table was defined, as well as the segments whose minimum and maximum transverse intensity are requested,
+/// that the table does not keep. The table is built again when the volumes are loaded again. If the table would
+/// exceed the maximum size, a warning is shown and no table is used. The result is an approximation,
+/// accurate if the spacing is small compared with the distance where the field changes. The table keeps
+/// 8 values for each node, with nodes separated by the spacing along each ray, and its size grows as the
+/// inverse of the cube of the spacing. By default no table is used.
+///
+/// ### Integrating the field along the magnet axis
+///
+/// Most of the trajectories run nearly parallel to the magnet axis, z. If the parameter `axialSums` is
+/// `true`, the integrals along z of each field map are accumulated when the volumes are loaded, as
+/// described at TRestAxionFieldGrid::BuildAxialSums.
+///
+/// \code
+///    <TRestAxionMagneticField name="bFieldBabyIAXO" axialSums="true" >
+/// \endcode
+///
+/// The field integrals along a segment parallel to z are then obtained from the difference of two sums,
+/// with a cost that does not depend on the segment length. The methods
+/// TRestAxionMagneticField::GetTransversalFieldAverage and
+/// TRestAxionMagneticField::GetFieldAverageTransverseVector use them for such segments, instead of
+/// evaluating the field in steps of `dl`, while other segments use the general calculation. The sums
+/// take 5/3 of the memory of a double precision field map. By default they are not built.
+///
+/// The transverse intensity given by the sums is interpolated linearly between the nodes along z, and it
+/// is only an approximation of the intensity of the interpolated field, as described at
+/// TRestAxionFieldGrid::BuildAxialSums. The field components are exact.
+///
+/// A segment uses the sums if its displacement along x and y is below the parameter `axialTolerance`
+/// times the node spacing, 0.01 by default. The segment is then integrated as if it was parallel to z at
+/// its average x and y, and the error of the field integrals is at most `L*G*d/2`, for a segment of
+/// length `L` displaced a distance `d` sideways, where `G` is the largest derivative of the field along a
+/// direction in the xy plane. For example, with `axialTolerance="1"` a ray crossing a 10 m magnet with a displacement of one
+/// 10 mm spacing, in a field changing 1e-4 T/mm sideways, gets an error of 5 T mm on the integrals, a
+/// relative error of about 1e-4 for a field of 5 T.
+///
+/// \code
+///    <TRestAxionMagneticField name="bFieldBabyIAXO" axialSums="true" axialTolerance="0.5" >
+/// \endcode
+///
+/// ### Loading the volumes in parallel
+///
+/// The field maps of the volumes are read at the same time, each one by its own thread, and the rows of
+/// each table are assigned to the grid nodes by several threads. The plain-text tables (`.dat`) are also
+/// split between the threads of their volume when they are read, as described at TRestAxionFieldTable.
+/// The parameter `loadThreads` gives the total number of threads. By default, or if it is zero, all the
+/// hardware threads are used.
+///
+/// \code
+///    <TRestAxionMagneticField name="bFieldBabyIAXO" loadThreads="8" >
+/// \endcode
+///
+/// A field map used by several volumes is loaded only once, and shared. The time spent at each stage,
+/// reading the file, finding the boundaries and the spacing of a table, assigning the table to the grid
+/// nodes, and building the storage and the derived data of the grid (precision, layout, interpolation,
+/// ...), is shown by TRestAxionMagneticField::PrintMetadata for each volume, and it is returned by
+/// TRestAxionMagneticField::GetLoadTimes.
+///
+/// ### Sampling the field along a ray
+///
+/// Consecutive queries along a ray are usually found inside the same volume and the same cell of the
+/// field map. A FieldCursor given to TRestAxionMagneticField::GetMagneticField remembers the volume and
+/// the nodes of the last cell, and they are only searched again when the position leaves them.
+///
+/// \code
+///    FieldCursor cursor;
+///    for (Double_t t = 0; t < length; t += 1)
+///        Bt.push_back(field->GetTransversalComponent(from + t * dir, dir, cursor));
+/// \endcode
+///
+/// ### Field gradient
+///
+/// The adaptive integration of the axion-photon conversion requires the local derivatives of the field.
+/// TRestAxionMagneticField::GetMagneticFieldAndGradient returns the field together with the matrix of
+/// its derivatives, obtained from the same nodes of the field map, instead of evaluating the field at
+/// neighbour positions.
+///
+/// \code
+///    TMatrixD gradient(3, 3);
+///    TVector3 b = field->GetMagneticFieldAndGradient(pos, gradient);
+///    Double_t dBydz = gradient(1, 2);  // T/mm
+/// \endcode
+///
+/// ### Evaluating the field from several threads
+///
+/// The volumes are loaded on demand, and some methods of this class modify the object, e.g. to build
+/// the field integral table or to draw the field. An immutable snapshot of the loaded volumes, with only
+/// const query methods, is obtained with TRestAxionMagneticField::GetEvaluator. The same evaluator can
+/// be used by any number of threads without locks, as described at TRestAxionFieldEvaluator. The query
+/// methods of this class are implemented by the same evaluator, so that both give the same field.
+///
+/// \code
+///    std::shared_ptr<const TRestAxionFieldEvaluator> evaluator = field->GetEvaluator();
+///    TVector3 b = evaluator->GetMagneticField(TVector3(0, 0, 100));
+/// \endcode
+///
+/// ### Analytic field models
+///
+/// A volume may be defined by the field of an ideal magnet, given in closed form by a few parameters,
+/// instead of a field map. The field is evaluated with a few floating point operations, and it takes no
+/// memory, so that a magnet geometry can be changed and evaluated again at no cost, e.g. when scanning
+/// the magnet length or the bore radius in a design study. The model is centered at the volume
+/// `position`, with the magnet axis along z, and the bounding box is given by `boundMax` and `meshSize`
+/// as for a constant field. The constant `field`, if given, is added to the model.
+///
+/// - *dipole* : A uniform transverse field, given by the x and y components of `modelField`, along the
+/// magnetic length `modelLength`. The field decreases at both ends as a tanh function with the length
+/// `modelFringe`, and the longitudinal component of the fringe fields is included.
+/// - *solenoid* : A solenoid along z of radius `modelRadius` and length `modelLength`. The z component
+/// of `modelField` is the field of an infinitely long solenoid, i.e. mu0 n I.
+/// - *multipole* : A transverse multipole expansion with the normal and skew coefficients, in T, at the
+/// reference radius `modelRadius`, given as comma separated lists by `modelNormal` and `modelSkew`. The
+/// first coefficient is the dipole, the second the quadrupole, and so on. The same longitudinal profile
+/// of the dipole is used.
+///
+/// A zero `modelLength` defines an infinitely long magnet, and a zero `modelFringe` a magnet ending
+/// abruptly. See TRestAxionFieldModel for the formulas used, and the validity of the approximations.
+///
+/// \code
+///    <addMagneticVolume model="dipole" modelField="(0,2.5,0)T" modelLength="10m" modelFringe="5cm"
+///                       boundMax="(350,350,5500)mm" meshSize="(10,10,50)mm" />
+///    <addMagneticVolume model="multipole" modelNormal="2.5,0,0.001" modelSkew="0,0.0005"
+///                       modelRadius="30mm" modelLength="10m" modelFringe="5cm" position="(0,0,12)m"
+///                       boundMax="(350,350,5500)mm" meshSize="(10,10,50)mm" />
+/// \endcode
+///
+/// The field integrals along a segment are obtained by a Gauss-Legendre quadrature, as described at
+/// TRestAxionFieldModel::Integrate, and the derivatives given by
+/// TRestAxionMagneticField::GetMagneticFieldAndGradient are exact.
+///
 /// ### Visualizing the magnetic field
 ///
 /// TODO Review and validate DrawHistogram drawing method and describe its
@@ -168,6 +450,28 @@
 /// 2020-April: Reviewing and validating TRestAxionMagneticField class.
 ///             Javier Galan and Krešimir Jakovčić
 ///
+/// 2026-October: Field maps stored in TRestAxionFieldGrid, with batched
+///               evaluation and a bounding volume hierarchy of the volumes.
+///               Javier Galan
+///
+/// 2026-October: Native grid files, shared between volumes and instances,
+///               with symmetric, cylindrical, reduced precision and tiled maps.
+///               Javier Galan
+///
+/// 2026-October: Exact field integrals, occupancy of the cells, axial sums
+///               and direction tables of the integrals.
+///               Javier Galan
+///
+/// 2026-October: Read-only field evaluator, field cursors and gradients.
+///               Javier Galan
+///
+/// 2026-October: Tricubic interpolation, analytic field models, multipole
+///               expansion and adaptive storage of the field maps.
+///               Javier Galan
+///
+/// 2026-October: Parallel loading of the volumes and of the field tables.
+///               Javier Galan
+///
 /// \class      TRestAxionMagneticField
 /// \author     Eve Pachoud
 /// \author     Javier Galan <javier.galan@unizar.es>
@@ -178,6 +482,16 @@
 
 #include "TRestAxionMagneticField.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 using namespace std;
 
 #include "TRestPhysics.h"
@@ -185,6 +499,175 @@ using namespace REST_Physics;
 
 ClassImp(TRestAxionMagneticField);
 
+namespace {
+/// It serializes the messages shown by the threads loading the volumes
+std::mutex& GetOutputMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+/// It returns the time, in ms, elapsed since `start`
+Double_t GetElapsedTime(chrono::steady_clock::time_point start) {
+    return chrono::duration<Double_t, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/// It splits the range [0,size) in `threads` consecutive parts, and it calls `function(part, begin, end)`
+/// for each part in its own thread. The first part is done by the calling thread
+template <typename F>
+void RunParallel(Int_t threads, size_t size, F function) {
+    threads = (Int_t)max((size_t)1, min((size_t)max(threads, 1), size));
+
+    std::vector<std::thread> workers;
+    for (Int_t t = 1; t < threads; t++)
+        workers.emplace_back(function, t, size * t / threads, size * (t + 1) / threads);
+    function(0, 0, size / threads);
+    for (auto& worker : workers) worker.join();
+}
+
+/// It finds, in a single pass done by `threads` threads, the minimum and the maximum value of the first 3
+/// columns of a table, and the lowest non-zero increase between consecutive rows, as given by
+/// TRestTools::GetMinValueFromTable, TRestTools::GetMaxValueFromTable and
+/// TRestTools::GetLowestIncreaseFromTable
+void ScanTable(const TRestAxionFieldTable& data, Int_t threads, Float_t* min, Float_t* max,
+               Float_t* increase) {
+    // The minimum, maximum and lowest increase found by each part
+    std::vector<std::array<Float_t, 9>> parts(std::max(threads, 1));
+    for (auto& part : parts) {
+        part.fill(0);
+        for (int c = 0; c < 3; c++) {
+            part[c] = numeric_limits<Float_t>::max();
+            part[3 + c] = numeric_limits<Float_t>::lowest();
+        }
+    }
+
+    RunParallel(threads, data.GetNumberOfRows(), [&](Int_t p, size_t begin, size_t end) {
+        std::array<Float_t, 9>& part = parts[p];
+        for (size_t n = begin; n < end; n++) {
+            for (int c = 0; c < 3; c++) {
+                part[c] = std::min(part[c], data[n][c]);
+                part[3 + c] = std::max(part[3 + c], data[n][c]);
+                if (n == 0) continue;
+                Float_t d = std::abs(data[n - 1][c] - data[n][c]);
+                if (d > 0 && (part[6 + c] == 0 || d < part[6 + c])) part[6 + c] = d;
+            }
+        }
+    });
+
+    for (int c = 0; c < 3; c++) {
+        min[c] = parts[0][c];
+        max[c] = parts[0][3 + c];
+        increase[c] = 0;
+        for (const auto& part : parts) {
+            min[c] = std::min(min[c], part[c]);
+            max[c] = std::max(max[c], part[3 + c]);
+            if (part[6 + c] > 0 && (increase[c] == 0 || part[6 + c] < increase[c])) increase[c] = part[6 + c];
+        }
+    }
+}
+
+/// It assigns the field of the rows of a table, x,y,z,Bx,By,Bz, to the nodes of `grid` given by
+/// `getNode(row, node)`, that returns false if the row is outside the grid. When a node is given by
+/// several rows, the last one defines its field, as if the rows were assigned in order. The rows outside
+/// the grid, and the rows replaced by a later row, are returned in increasing order.
+template <typename F>
+void ScatterTable(const TRestAxionFieldTable& data, TRestAxionFieldGrid& grid, F getNode, Int_t threads,
+                  std::vector<size_t>& outside, std::vector<size_t>& replaced) {
+    outside.clear();
+    replaced.clear();
+
+    // A single thread assigns the rows in order, keeping the last row assigned to each node
+    size_t nodes = grid.GetNumberOfNodes();
+    if (threads <= 1) {
+        std::vector<Long64_t> last(nodes, -1);
+        Int_t node[3];
+        for (size_t n = 0; n < data.GetNumberOfRows(); n++) {
+            if (!getNode(n, node)) {
+                outside.push_back(n);
+                continue;
+            }
+            size_t id = grid.GetIndex(node[0], node[1], node[2]) / TRestAxionFieldGrid::kComponents;
+            if (last[id] >= 0) replaced.push_back(last[id]);
+            last[id] = n;
+            grid.SetNode(node[0], node[1], node[2], data[n][3], data[n][4], data[n][5]);
+        }
+        sort(replaced.begin(), replaced.end());
+        return;
+    }
+
+    // Several threads find first the last row of each node
+    std::unique_ptr<std::atomic<Long64_t>[]> last(new std::atomic<Long64_t>[nodes]);
+    RunParallel(threads, nodes, [&](Int_t, size_t begin, size_t end) {
+        for (size_t id = begin; id < end; id++) last[id].store(-1, memory_order_relaxed);
+    });
+
+    RunParallel(threads, data.GetNumberOfRows(), [&](Int_t, size_t begin, size_t end) {
+        Int_t node[3];
+        for (size_t n = begin; n < end; n++) {
+            if (!getNode(n, node)) continue;
+            size_t id = grid.GetIndex(node[0], node[1], node[2]) / TRestAxionFieldGrid::kComponents;
+            Long64_t row = last[id].load(memory_order_relaxed);
+            while (row < (Long64_t)n && !last[id].compare_exchange_weak(row, n, memory_order_relaxed)) {
+            }
+        }
+    });
+
+    // The nodes are written once, by the last row, and each part keeps its own list of rows
+    std::vector<std::vector<size_t>> partOutside(threads), partReplaced(threads);
+    RunParallel(threads, data.GetNumberOfRows(), [&](Int_t part, size_t begin, size_t end) {
+        Int_t node[3];
+        for (size_t n = begin; n < end; n++) {
+            if (!getNode(n, node)) {
+                partOutside[part].push_back(n);
+                continue;
+            }
+            size_t id = grid.GetIndex(node[0], node[1], node[2]) / TRestAxionFieldGrid::kComponents;
+            if (last[id].load(memory_order_relaxed) != (Long64_t)n)
+                partReplaced[part].push_back(n);
+            else
+                grid.SetNode(node[0], node[1], node[2], data[n][3], data[n][4], data[n][5]);
+        }
+    });
+
+    for (unsigned int p = 0; p < partOutside.size(); p++) {
+        outside.insert(outside.end(), partOutside[p].begin(), partOutside[p].end());
+        replaced.insert(replaced.end(), partReplaced[p].begin(), partReplaced[p].end());
+    }
+}
+}  // namespace
+
+/// The field map of a volume while the volumes are being loaded
+struct TRestAxionMagneticField::FieldMapLoad {
+    /// The full path of the field map file
+    string filename;
+
+    /// The key of the field map at TRestAxionFieldMapRegistry
+    string mapKey;
+
+    /// The mirror symmetries defined at the RML
+    UInt_t symmetry = 0;
+
+    /// The volume that loads the same field map, or -1 if the map is loaded for this volume
+    Int_t source = -1;
+
+    /// True if the field map was read from a table, x,y,z,Bx,By,Bz
+    Bool_t table = false;
+
+    /// The minimum and the maximum value of the first 3 columns of the table
+    Float_t min[3] = {0, 0, 0}, max[3] = {0, 0, 0};
+
+    /// The lowest non-zero increase between consecutive rows of the first 3 columns of the table
+    Float_t increase[3] = {0, 0, 0};
+
+    /// The field map grid, in the reference system of the map
+    TRestAxionFieldGrid grid;
+
+    /// The time spent at each loading stage
+    FieldLoadTimes times;
+
+    /// The exit code if the field map could not be loaded, or 0
+    Int_t error = 0;
+};
+
 ///////////////////////////////////////////////
 /// \brief Default constructor
 ///
@@ -220,7 +703,6 @@ TRestAxionMagneticField::TRestAxionMagneticField(const char* cfgFileName, string
 ///
 TRestAxionMagneticField::~TRestAxionMagneticField() {
     debug << "Entering ... TRestAxionMagneticField() destructor." << endl;
-    for (int n = 0; n < fMagneticFieldVolumes.size(); n++) delete fMagneticFieldVolumes[n].bGas;
 }
 
 ///////////////////////////////////////////////
@@ -318,6 +800,11 @@ TCanvas* TRestAxionMagneticField::DrawHistogram(TString projection, TString Bcom
         return fCanvas;
     }
 
+    if (!(Bcomp == "X" || Bcomp == "Y" || Bcomp == "Z")) {
+        ferr << "You entered : " << Bcomp << " as a B component but you have to choose X, Y or Z" << endl;
+        return fCanvas;
+    }
+
     Double_t centerX = fPositions[volIndex][0];
     Double_t centerY = fPositions[volIndex][1];
     Double_t centerZ = fPositions[volIndex][2];
@@ -339,8 +826,14 @@ TCanvas* TRestAxionMagneticField::DrawHistogram(TString projection, TString Bcom
     Int_t nBinsZ = (zMax - zMin) / step_z;
 
     Double_t x, y, z;
-    Double_t B;
-    TVector3 Bvec;
+
+    // The field is evaluated at once for all the bins in one histogram column
+    Int_t nBinsMax = max(nBinsX, max(nBinsY, nBinsZ));
+    std::vector<Double_t> xs(nBinsMax), ys(nBinsMax), zs(nBinsMax);
+    std::vector<Double_t> bx(nBinsMax), by(nBinsMax), bz(nBinsMax);
+    Double_t* B = bz.data();
+    if (Bcomp == "X") B = bx.data();
+    if (Bcomp == "Y") B = by.data();
 
     if (projection == "XY") {
         fCanvas = new TCanvas("fCanvas", "");
@@ -358,23 +851,15 @@ TCanvas* TRestAxionMagneticField::DrawHistogram(TString projection, TString Bcom
         for (Int_t i = 0; i < nBinsX; i++) {
             y = yMin;
             for (Int_t j = 0; j < nBinsY; j++) {
-                Bvec = GetMagneticField(TVector3(x, y, z), false);
-                if (Bcomp == "X")
-                    B = Bvec[0];
-                else {
-                    if (Bcomp == "Y")
-                        B = Bvec[1];
-                    else {
-                        if (Bcomp == "Z")
-                            B = Bvec[2];
-                        else
-                            ferr << "You entered : " << Bcomp
-                                 << " as a B component but you have to choose X, Y or Z" << endl;
-                    }
-                }
-                fHisto->Fill(x, y, B);
+                xs[j] = x;
+                ys[j] = y;
+                zs[j] = z;
                 y = y + step_y;
             }
+
+            GetMagneticField(nBinsY, xs.data(), ys.data(), zs.data(), bx.data(), by.data(), bz.data(),
+                             false);
+            for (Int_t j = 0; j < nBinsY; j++) fHisto->Fill(xs[j], ys[j], B[j]);
             x = x + step_x;
         }
 
@@ -419,23 +904,15 @@ TCanvas* TRestAxionMagneticField::DrawHistogram(TString projection, TString Bcom
         for (Int_t i = 0; i < nBinsX; i++) {
             z = zMin;
             for (Int_t j = 0; j < nBinsZ; j++) {
-                Bvec = GetMagneticField(TVector3(x, y, z), false);
-                if (Bcomp == "X")
-                    B = Bvec[0];
-                else {
-                    if (Bcomp == "Y")
-                        B = Bvec[1];
-                    else {
-                        if (Bcomp == "Z")
-                            B = Bvec[2];
-                        else
-                            ferr << "You entered : " << Bcomp
-                                 << " as a B component but you have to choose X, Y or Z" << endl;
-                    }
-                }
-                fHisto->Fill(x, z, B);
+                xs[j] = x;
+                ys[j] = y;
+                zs[j] = z;
                 z = z + step_z;
             }
+
+            GetMagneticField(nBinsZ, xs.data(), ys.data(), zs.data(), bx.data(), by.data(), bz.data(),
+                             false);
+            for (Int_t j = 0; j < nBinsZ; j++) fHisto->Fill(xs[j], zs[j], B[j]);
             x = x + step_x;
         }
 
@@ -480,23 +957,15 @@ TCanvas* TRestAxionMagneticField::DrawHistogram(TString projection, TString Bcom
         for (Int_t i = 0; i < nBinsY; i++) {
             z = zMin;
             for (Int_t j = 0; j < nBinsZ; j++) {
-                Bvec = GetMagneticField(TVector3(x, y, z), false);
-                if (Bcomp == "X")
-                    B = Bvec[0];
-                else {
-                    if (Bcomp == "Y")
-                        B = Bvec[1];
-                    else {
-                        if (Bcomp == "Z")
-                            B = Bvec[2];
-                        else
-                            ferr << "You entered : " << Bcomp
-                                 << " as a B component but you have to choose X, Y or Z" << endl;
-                    }
-                }
-                fHisto->Fill(y, z, B);
+                xs[j] = x;
+                ys[j] = y;
+                zs[j] = z;
                 z = z + step_z;
             }
+
+            GetMagneticField(nBinsZ, xs.data(), ys.data(), zs.data(), bx.data(), by.data(), bz.data(),
+                             false);
+            for (Int_t j = 0; j < nBinsZ; j++) fHisto->Fill(ys[j], zs[j], B[j]);
             y = y + step_y;
         }
 
@@ -532,66 +1001,318 @@ TCanvas* TRestAxionMagneticField::DrawHistogram(TString projection, TString Bcom
 /// \brief A method to help loading magnetic field data, as x,y,z,Bx,By,Bz into a magnetic volume definition
 /// using its corresponding mesh.
 ///
+/// The field grid is created in the reference system of the field map, centered at zero. The volume
+/// position must be applied later on using TRestAxionFieldGrid::Translate.
+///
+/// The rows are assigned to the grid nodes by `threads` threads. If a node is given by several rows, the
+/// last one defines its field, and a warning is shown if the field of a previous row was not zero.
+///
 /// This method will be made private since it will only be used internally.
 ///
 void TRestAxionMagneticField::LoadMagneticFieldData(MagneticFieldVolume& mVol,
-                                                    std::vector<std::vector<Float_t>> data) {
-    mVol.field.resize(mVol.mesh.GetNodesX());
-    for (int n = 0; n < mVol.field.size(); n++) {
-        mVol.field[n].resize(mVol.mesh.GetNodesY());
-        for (int m = 0; m < mVol.field[n].size(); m++) mVol.field[n][m].resize(mVol.mesh.GetNodesZ());
+                                                    const TRestAxionFieldTable& data, Int_t threads) {
+    Int_t nodesX = mVol.mesh.GetNodesX();
+    Int_t nodesY = mVol.mesh.GetNodesY();
+    Int_t nodesZ = mVol.mesh.GetNodesZ();
+
+    TVector3 spacing(mVol.mesh.GetNetSizeX() / (nodesX > 1 ? nodesX - 1 : 1),
+                     mVol.mesh.GetNetSizeY() / (nodesY > 1 ? nodesY - 1 : 1),
+                     mVol.mesh.GetNetSizeZ() / (nodesZ > 1 ? nodesZ - 1 : 1));
+    TVector3 size(mVol.mesh.GetNetSizeX(), mVol.mesh.GetNetSizeY(), mVol.mesh.GetNetSizeZ());
+    TVector3 origin = -0.5 * size;
+    mVol.field.Allocate(nodesX, nodesY, nodesZ, origin, spacing);
+
+    // The magnetic field map is centered at zero. But the mesh definition contains the offset position.
+    // We shift the data to match the mesh node network.
+    auto getNode = [&](size_t n, Int_t* node) {
+        node[0] = (Int_t)round((data[n][0] + mVol.mesh.GetNetSizeX() / 2.) / spacing.X());
+        node[1] = (Int_t)round((data[n][1] + mVol.mesh.GetNetSizeY() / 2.) / spacing.Y());
+        node[2] = (Int_t)round((data[n][2] + mVol.mesh.GetNetSizeZ() / 2.) / spacing.Z());
+        return node[0] >= 0 && node[0] < nodesX && node[1] >= 0 && node[1] < nodesY && node[2] >= 0 &&
+               node[2] < nodesZ;
+    };
+
+    std::vector<size_t> outside, replaced;
+    ScatterTable(data, mVol.field, getNode, threads, outside, replaced);
+
+    lock_guard<mutex> lock(GetOutputMutex());
+    debug << "TRestAxionMagneticField::LoadMagneticFieldData. Printing first 5 data rows" << endl;
+    for (size_t n = 0; n < 5 && n < data.GetNumberOfRows(); n++) {
+        Int_t node[3];
+        getNode(n, node);
+        debug << "X: " << data[n][0] << " Y: " << data[n][1] << " Z: " << data[n][2] << endl;
+        debug << "absX: " << data[n][0] + mVol.position.X() << " absY: " << data[n][1] + mVol.position.Y()
+              << " absZ: " << data[n][2] + mVol.position.Z() << endl;
+        debug << "nX: " << node[0] << " nY: " << node[1] << " nZ: " << node[2] << endl;
+        debug << "Bx: " << data[n][3] << " By: " << data[n][4] << " Bz: " << data[n][5] << endl;
+        if (GetVerboseLevel() >= REST_Extreme) GetChar();
     }
 
-    debug << "TRestAxionMagneticField::LoadMagneticFieldData. Printing first 5 data rows" << endl;
-    for (Int_t n = 0; n < data.size(); n++) {
-        // The magnetic field map is centered at zero.
-        // But the mesh definition contains the offset position
-        // We shift the data to match the mesh node network.
-        Int_t nX = mVol.mesh.GetNodeX((Int_t)(data[n][0] + mVol.mesh.GetNetSizeX() / 2.), true);
-        Int_t nY = mVol.mesh.GetNodeY((Int_t)(data[n][1] + mVol.mesh.GetNetSizeY() / 2.), true);
-        Int_t nZ = mVol.mesh.GetNodeZ((Int_t)(data[n][2] + mVol.mesh.GetNetSizeZ() / 2.), true);
-
-        if (n < 5) {
-            debug << "X: " << data[n][0] << " Y: " << data[n][1] << " Z: " << data[n][2] << endl;
-            debug << "absX: " << data[n][0] + mVol.position.X() << " absY: " << data[n][1] + mVol.position.Y()
-                  << " absZ: " << data[n][2] + mVol.position.Z() << endl;
-            debug << "nX: " << nX << " nY: " << nY << " nZ: " << nZ << endl;
-            debug << "Bx: " << data[n][3] << " By: " << data[n][4] << " Bz: " << data[n][5] << endl;
-            if (GetVerboseLevel() >= REST_Extreme) GetChar();
+    for (size_t n : outside) {
+        Int_t node[3];
+        getNode(n, node);
+        warning << "X: " << data[n][0] << " Y: " << data[n][1] << " Z: " << data[n][2] << endl;
+        warning << "nX: " << node[0] << " nY: " << node[1] << " nZ: " << node[2] << endl;
+        warning << "WARNING: the data point is outside the mesh node network!" << endl << endl;
+
+        this->SetError("There was a problem assigning the field matrix!");
+    }
+
+    for (size_t n : replaced) {
+        if (data[n][3] == 0 && data[n][4] == 0 && data[n][5] == 0) continue;
+
+        Int_t node[3];
+        getNode(n, node);
+        TVector3 b = mVol.field.GetNodeField(node[0], node[1], node[2]);
+        warning << "X: " << data[n][0] << " Y: " << data[n][1] << " Z: " << data[n][2] << endl;
+        warning << "nX: " << node[0] << " nY: " << node[1] << " nZ: " << node[2] << endl;
+        warning << "WARNING: field[nX][nY][nZ] element defined more than once !!" << endl;
+        warning << "Value replaced: "
+                << "Bx: " << data[n][3] << " By: " << data[n][4] << " Bz: " << data[n][5] << endl;
+        warning << "Last value written: "
+                << "mVol.field[" << node[0] << "][" << node[1] << "][" << node[2] << "] = (" << b.X()
+                << " , " << b.Y() << " , " << b.Z() << ")" << endl
+                << endl;
+
+        this->SetError("There was a problem assigning the field matrix!");
+        if (GetVerboseLevel() >= REST_Extreme) GetChar();
+    }
+
+    debug << "Field map memory size : " << mVol.field.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief A method to help loading magnetic field data given in cylindrical coordinates, as r, phi, z,
+/// Br, Bphi, Bz, into a cylindrical grid.
+///
+/// The grid axis is placed at the center of the field map. If the phi nodes do not include the value at
+/// 2 pi, the first phi node is repeated at the end of the grid, so that the interpolation can go across
+/// the full turn. The nodes are defined by the ranges and the lowest increases of the table columns,
+/// found at `load`, and the rows are assigned to the nodes by `threads` threads.
+///
+/// It returns false if the phi nodes do not cover a full turn.
+///
+/// This method will be made private since it will only be used internally.
+///
+Bool_t TRestAxionMagneticField::LoadCylindricalFieldData(MagneticFieldVolume& mVol,
+                                                         const TRestAxionFieldTable& data,
+                                                         const FieldMapLoad& load, Int_t threads) {
+    Double_t first[3], spacing[3];
+    Int_t nodes[3];
+    for (int k = 0; k < 3; k++) {
+        first[k] = load.min[k];
+        spacing[k] = load.increase[k];
+        Double_t last = load.max[k];
+        nodes[k] = spacing[k] > 0 ? (Int_t)round((last - first[k]) / spacing[k]) + 1 : 1;
+    }
+
+    // The phi nodes must cover a full turn. We add the closing node if it is not in the table
+    Int_t phiNodes = nodes[1];
+    if (nodes[1] > 1) {
+        Double_t turn = (nodes[1] - 1) * spacing[1];
+        if (fabs(turn + spacing[1] - 2 * M_PI) < 1.e-3 * spacing[1]) {
+            phiNodes = nodes[1] + 1;
+        } else if (fabs(turn - 2 * M_PI) > 1.e-3 * spacing[1]) {
+            lock_guard<mutex> lock(GetOutputMutex());
+            ferr << "TRestAxionMagneticField::LoadCylindricalFieldData." << endl;
+            ferr << "The phi nodes do not cover a full turn!" << endl;
+            ferr << "Phi spacing : " << spacing[1] << " Phi nodes : " << nodes[1] << endl;
+            return false;
         }
+    }
 
-        if (mVol.field[nX][nY][nZ] != TVector3(0.0, 0.0, 0.0)) {
-            warning << "X: " << data[n][0] << " Y: " << data[n][1] << " Z: " << data[n][2] << endl;
-            warning << "nX: " << nX << " nY: " << nY << " nZ: " << nZ << endl;
-            warning << "WARNING: field[nX][nY][nZ] element not equal to initial value (0, 0, 0) !!" << endl;
-            warning << "It has value: "
-                    << "mVol.field[" << nX << "][" << nY << "][" << nZ << "] = ("
-                    << mVol.field[nX][nY][nZ].X() << " , " << mVol.field[nX][nY][nZ].Y() << " , "
-                    << mVol.field[nX][nY][nZ].Z() << ")" << endl;
-            warning << "Values to write: "
-                    << "Bx: " << data[n][3] << " By: " << data[n][4] << " Bz: " << data[n][5] << endl
-                    << endl;
+    mVol.field.Allocate(nodes[0], phiNodes, nodes[2], TVector3(first[0], first[1], first[2]),
+                        TVector3(spacing[0], spacing[1], spacing[2]));
+    mVol.field.SetCylindrical(0, 0);
+
+    auto getNode = [&](size_t n, Int_t* i) {
+        for (int k = 0; k < 3; k++)
+            i[k] = nodes[k] > 1 ? (Int_t)round((data[n][k] - first[k]) / spacing[k]) : 0;
+        return i[0] >= 0 && i[0] < nodes[0] && i[1] >= 0 && i[1] < nodes[1] && i[2] >= 0 && i[2] < nodes[2];
+    };
+
+    std::vector<size_t> outside, replaced;
+    ScatterTable(data, mVol.field, getNode, threads, outside, replaced);
+
+    if (phiNodes > nodes[1]) {
+        for (Int_t r = 0; r < nodes[0]; r++)
+            for (Int_t z = 0; z < nodes[2]; z++) {
+                const Double_t* b = mVol.field.GetNode(r, 0, z);
+                mVol.field.SetNode(r, nodes[1], z, b[0], b[1], b[2]);
+            }
+    }
+
+    lock_guard<mutex> lock(GetOutputMutex());
+    for (size_t n : outside) {
+        warning << "r: " << data[n][0] << " phi: " << data[n][1] << " z: " << data[n][2] << endl;
+        warning << "WARNING: the data point is outside the cylindrical grid!" << endl << endl;
+
+        this->SetError("There was a problem assigning the field matrix!");
+    }
+
+    debug << "Cylindrical grid nodes : (" << nodes[0] << ", " << phiNodes << ", " << nodes[2] << ")" << endl;
+    debug << "Field map memory size : " << mVol.field.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the mesh of the volume `n`, with half size `boundMax` and node spacing `meshSize`,
+/// centered at the volume position.
+///
+/// This method will be made private since it will only be used internally.
+///
+TRestMesh TRestAxionMagneticField::GetVolumeMesh(Int_t n, TVector3 boundMax, TVector3 meshSize) {
+    // The values come from the single precision tables, and the number of nodes is computed as such
+    Float_t xMax = boundMax.X(), yMax = boundMax.Y(), zMax = boundMax.Z();
+    Float_t meshSizeX = meshSize.X(), meshSizeY = meshSize.Y(), meshSizeZ = meshSize.Z();
+
+    // Number of nodes
+    Int_t nx = (Int_t)(2 * xMax / meshSizeX) + 1;
+    Int_t ny = (Int_t)(2 * yMax / meshSizeY) + 1;
+    Int_t nz = (Int_t)(2 * zMax / meshSizeZ) + 1;
+
+    // We create an auxiliar mesh helping to initialize the fieldMap
+    // The mesh is centered at zero. Absolute position is defined in the Magnetic volume
+    // The field map itself is stored in cylindrical coordinates when gridType="cylindrical"
+    Bool_t cylindricalGrid = n < fGridTypes.size() && fGridTypes[n] == "cylindrical";
+    TRestMesh restMesh;
+    restMesh.SetSize(2 * xMax, 2 * yMax, 2 * zMax);
+    restMesh.SetOrigin(fPositions[n] - TVector3(xMax, yMax, zMax));
+    restMesh.SetNodes(nx, ny, nz);
+    if (fMeshType[n] == "cylinder" || cylindricalGrid)
+        restMesh.SetCylindrical(true);
+    else
+        restMesh.SetCylindrical(false);
+
+    return restMesh;
+}
+
+///////////////////////////////////////////////
+/// \brief It loads the field map file of the volume `n` into `load.grid`, and it builds the storage and the
+/// derived data of the grid defined at the RML. A table is assigned to the grid nodes by `threads` threads.
+///
+/// It can be called at the same time by several threads for different volumes. The messages are
+/// serialized, and the exit code is returned at `load.error`, instead of exiting, so that the errors are
+/// reported in the order of the volumes.
+///
+/// This method will be made private since it will only be used internally.
+///
+void TRestAxionMagneticField::LoadFieldMap(Int_t n, FieldMapLoad& load, Int_t threads) {
+    const string& fullPathName = load.filename;
+    {
+        lock_guard<mutex> lock(GetOutputMutex());
+        debug << "Volume : " << n << ". Loading file : " << fullPathName << endl;
+    }
+
+    auto start = chrono::steady_clock::now();
+    TRestAxionFieldTable fieldData;
+    if (fullPathName.find(".dat") != string::npos) {
+        if (!fieldData.ReadASCII(fullPathName, threads)) load.error = 1;
+    } else if (fullPathName.find(".bin") != string::npos) {
+        std::vector<std::vector<Float_t>> binaryData;
+        if (!TRestTools::ReadBinaryTable(fullPathName, binaryData, 6))
+            load.error = 2;
+        else
+            fieldData.SetRows(binaryData);
+    } else if (fullPathName.find(".grid") != string::npos || fullPathName.find(".tgrid") != string::npos) {
+        size_t cacheSize = TRestAxionFieldGrid::kDefaultCacheSize;
+        if (n < fCacheSizes.size()) cacheSize = (size_t)(fCacheSizes[n] * 1024 * 1024);
+        if (!load.grid.MapFile(fullPathName, TVector3(0, 0, 0), cacheSize)) {
+            load.error = 2;
+        } else if (load.symmetry != 0 && load.symmetry != load.grid.GetSymmetry()) {
+            lock_guard<mutex> lock(GetOutputMutex());
+            warning << "Volume : " << n << endl;
+            warning << "The symmetry defined in RML does not match the symmetry of the grid file!" << endl;
+            warning << "The symmetry stored in the grid file will be used" << endl;
+        }
+    } else {
+        load.error = 3;
+    }
+    load.times.read = GetElapsedTime(start);
+
+    size_t rows = fieldData.GetNumberOfRows();
+    if (load.error == 0 && rows < 2 && load.grid.GetNumberOfNodes() < 2) load.error = 4;
+    if (load.error != 0) return;
+
+    if (rows > 0) {
+        load.table = true;
+
+        start = chrono::steady_clock::now();
+        ScanTable(fieldData, threads, load.min, load.max, load.increase);
+        load.times.scan = GetElapsedTime(start);
+
+        if (GetVerboseLevel() >= REST_Debug) {
+            lock_guard<mutex> lock(GetOutputMutex());
+            debug << "Printing beginning of magnetic file table : " << rows << endl;
+            for (size_t row = 0; row < 5 && row < rows; row++)
+                debug << fieldData[row][0] << "\t" << fieldData[row][1] << "\t" << fieldData[row][2] << "\t"
+                      << fieldData[row][3] << "\t" << fieldData[row][4] << "\t" << fieldData[row][5] << endl;
+        }
 
-            this->SetError("There was a problem assigning the field matrix!");
-            if (GetVerboseLevel() >= REST_Extreme) GetChar();
+        start = chrono::steady_clock::now();
+        MagneticFieldVolume volume;
+        volume.position = fPositions[n];
+        if (n < fGridTypes.size() && fGridTypes[n] == "cylindrical") {
+            if (!LoadCylindricalFieldData(volume, fieldData, load, threads)) {
+                load.error = 6;
+                return;
+            }
+        } else {
+            volume.mesh = GetVolumeMesh(n, TVector3(load.max[0], load.max[1], load.max[2]),
+                                        TVector3(load.increase[0], load.increase[1], load.increase[2]));
+            LoadMagneticFieldData(volume, fieldData, threads);
         }
+        load.grid = volume.field;
+        load.times.fill = GetElapsedTime(start);
+
+        // The table is not needed anymore
+        fieldData.Clear();
+    }
 
-        mVol.field[nX][nY][nZ] = TVector3(data[n][3], data[n][4], data[n][5]);
+    start = chrono::steady_clock::now();
+    if (load.table && load.symmetry != 0 && !load.grid.SetSymmetry(load.symmetry)) {
+        lock_guard<mutex> lock(GetOutputMutex());
+        warning << "Volume : " << n << endl;
+        warning << "The field map has no node at zero along a symmetric axis!" << endl;
+        warning << "The symmetry will not be applied" << endl;
     }
+    SetFieldPrecision(n, load.grid);
+    SetFieldLayout(n, load.grid);
+    SetFieldAdaptive(n, load.grid);
+    SetFieldInterpolation(n, load.grid);
+    SetFieldMultipoles(n, load.grid);
+    load.grid.BuildOccupancy();
+    if (fUseAxialSums) load.grid.BuildAxialSums();
+    load.times.build = GetElapsedTime(start);
 }
 
 ///////////////////////////////////////////////
 /// \brief It will load the magnetic field data from the data filenames specified at the RML definition.
 ///
+/// The field maps are loaded in parallel, each one by its own thread, using in total the number of threads
+/// given by the `loadThreads` parameter. The threads left are used to assign each table to the grid nodes.
+/// A field map used by several volumes is loaded only once. The volumes are then defined in order.
+///
 /// This method will be made private since it will only be used internally.
 ///
 void TRestAxionMagneticField::LoadMagneticVolumes() {
+    auto start = chrono::steady_clock::now();
+    fDirectionTable.Clear();
+    fDirectionTableTooLarge = false;
+    fEvaluator.reset();
+
+    // The field maps that must be loaded from their files. A field map that was already loaded, or that is
+    // loaded for a previous volume, is shared
+    std::vector<FieldMapLoad> loads(fPositions.size());
+    std::vector<Int_t> pending;
     for (unsigned int n = 0; n < fPositions.size(); n++) {
+        FieldMapLoad& load = loads[n];
         string fullPathName = SearchFile((string)fFileNames[n]);
         debug << "Reading file : " << fFileNames[n] << endl;
         debug << "Full path : " << fullPathName << endl;
 
-        if (fFileNames[n] != "none" && fullPathName == "") {
+        if (fFileNames[n] == "none") continue;
+        if (fullPathName == "") {
             ferr << "TRestAxionMagneticField::LoadMagneticVolumes. File " << fFileNames[n] << " not found!"
                  << endl;
             ferr << "REST will look for this file at any path given by <searchPath at globals definitions"
@@ -599,46 +1320,111 @@ void TRestAxionMagneticField::LoadMagneticVolumes() {
             exit(5);
         }
 
-        std::vector<std::vector<Float_t>> fieldData;
-        if (fFileNames[n] != "none")
-            if (fullPathName.find(".dat") != string::npos) {
-                debug << "Reading ASCII format" << endl;
-                if (!TRestTools::ReadASCIITable(fullPathName, fieldData)) {
-                    ferr << "Problem reading file : " << fullPathName << endl;
-                    exit(1);
-                }
-            } else {
-                if (fullPathName.find(".bin") != string::npos) {
-                    debug << "Reading binary format" << endl;
-                    if (!TRestTools::ReadBinaryTable(fullPathName, fieldData, 6)) {
-                        ferr << "Problem reading file : " << fullPathName << endl;
-                        exit(2);
-                    }
-                }
+        load.filename = fullPathName;
+        load.symmetry = GetSymmetryFlags(n < fSymmetries.size() ? fSymmetries[n] : "");
+
+        string& mapKey = load.mapKey;
+        mapKey = TRestAxionFieldMapRegistry::GetKey(fullPathName);
+        if (!mapKey.empty()) mapKey += ":" + std::to_string(load.symmetry);
+
+        Bool_t cylindricalGrid = n < fGridTypes.size() && fGridTypes[n] == "cylindrical";
+        if (!mapKey.empty() && cylindricalGrid) mapKey += ":cylindrical";
+        if (!mapKey.empty() && n < fPrecisions.size()) mapKey += ":" + (string)fPrecisions[n];
+        if (!mapKey.empty() && n < fLayouts.size()) mapKey += ":" + (string)fLayouts[n];
+        if (!mapKey.empty() && n < fAdaptiveTolerances.size() && fAdaptiveTolerances[n] > 0)
+            mapKey += ":adaptive:" + std::to_string(fAdaptiveTolerances[n]);
+        if (!mapKey.empty() && n < fInterpolations.size()) mapKey += ":" + (string)fInterpolations[n];
+        Bool_t mappedGrid =
+            fullPathName.find(".grid") != string::npos || fullPathName.find(".tgrid") != string::npos;
+        if (!mapKey.empty() && mappedGrid && n < fCacheSizes.size())
+            mapKey += ":cache:" + std::to_string(fCacheSizes[n]);
+        if (!mapKey.empty() && n < fMultipoleOrders.size() && fMultipoleOrders[n] > 0)
+            mapKey += ":" + std::to_string(fMultipoleOrders[n]) + ":" + std::to_string(fMultipoleRadii[n]) +
+                      ":" + std::to_string(fMultipoleTolerances[n]);
+
+        for (unsigned int m = 0; m < n && load.source < 0 && !mapKey.empty(); m++)
+            if (loads[m].mapKey == mapKey) load.source = m;
+
+        if (load.source >= 0) {
+            debug << "The field map is loaded for volume " << load.source << ". It will be shared" << endl;
+        } else if (TRestAxionFieldMapRegistry::Find(mapKey, load.grid)) {
+            debug << "The field map was already loaded. It will be shared" << endl;
+            if (fUseAxialSums && !load.grid.HasAxialSums()) {
+                load.grid.BuildAxialSums();
+                TRestAxionFieldMapRegistry::Add(mapKey, load.grid);
             }
-        else if (fFileNames[n] != "none") {
-            ferr << "Filename : " << fullPathName << endl;
-            ferr << "File format not recognized!" << endl;
-            exit(3);
+        } else {
+            pending.push_back(n);
         }
+    }
 
-        if (fFileNames[n] != "none" && fieldData.size() < 2) {
+    // The threads are distributed between the field maps, and each map uses its threads to fill the grid
+    Int_t threads = fLoadThreads > 0 ? fLoadThreads : max((Int_t)thread::hardware_concurrency(), 1);
+    Int_t mapThreads = min(threads, (Int_t)pending.size());
+    Int_t fillThreads = max(threads / max(mapThreads, 1), 1);
+
+    std::atomic<size_t> next(0);
+    RunParallel(mapThreads, pending.size(), [&](Int_t, size_t, size_t) {
+        for (size_t p = next++; p < pending.size(); p = next++)
+            LoadFieldMap(pending[p], loads[pending[p]], fillThreads);
+    });
+
+    for (Int_t n : pending) {
+        const FieldMapLoad& load = loads[n];
+        if (load.error == 1 || load.error == 2) {
+            ferr << "Problem reading file : " << load.filename << endl;
+            exit(load.error);
+        } else if (load.error == 3) {
+            ferr << "Filename : " << load.filename << endl;
+            ferr << "File format not recognized!" << endl;
+            exit(3);
+        } else if (load.error == 4) {
             ferr << "Field data size is no more than 2 grid points!" << endl;
-            ferr << "Filename : " << fullPathName << endl;
+            ferr << "Filename : " << load.filename << endl;
             ferr << "Probably something went wrong loading the file" << endl;
             exit(4);
+        } else if (load.error != 0) {
+            exit(load.error);
         }
 
+        debug << "Volume : " << n << endl;
+        debug << "Stored field map size : " << load.grid.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+        TRestAxionFieldMapRegistry::Add(load.mapKey, load.grid);
+    }
+
+    fLoadTimes.clear();
+    for (unsigned int n = 0; n < fPositions.size(); n++) {
+        const FieldMapLoad& load = loads[n];
+
+        // The field map grid, in the reference system of the map
+        const TRestAxionFieldGrid& fieldGrid = load.source >= 0 ? loads[load.source].grid : load.grid;
+        Bool_t table = load.source < 0 && load.table;
+        Bool_t cylindricalGrid = n < fGridTypes.size() && fGridTypes[n] == "cylindrical";
+
         Float_t xMin = -fBoundMax[n].X(), yMin = -fBoundMax[n].Y(), zMin = -fBoundMax[n].Z();
         Float_t xMax = fBoundMax[n].X(), yMax = fBoundMax[n].Y(), zMax = fBoundMax[n].Z();
         Float_t meshSizeX = fMeshSize[n].X(), meshSizeY = fMeshSize[n].Y(), meshSizeZ = fMeshSize[n].Z();
 
         // If a field map is defined we get the boundaries, and mesh size from the volume
-        if (fieldData.size() > 0) {
+        if (!fieldGrid.IsEmpty()) {
             debug << "Reading max boundary values" << endl;
-            xMax = TRestTools::GetMaxValueFromTable(fieldData, 0);
-            yMax = TRestTools::GetMaxValueFromTable(fieldData, 1);
-            zMax = TRestTools::GetMaxValueFromTable(fieldData, 2);
+            if (table && cylindricalGrid) {
+                // The bounding box of a cylindrical map is given by the maximum radius
+                xMax = yMax = load.max[0];
+                zMax = load.max[2];
+            } else if (table) {
+                xMax = load.max[0];
+                yMax = load.max[1];
+                zMax = load.max[2];
+            } else if (fieldGrid.IsCylindrical()) {
+                xMax = yMax = fieldGrid.GetUpperBound(0);
+                zMax = fieldGrid.GetUpperBound(2);
+            } else {
+                // The grid gives directly the boundaries, there is no need to scan the data
+                xMax = fieldGrid.GetUpperBound(0);
+                yMax = fieldGrid.GetUpperBound(1);
+                zMax = fieldGrid.GetUpperBound(2);
+            }
 
             if (fBoundMax[n] != TVector3(0, 0, 0)) {
                 if (fBoundMax[n] != TVector3(xMax, yMax, zMax)) {
@@ -651,9 +1437,19 @@ void TRestAxionMagneticField::LoadMagneticVolumes() {
             }
 
             debug << "Reading min boundary values" << endl;
-            xMin = TRestTools::GetMinValueFromTable(fieldData, 0);
-            yMin = TRestTools::GetMinValueFromTable(fieldData, 1);
-            zMin = TRestTools::GetMinValueFromTable(fieldData, 2);
+            if (cylindricalGrid || fieldGrid.IsCylindrical()) {
+                xMin = -xMax;
+                yMin = -yMax;
+                zMin = table ? load.min[2] : fieldGrid.GetLowerBound(2);
+            } else if (table) {
+                xMin = load.min[0];
+                yMin = load.min[1];
+                zMin = load.min[2];
+            } else {
+                xMin = fieldGrid.GetLowerBound(0);
+                yMin = fieldGrid.GetLowerBound(1);
+                zMin = fieldGrid.GetLowerBound(2);
+            }
 
             if (fBoundMax[n] != TVector3(0, 0, 0)) {
                 if (-fBoundMax[n] != TVector3(xMin, yMin, zMin)) {
@@ -667,9 +1463,21 @@ void TRestAxionMagneticField::LoadMagneticVolumes() {
             fBoundMax[n] = TVector3(xMax, yMax, zMax);
 
             debug << "Reading mesh size" << endl;
-            meshSizeX = TRestTools::GetLowestIncreaseFromTable(fieldData, 0);
-            meshSizeY = TRestTools::GetLowestIncreaseFromTable(fieldData, 1);
-            meshSizeZ = TRestTools::GetLowestIncreaseFromTable(fieldData, 2);
+            if (table && cylindricalGrid) {
+                meshSizeX = meshSizeY = load.increase[0];
+                meshSizeZ = load.increase[2];
+            } else if (fieldGrid.IsCylindrical()) {
+                meshSizeX = meshSizeY = fieldGrid.GetSpacing(0);
+                meshSizeZ = fieldGrid.GetSpacing(2);
+            } else if (table) {
+                meshSizeX = load.increase[0];
+                meshSizeY = load.increase[1];
+                meshSizeZ = load.increase[2];
+            } else {
+                meshSizeX = fieldGrid.GetSpacing(0);
+                meshSizeY = fieldGrid.GetSpacing(1);
+                meshSizeZ = fieldGrid.GetSpacing(2);
+            }
 
             if (fMeshSize[n] != TVector3(0, 0, 0)) {
                 if (fMeshSize[n] != TVector3(meshSizeX, meshSizeY, meshSizeZ)) {
@@ -688,7 +1496,7 @@ void TRestAxionMagneticField::LoadMagneticVolumes() {
             debug << "Reading magnetic field map" << endl;
             debug << "--------------------------" << endl;
 
-            debug << "Full path : " << fullPathName << endl;
+            debug << "Full path : " << load.filename << endl;
 
             debug << "Boundaries" << endl;
             debug << "xMin: " << xMin << " yMin: " << yMin << " zMin: " << zMin << endl;
@@ -697,44 +1505,32 @@ void TRestAxionMagneticField::LoadMagneticVolumes() {
 
             debug << "sX: " << meshSizeX << " sY: " << meshSizeY << " sZ: " << meshSizeZ << endl;
 
-            if (fieldData.size() > 4) {
-                debug << "Printing beginning of magnetic file table : " << fieldData.size() << endl;
-                TRestTools::PrintTable(fieldData, 0, 5);
-            } else {
-                debug << "The data file contains no field map" << endl;
-            }
+            debug << "Loading times. Read : " << load.times.read << " ms, scan : " << load.times.scan
+                  << " ms, fill : " << load.times.fill << " ms, build : " << load.times.build << " ms"
+                  << endl;
         }
         if (GetVerboseLevel() >= REST_Extreme) GetChar();
 
-        // Number of nodes
-        Int_t nx = (Int_t)(2 * xMax / meshSizeX) + 1;
-        Int_t ny = (Int_t)(2 * yMax / meshSizeY) + 1;
-        Int_t nz = (Int_t)(2 * zMax / meshSizeZ) + 1;
-
-        // We create an auxiliar mesh helping to initialize the fieldMap
-        // The mesh is centered at zero. Absolute position is defined in the Magnetic volume
-        // TODO It would be interesting that TRestMesh could be used in cylindrical coordinates.
-        TRestMesh restMesh;
-        restMesh.SetSize(2 * xMax, 2 * yMax, 2 * zMax);
-        restMesh.SetOrigin(fPositions[n] - TVector3(xMax, yMax, zMax));
-        restMesh.SetNodes(nx, ny, nz);
-        if (fMeshType[n] == "cylinder")
-            restMesh.SetCylindrical(true);
-        else
-            restMesh.SetCylindrical(false);
-
         MagneticFieldVolume mVolume;
         mVolume.position = fPositions[n];
-        mVolume.mesh = restMesh;
+        mVolume.mesh =
+            GetVolumeMesh(n, TVector3(xMax, yMax, zMax), TVector3(meshSizeX, meshSizeY, meshSizeZ));
 
-        if (mVolume.bGas == NULL) mVolume.bGas = new TRestAxionBufferGas();
+        mVolume.bGas = std::make_shared<TRestAxionBufferGas>();
         if (fGasMixtures[n] != "vacuum") {
             debug << "Setting gas mixture: " << fGasMixtures[n] << endl;
             debug << "Densities: " << fGasDensities[n] << endl;
             mVolume.bGas->SetGasMixture(fGasMixtures[n], fGasDensities[n]);
         }
 
-        if (fieldData.size() > 0) LoadMagneticFieldData(mVolume, fieldData);
+        if (!fieldGrid.IsEmpty()) {
+            // The loaded, mapped or shared grid is used directly as the field storage, no copy is done
+            mVolume.field = fieldGrid;
+            mVolume.field.SetAxialTolerance(fAxialTolerance);
+            debug << "Field map size : " << fieldGrid.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+        }
+        if (!mVolume.field.IsEmpty()) mVolume.field.Translate(fPositions[n]);
+        SetFieldModel(n, mVolume.model);
 
         if (fBoundMax[n] == TVector3(0, 0, 0)) {
             ferr << "The bounding box was not defined for volume " << n << "!" << endl;
@@ -746,13 +1542,15 @@ void TRestAxionMagneticField::LoadMagneticVolumes() {
             exit(22);
         }
         fMagneticFieldVolumes.push_back(mVolume);
+        fLoadTimes.push_back(load.times);
     }
 
     if (CheckOverlaps()) {
         ferr << "TRestAxionMagneticField::LoadMagneticVolumes. Volumes overlap!" << endl;
         exit(1);
     }
-    debug << "Finished loading magnetic volumes" << endl;
+    debug << "Finished loading magnetic volumes in " << GetElapsedTime(start) << " ms, using " << threads
+          << " threads" << endl;
 }
 
 ///////////////////////////////////////////////
@@ -766,115 +1564,108 @@ TVector3 TRestAxionMagneticField::GetMagneticField(Double_t x, Double_t y, Doubl
 /// \brief It returns the magnetic field vector at TVector3(pos) using trilinear interpolation
 /// that is implemented following instructions given at https://en.wikipedia.org/wiki/Trilinear_interpolation
 ///
+/// If the volume was defined using an analytic field `model`, the field is evaluated in closed form by
+/// TRestAxionFieldModel instead.
+///
 /// The warning in case the evaluated point is found outside any volume might be disabled using
 /// the `showWarning` argument.
 ///
 TVector3 TRestAxionMagneticField::GetMagneticField(TVector3 pos, Bool_t showWarning) {
-    Int_t id = GetVolumeIndex(pos);
+    const TRestAxionFieldEvaluator& evaluator = GetFieldEvaluator();
+    Int_t id = evaluator.GetVolumeIndex(pos);
 
     if (id < 0) {
         if (showWarning)
             warning << "TRestAxionMagneticField::GetMagneticField position is outside any volume" << endl;
         return TVector3(0, 0, 0);
     } else {
-        if (IsFieldConstant(id)) return fConstantField[id];
-        TVector3 node = GetMagneticVolumeNode(fMagneticFieldVolumes[id], pos);
-        Int_t nX = node.X();
-        Int_t nY = node.Y();
-        Int_t nZ = node.Z();
+        TVector3 C = evaluator.GetMagneticField(id, pos);
 
-        Int_t nX_1, nY_1, nZ_1;
+        debug << "position = (" << pos.X() << ", " << pos.Y() << ", " << pos.Z() << ")       ";
+        debug << "C = (" << C.X() << ", " << C.Y() << ", " << C.Z() << ")" << endl << endl;
 
-        if ((nX + 1) < fMagneticFieldVolumes[id].mesh.GetNodesX())
-            nX_1 = nX + 1;
-        else
-            nX_1 = nX;
-        if ((nY + 1) < fMagneticFieldVolumes[id].mesh.GetNodesY())
-            nY_1 = nY + 1;
-        else
-            nY_1 = nY;
-        if ((nZ + 1) < fMagneticFieldVolumes[id].mesh.GetNodesZ())
-            nZ_1 = nZ + 1;
-        else
-            nZ_1 = nZ;
-
-        TVector3 C000 = fMagneticFieldVolumes[id].field[nX][nY][nZ] + fConstantField[id];
-        TVector3 C100 = fMagneticFieldVolumes[id].field[nX_1][nY][nZ] + fConstantField[id];
-        TVector3 C010 = fMagneticFieldVolumes[id].field[nX][nY_1][nZ] + fConstantField[id];
-        TVector3 C110 = fMagneticFieldVolumes[id].field[nX_1][nY_1][nZ] + fConstantField[id];
-        TVector3 C001 = fMagneticFieldVolumes[id].field[nX][nY][nZ_1] + fConstantField[id];
-        TVector3 C101 = fMagneticFieldVolumes[id].field[nX_1][nY][nZ_1] + fConstantField[id];
-        TVector3 C011 = fMagneticFieldVolumes[id].field[nX][nY_1][nZ_1] + fConstantField[id];
-        TVector3 C111 = fMagneticFieldVolumes[id].field[nX_1][nY_1][nZ_1] + fConstantField[id];
-
-        Double_t x0 = fMagneticFieldVolumes[id].mesh.GetX(nX);
-        Double_t x1 = fMagneticFieldVolumes[id].mesh.GetX(nX_1);
-        Double_t xd;
-        if (x0 == x1)
-            xd = 0;
-        else
-            xd = (pos.X() - x0) / (x1 - x0);
-        if ((xd < -0.00001) || (xd > 1.00001))
-            warning << "TRestAxionMagneticField::GetMagneticField  Error: xd NOT between 0 and 1" << endl;
-
-        Double_t y0 = fMagneticFieldVolumes[id].mesh.GetY(nY);
-        Double_t y1 = fMagneticFieldVolumes[id].mesh.GetY(nY_1);
-        Double_t yd;
-        if (y0 == y1)
-            yd = 0;
-        else
-            yd = (pos.Y() - y0) / (y1 - y0);
-        if ((yd < -0.00001) || (yd > 1.00001))
-            warning << "TRestAxionMagneticField::GetMagneticField  Error: yd NOT between 0 and 1" << endl;
-
-        Double_t z0 = fMagneticFieldVolumes[id].mesh.GetZ(nZ);
-        Double_t z1 = fMagneticFieldVolumes[id].mesh.GetZ(nZ_1);
-        Double_t zd;
-        if (z0 == z1)
-            zd = 0;
-        else
-            zd = (pos.Z() - z0) / (z1 - z0);
-        if ((zd < -0.00001) || (zd > 1.00001))
-            warning << "TRestAxionMagneticField::GetMagneticField  Error: zd NOT between 0 and 1" << endl;
+        return C;
+    }
+}
 
-        // first we interpolate along x-axis
-        TVector3 C00 = C000 * (1.0 - xd) + C100 * xd;
-        TVector3 C01 = C001 * (1.0 - xd) + C101 * xd;
-        TVector3 C10 = C010 * (1.0 - xd) + C110 * xd;
-        TVector3 C11 = C011 * (1.0 - xd) + C111 * xd;
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at TVector3(pos), using the volume and grid cell of the
+/// previous query kept at `cursor`.
+///
+/// The result is equal within rounding to TRestAxionMagneticField::GetMagneticField without cursor, but it is
+/// cheaper when consecutive queries are close to each other, e.g. when sampling a ray. The volume of the
+/// previous position is checked first, and the nodes of the grid cell are only read when the position moves
+/// to a different cell. The cursor must be cleared, using FieldCursor::Clear, if the volumes are loaded
+/// again.
+///
+TVector3 TRestAxionMagneticField::GetMagneticField(TVector3 pos, FieldCursor& cursor, Bool_t showWarning) {
+    TVector3 b = GetFieldEvaluator().GetMagneticField(pos, cursor);
 
-        // then we interpolate along y-axis
-        TVector3 C0 = C00 * (1.0 - yd) + C10 * yd;
-        TVector3 C1 = C01 * (1.0 - yd) + C11 * yd;
+    if (cursor.volume < 0 && showWarning)
+        warning << "TRestAxionMagneticField::GetMagneticField position is outside any volume" << endl;
+    return b;
+}
 
-        // finally we interpolate along z-axis
-        TVector3 C = C0 * (1.0 - zd) + C1 * zd;
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at TVector3(pos), and it writes at `gradient` the 3x3
+/// matrix with its derivatives, in T/mm.
+///
+/// The element `gradient(i, j)` is the derivative of the field component `i` along the axis `j`, e.g.
+/// `gradient(0, 2)` is dBx/dz. The field and its derivatives are obtained from the same nodes of the field
+/// map, what is much cheaper than the 6 additional calls to TRestAxionMagneticField::GetMagneticField
+/// required by finite differences, and the field is equal within rounding to the one given by that method.
+/// The derivatives are the exact derivatives of the interpolated field, see
+/// TRestAxionFieldGrid::InterpolateGradient. They are discontinuous at the faces of the cells with the
+/// trilinear interpolation, and continuous with the tricubic interpolation, defined by the parameter
+/// `interpolation`. The derivatives of an analytic field `model` are given in closed form.
+///
+/// The gradient is zero outside any volume, and inside a volume with a constant field. The discontinuity
+/// of the field at the volume boundaries is not included.
+///
+TVector3 TRestAxionMagneticField::GetMagneticFieldAndGradient(TVector3 pos, TMatrixD& gradient,
+                                                              Bool_t showWarning) {
+    FieldCursor cursor;
+    return GetMagneticFieldAndGradient(pos, gradient, cursor, showWarning);
+}
 
-        debug << "position = (" << pos.X() << ", " << pos.Y() << ", " << pos.Z() << ")       ";
-        debug << "nX = " << nX << " nY = " << nY << " nZ = " << nZ << "     nX_1 = " << nX_1
-              << "   nY_1 = " << nY_1 << "   nZ_1 = " << nZ_1 << endl
-              << endl;
-        debug << "C000 = (" << C000.X() << ", " << C000.Y() << ", " << C000.Z() << ")" << endl << endl;
-        debug << "C100 = (" << C100.X() << ", " << C100.Y() << ", " << C100.Z() << ")" << endl << endl;
-        debug << "C010 = (" << C010.X() << ", " << C010.Y() << ", " << C010.Z() << ")" << endl << endl;
-        debug << "C110 = (" << C110.X() << ", " << C110.Y() << ", " << C110.Z() << ")" << endl << endl;
-        debug << "C001 = (" << C001.X() << ", " << C001.Y() << ", " << C001.Z() << ")" << endl << endl;
-        debug << "C101 = (" << C101.X() << ", " << C101.Y() << ", " << C101.Z() << ")" << endl << endl;
-        debug << "C011 = (" << C011.X() << ", " << C011.Y() << ", " << C011.Z() << ")" << endl << endl;
-        debug << "C111 = (" << C111.X() << ", " << C111.Y() << ", " << C111.Z() << ")" << endl << endl;
-        debug << " -------------------------------------------------------" << endl;
-        debug << "C00 = (" << C00.X() << ", " << C00.Y() << ", " << C00.Z() << ")" << endl << endl;
-        debug << "C01 = (" << C01.X() << ", " << C01.Y() << ", " << C01.Z() << ")" << endl << endl;
-        debug << "C10 = (" << C10.X() << ", " << C10.Y() << ", " << C10.Z() << ")" << endl << endl;
-        debug << "C11 = (" << C11.X() << ", " << C11.Y() << ", " << C11.Z() << ")" << endl << endl;
-        debug << " -------------------------------------------------------" << endl;
-        debug << "C0 = (" << C0.X() << ", " << C0.Y() << ", " << C0.Z() << ")" << endl << endl;
-        debug << "C1 = (" << C1.X() << ", " << C1.Y() << ", " << C1.Z() << ")" << endl << endl;
-        debug << " -------------------------------------------------------" << endl;
-        debug << "C = (" << C.X() << ", " << C.Y() << ", " << C.Z() << ")" << endl << endl;
+///////////////////////////////////////////////
+/// \brief It returns the magnetic field vector at TVector3(pos), and it writes at `gradient` its
+/// derivatives, using the volume and grid cell of the previous query kept at `cursor`.
+///
+/// See TRestAxionMagneticField::GetMagneticFieldAndGradient and TRestAxionMagneticField::GetMagneticField
+/// using a cursor.
+///
+TVector3 TRestAxionMagneticField::GetMagneticFieldAndGradient(TVector3 pos, TMatrixD& gradient,
+                                                              FieldCursor& cursor, Bool_t showWarning) {
+    TVector3 b = GetFieldEvaluator().GetMagneticFieldAndGradient(pos, gradient, cursor);
 
-        return C;
-    }
+    if (cursor.volume < 0 && showWarning)
+        warning << "TRestAxionMagneticField::GetMagneticFieldAndGradient position is outside any volume"
+                << endl;
+    return b;
+}
+
+///////////////////////////////////////////////
+/// \brief It evaluates the magnetic field at `n` positions given by the coordinate arrays `x`, `y` and `z`,
+/// and writes the field components at the arrays `bx`, `by` and `bz`.
+///
+/// Consecutive positions found inside the same magnetic volume are interpolated together using
+/// TRestAxionFieldGrid, which will use vector instructions (AVX2/AVX-512) when available. The result is equal
+/// within rounding to call TRestAxionMagneticField::GetMagneticField for each position, since the vector
+/// instructions may use fused multiply-adds, without the need to build a TVector3 for each point. Positions
+/// outside any volume will get a null field.
+///
+/// A single warning will be shown if any of the positions is found outside any volume. It might be
+/// disabled using the `showWarning` argument.
+///
+void TRestAxionMagneticField::GetMagneticField(Int_t n, const Double_t* x, const Double_t* y,
+                                               const Double_t* z, Double_t* bx, Double_t* by, Double_t* bz,
+                                               Bool_t showWarning) {
+    Int_t outside = GetFieldEvaluator().GetMagneticField(n, x, y, z, bx, by, bz);
+
+    if (showWarning && outside > 0)
+        warning << "TRestAxionMagneticField::GetMagneticField " << outside
+                << " positions are outside any volume" << endl;
 }
 
 ///////////////////////////////////////////////
@@ -943,13 +1734,23 @@ Double_t TRestAxionMagneticField::GetPhotonAbsorptionLength(Int_t id, Double_t e
 /// \brief It returns the corresponding volume index at the given position. If not found it will return
 /// -1.
 ///
+/// Only the volumes whose bounding box contains the position, as given by the volume index, are checked.
+/// If several volumes contain the position, the lowest index is returned. See
+/// TRestAxionFieldEvaluator::GetVolumeIndex.
+///
 Int_t TRestAxionMagneticField::GetVolumeIndex(TVector3 pos) {
-    if (!FieldLoaded()) LoadMagneticVolumes();
+    return GetFieldEvaluator().GetVolumeIndex(pos);
+}
 
-    for (int n = 0; n < fMagneticFieldVolumes.size(); n++) {
-        if (fMagneticFieldVolumes[n].mesh.IsInside(pos)) return n;
-    }
-    return -1;
+///////////////////////////////////////////////
+/// \brief It returns the ids of the volumes whose bounding box is crossed by the trajectory starting at
+/// `pos` and moving along the direction `dir`. The ids are given in increasing order.
+///
+/// The volumes that are not returned by this method can be safely ignored when searching the boundaries
+/// of a track, e.g. using TRestAxionMagneticField::GetFieldBoundaries.
+///
+std::vector<Int_t> TRestAxionMagneticField::GetVolumesAlongRay(TVector3 pos, TVector3 dir) {
+    return GetFieldEvaluator().GetVolumesAlongRay(pos, dir);
 }
 
 ///////////////////////////////////////////////
@@ -986,6 +1787,41 @@ Double_t TRestAxionMagneticField::GetTransversalComponent(TVector3 position, TVe
     return abs(GetMagneticField(position).Perp(direction));
 }
 
+///////////////////////////////////////////////
+/// \brief It returns the intensity of the transversal magnetic field component for the defined propagation
+/// `direction` and `position`, using the `cursor` as described at TRestAxionMagneticField::GetMagneticField.
+///
+Double_t TRestAxionMagneticField::GetTransversalComponent(TVector3 position, TVector3 direction,
+                                                          FieldCursor& cursor) {
+    return abs(GetMagneticField(position, cursor).Perp(direction));
+}
+
+///////////////////////////////////////////////
+/// \brief It evaluates the intensity of the transversal magnetic field component for the propagation
+/// `direction` given by argument, at `n` positions given by the coordinate arrays `x`, `y` and `z`. The
+/// result is written at the array `bt`.
+///
+/// The field is evaluated at all positions at once using the multi-point version of
+/// TRestAxionMagneticField::GetMagneticField.
+///
+void TRestAxionMagneticField::GetTransversalComponent(Int_t n, const Double_t* x, const Double_t* y,
+                                                      const Double_t* z, TVector3 direction, Double_t* bt,
+                                                      Bool_t showWarning) {
+    std::vector<Double_t> bx(n), by(n), bz(n);
+    GetMagneticField(n, x, y, z, bx.data(), by.data(), bz.data(), showWarning);
+
+    // Same calculation as TVector3::Perp
+    Double_t d2 = direction.Mag2();
+    for (Int_t k = 0; k < n; k++) {
+        Double_t b2 = bx[k] * bx[k] + by[k] * by[k] + bz[k] * bz[k];
+        if (d2 > 0) {
+            Double_t bd = bx[k] * direction.X() + by[k] * direction.Y() + bz[k] * direction.Z();
+            b2 -= bd * bd / d2;
+        }
+        bt[k] = b2 > 0 ? sqrt(b2) : 0;
+    }
+}
+
 ///////////////////////////////////////////////
 /// \brief It returns a vector describing the transversal magnetic field component between `from` and `to`
 /// positions given by argument.
@@ -1012,11 +1848,17 @@ std::vector<Double_t> TRestAxionMagneticField::GetTransversalComponentAlongPath(
 
     TVector3 direction = (to - from).Unit();
 
-    std::vector<Double_t> Bt;
+    std::vector<Double_t> x, y, z;
     for (Double_t d = 0; d < length; d += diff) {
-        Bt.push_back(GetTransversalComponent(from + d * direction, direction));
+        TVector3 pos = from + d * direction;
+        x.push_back(pos.X());
+        y.push_back(pos.Y());
+        z.push_back(pos.Z());
     }
 
+    std::vector<Double_t> Bt(x.size());
+    GetTransversalComponent(x.size(), x.data(), y.data(), z.data(), direction, Bt.data());
+
     return Bt;
 }
 
@@ -1025,7 +1867,13 @@ std::vector<Double_t> TRestAxionMagneticField::GetTransversalComponentAlongPath(
 /// `from` and `to`.
 ///
 /// The differential element `dl` defines the integration step, and it is by default 1mm, but it can be
-/// modified through the third argument of this function.
+/// modified through the third argument of this function. If `dl` is zero, or if the segment is parallel
+/// to z and the parameter `axialSums` is enabled, the average is obtained from the line integral given by
+/// TRestAxionMagneticField::GetFieldIntegral, and it does not depend on any integration step.
+///
+/// With `axialSums` enabled, the transverse intensity along such segments is the one of the axial sums,
+/// taken at the nodes and interpolated linearly between them, which is only an approximation of the
+/// intensity of the interpolated field. See TRestAxionFieldGrid::BuildAxialSums.
 ///
 /// The maximum number of divisions of the output vector can be fixed by the forth argument. In that case, the
 /// differential element `dl` length might be increased to fullfil such condition.
@@ -1034,6 +1882,9 @@ Double_t TRestAxionMagneticField::GetTransversalFieldAverage(TVector3 from, TVec
                                                              Int_t Nmax) {
     Double_t length = (to - from).Mag();
 
+    if ((dl == 0 || IsAxialPath(from, to)) && length > 0)
+        return GetFieldIntegral(from, to).GetTransversalFieldAverage();
+
     Double_t Bavg = 0.;
     std::vector<Double_t> Bt = GetTransversalComponentAlongPath(from, to, dl, Nmax);
     for (auto& b : Bt) Bavg += b;
@@ -1049,7 +1900,15 @@ Double_t TRestAxionMagneticField::GetTransversalFieldAverage(TVector3 from, TVec
 /// along the line that connects the 3-d coordinates `from` and `to` with respect to that line
 ///
 /// The differential element `dl` defines the step, and it is by default 10mm, but it can be
-/// modified through the third argument of this function.
+/// modified through the third argument of this function. If `dl` is zero, or if the segment is parallel
+/// to z and the parameter `axialSums` is enabled, the average is obtained from the line integral given by
+/// TRestAxionMagneticField::GetFieldIntegral.
+///
+/// With `axialSums` enabled, the average vector along such segments is obtained from the integrals of
+/// the field components kept by the axial sums, which are exact along z. Unlike
+/// TRestAxionMagneticField::GetTransversalFieldAverage, it does not use the approximate transverse
+/// intensity of the sums. Segments displaced sideways within `axialTolerance` are integrated at their
+/// average x and y. See TRestAxionFieldGrid::IsAxial.
 ///
 /// The maximum number of divisions (unlimited by default)  can be fixed by the forth
 /// argument. In that case, the differential element `dl` length might be increased to fullfil such condition.
@@ -1058,6 +1917,9 @@ TVector3 TRestAxionMagneticField::GetFieldAverageTransverseVector(TVector3 from,
                                                                   Int_t Nmax) {
     Double_t length = (to - from).Mag();
 
+    if ((dl == 0 || IsAxialPath(from, to)) && length > 0)
+        return GetFieldIntegral(from, to).GetFieldAverageTransverseVector();
+
     Double_t diff = dl;
     if (Nmax > 0) {
         if (length / dl > Nmax) {
@@ -1071,12 +1933,19 @@ TVector3 TRestAxionMagneticField::GetFieldAverageTransverseVector(TVector3 from,
     TVector3 direction = (to - from).Unit();
     TVector3 Bavg = TVector3(0.0, 0.0, 0.0);
     TVector3 BTavg = TVector3(0.0, 0.0, 0.0);
-    Int_t numberofpoints = 0;
 
+    std::vector<Double_t> x, y, z;
     for (Double_t d = 0; d <= length; d += diff) {
-        Bavg = Bavg + GetMagneticField(from + d * direction);
-        numberofpoints = numberofpoints + 1;
+        TVector3 pos = from + d * direction;
+        x.push_back(pos.X());
+        y.push_back(pos.Y());
+        z.push_back(pos.Z());
     }
+    Int_t numberofpoints = x.size();
+
+    std::vector<Double_t> bx(numberofpoints), by(numberofpoints), bz(numberofpoints);
+    GetMagneticField(numberofpoints, x.data(), y.data(), z.data(), bx.data(), by.data(), bz.data());
+    for (Int_t k = 0; k < numberofpoints; k++) Bavg = Bavg + TVector3(bx[k], by[k], bz[k]);
 
     if ((length > 0) && (numberofpoints > 0)) {
         Bavg = Bavg * (1.0 / numberofpoints);  // calculates the average magnetic field vector
@@ -1092,6 +1961,373 @@ TVector3 TRestAxionMagneticField::GetFieldAverageTransverseVector(TVector3 from,
     return TVector3(0.0, 0.0, 0.0);
 }
 
+///////////////////////////////////////////////
+/// \brief It returns the integrals of the magnetic field along the straight segment between the 3-d
+/// coordinates `from` and `to`, as defined at FieldLineIntegral.
+///
+/// The segment is divided at the boundaries of the magnetic volumes it crosses, and the field is zero
+/// outside any volume. Inside each volume the field map is integrated cell by cell, as described at
+/// TRestAxionFieldGrid::Integrate, so that no integration step is required. The integrals of the field
+/// vector and of its transverse component are exact for the trilinear interpolation used by
+/// TRestAxionMagneticField::GetMagneticField, while the integral of the transverse intensity is
+/// approximated by a 4-point Gauss-Legendre quadrature inside each cell. The analytic field models are
+/// integrated with the same quadrature, as described at TRestAxionFieldModel::Integrate.
+///
+/// If `extrema` is true, the minimum and maximum transverse intensity are always obtained from the field
+/// maps. See TRestAxionMagneticField::GetFieldIntegrals.
+///
+FieldLineIntegral TRestAxionMagneticField::GetFieldIntegral(TVector3 from, TVector3 to, Bool_t extrema) {
+    return GetFieldIntegrals({from, to}, extrema)[0];
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the field integrals, as given by TRestAxionMagneticField::GetFieldIntegral, for each
+/// of the consecutive subsegments defined by the points in `path`.
+///
+/// The points must be ordered along the straight line that connects the first and the last point, and
+/// the subsegment `n` goes from `path[n]` to `path[n+1]`. The volumes crossed by the line are searched only
+/// once, and all the subsegments are integrated in a single traversal. The averages of each subsegment
+/// are given by FieldLineIntegral::GetTransversalFieldAverage and
+/// FieldLineIntegral::GetFieldAverageTransverseVector.
+/// If the parameters `directionTableAxis` and `directionTableSpacing` were given, and the path has that
+/// direction, the integrals are interpolated from a table built for that direction. See
+/// TRestAxionFieldDirectionTable. The table does not keep the minimum and maximum transverse intensity,
+/// and it is not used if `extrema` is true, so that they are obtained from the field maps.
+///
+std::vector<FieldLineIntegral> TRestAxionMagneticField::GetFieldIntegrals(const std::vector<TVector3>& path,
+                                                                          Bool_t extrema) {
+    const TRestAxionFieldEvaluator& evaluator = GetFieldEvaluator();
+
+    if (fDirectionTableSpacing <= 0 || fDirectionTableAxis.Mag2() == 0 || fDirectionTableTooLarge ||
+        extrema || path.size() < 2 || path.back() == path.front())
+        return evaluator.GetFieldIntegrals(path);
+
+    if (fDirectionTable.IsEmpty() && !BuildDirectionTable()) return evaluator.GetFieldIntegrals(path);
+
+    TVector3 dir = (path.back() - path.front()).Unit();
+    if (!fDirectionTable.IsDefinedFor(dir)) return evaluator.GetFieldIntegrals(path);
+
+    std::vector<FieldLineIntegral> integrals(path.size() - 1);
+    for (unsigned int n = 0; n < integrals.size(); n++)
+        integrals[n] = fDirectionTable.GetIntegral(path[n], path[n + 1]);
+
+    return integrals;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns true if the field integrals along the segment between `from` and `to` can be obtained
+/// from the axial sums of all the field maps it crosses. See TRestAxionFieldGrid::IsAxial.
+///
+Bool_t TRestAxionMagneticField::IsAxialPath(TVector3 from, TVector3 to) {
+    if (!fUseAxialSums || from == to) return false;
+    if (!FieldLoaded()) LoadMagneticVolumes();
+
+    for (const auto& id : GetVolumesAlongRay(from, (to - from).Unit())) {
+        if (IsFieldConstant(id)) continue;
+
+        const TRestAxionFieldGrid& grid = fMagneticFieldVolumes[id].field;
+        if (!grid.HasAxialSums() || fConstantField[id] != TVector3(0, 0, 0) || !grid.IsAxial(from, to))
+            return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It builds the table of field integrals along parallel rays with the direction given by
+/// `directionTableAxis`, covering the bounding boxes of all the volumes.
+///
+/// It returns false, without building the table, if it would exceed the size given by
+/// `directionTableMaxSize`.
+///
+Bool_t TRestAxionMagneticField::BuildDirectionTable() {
+    TVector3 dir = fDirectionTableAxis.Unit();
+    TVector3 boxMin = fPositions[0] - fBoundMax[0];
+    TVector3 boxMax = fPositions[0] + fBoundMax[0];
+    for (unsigned int n = 1; n < fPositions.size(); n++)
+        for (int k = 0; k < 3; k++) {
+            boxMin[k] = min(boxMin[k], fPositions[n][k] - fBoundMax[n][k]);
+            boxMax[k] = max(boxMax[k], fPositions[n][k] + fBoundMax[n][k]);
+        }
+
+    size_t maxBytes = (size_t)(fDirectionTableMaxSize * 1024 * 1024);
+    if (!fDirectionTable.Define(dir, boxMin, boxMax, fDirectionTableSpacing, maxBytes)) {
+        warning << "TRestAxionMagneticField::BuildDirectionTable. The table of field integrals exceeds "
+                << fDirectionTableMaxSize << " MB" << endl;
+        warning << "Increase directionTableSpacing or directionTableMaxSize. No table will be used" << endl;
+        fDirectionTableTooLarge = true;
+        return false;
+    }
+
+    Int_t nodes = fDirectionTable.GetNodes(2);
+    TVector3 step = fDirectionTable.GetSpacing() * fDirectionTable.GetDirection();
+    std::vector<TVector3> ray(nodes);
+    const TRestAxionFieldEvaluator& evaluator = GetFieldEvaluator();
+    for (Int_t ia = 0; ia < fDirectionTable.GetNodes(0); ia++)
+        for (Int_t ib = 0; ib < fDirectionTable.GetNodes(1); ib++) {
+            TVector3 start = fDirectionTable.GetRayStart(ia, ib);
+            for (Int_t n = 0; n < nodes; n++) ray[n] = start + n * step;
+            fDirectionTable.SetRay(ia, ib, evaluator.GetFieldIntegrals(ray));
+        }
+
+    debug << "TRestAxionMagneticField::BuildDirectionTable. Direction : (" << dir.X() << ", " << dir.Y()
+          << ", " << dir.Z() << ")" << endl;
+    debug << "Rays : " << fDirectionTable.GetNodes(0) << " x " << fDirectionTable.GetNodes(1)
+          << ", nodes per ray : " << nodes << endl;
+    debug << "Table size : " << fDirectionTable.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It translates the `symmetry` definition given at the RML, e.g. "xYz", to the symmetry flags
+/// used by TRestAxionFieldGrid.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+UInt_t TRestAxionMagneticField::GetSymmetryFlags(TString symmetry) {
+    UInt_t flags = 0;
+    string axes = symmetry.Data();
+    for (unsigned int n = 0; n < axes.size(); n++) {
+        char c = axes[n];
+        if (c == 'x' || c == 'X') flags |= TRestAxionFieldGrid::kMirrorX;
+        if (c == 'y' || c == 'Y') flags |= TRestAxionFieldGrid::kMirrorY;
+        if (c == 'z' || c == 'Z') flags |= TRestAxionFieldGrid::kMirrorZ;
+        if (c == 'X') flags |= TRestAxionFieldGrid::kTangentialX;
+        if (c == 'Y') flags |= TRestAxionFieldGrid::kTangentialY;
+        if (c == 'Z') flags |= TRestAxionFieldGrid::kTangentialZ;
+        if (string("xyzXYZ, ").find(c) == string::npos)
+            warning << "TRestAxionMagneticField. Symmetry axis not recognized : " << c << endl;
+    }
+    return flags;
+}
+
+///////////////////////////////////////////////
+/// \brief It converts the field map `grid` of the volume `n` to the storage precision defined at the RML.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+void TRestAxionMagneticField::SetFieldPrecision(Int_t n, TRestAxionFieldGrid& grid) {
+    TString precisionName = n < fPrecisions.size() ? fPrecisions[n] : "double";
+
+    UInt_t precision = TRestAxionFieldGrid::kDoublePrecision;
+    if (precisionName == "float") precision = TRestAxionFieldGrid::kFloatPrecision;
+    if (precisionName == "int16") precision = TRestAxionFieldGrid::kInt16Precision;
+
+    if (grid.IsEmpty()) return;
+    Bool_t applied = grid.SetPrecision(precision);
+
+    // The volumes may be loaded by several threads
+    lock_guard<mutex> lock(GetOutputMutex());
+    if (!applied) {
+        warning << "Volume : " << n << endl;
+        warning << "The precision defined in RML does not match the precision of the grid file!" << endl;
+        warning << "The precision stored in the grid file will be used" << endl;
+    }
+
+    debug << "Field map precision : " << precisionName << endl;
+    debug << "Maximum quantization error : " << grid.GetQuantizationError() << " T" << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief It reorders the field map `grid` of the volume `n` following the layout defined at the RML.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+void TRestAxionMagneticField::SetFieldLayout(Int_t n, TRestAxionFieldGrid& grid) {
+    TString layoutName = n < fLayouts.size() ? fLayouts[n] : "linear";
+
+    UInt_t layout = TRestAxionFieldGrid::kLinearLayout;
+    if (layoutName == "blocked") layout = TRestAxionFieldGrid::kBlockedLayout;
+
+    if (grid.IsEmpty() || layout == grid.GetLayout()) return;
+    Bool_t applied = grid.SetLayout(layout);
+
+    lock_guard<mutex> lock(GetOutputMutex());
+    if (!applied) {
+        warning << "Volume : " << n << endl;
+        warning << "The layout defined in RML cannot be used with a tiled grid file!" << endl;
+        return;
+    }
+
+    debug << "Field map layout : " << layoutName << endl;
+    debug << "Field map size : " << grid.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief It stores the field map `grid` of the volume `n` with an adaptive resolution, if it is defined at
+/// the RML.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+void TRestAxionMagneticField::SetFieldAdaptive(Int_t n, TRestAxionFieldGrid& grid) {
+    if (grid.IsEmpty() || n >= fAdaptiveTolerances.size() || fAdaptiveTolerances[n] <= 0) return;
+
+    size_t size = grid.GetMemorySize();
+    Bool_t applied = grid.SetAdaptive(fAdaptiveTolerances[n]);
+
+    lock_guard<mutex> lock(GetOutputMutex());
+    if (!applied) {
+        warning << "Volume : " << n << endl;
+        warning << "The adaptive resolution cannot be used with this field map!" << endl;
+        return;
+    }
+
+    const TRestAxionFieldBricks* bricks = grid.GetBricks();
+    debug << "Field map adaptive resolution. Tolerance : " << fAdaptiveTolerances[n] << " T" << endl;
+    debug << "Stored nodes : " << bricks->GetNumberOfStoredNodes() << " of " << grid.GetNumberOfNodes()
+          << endl;
+    debug << "Maximum error : " << bricks->GetMaxError() << " T" << endl;
+    debug << "Field map size : " << grid.GetMemorySize() / 1024. / 1024. << " MB (originally "
+          << size / 1024. / 1024. << " MB)" << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief It computes the derivatives used by the tricubic interpolation of the field map `grid` of the
+/// volume `n`, if it is defined at the RML.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+void TRestAxionMagneticField::SetFieldInterpolation(Int_t n, TRestAxionFieldGrid& grid) {
+    if (grid.IsEmpty() || n >= fInterpolations.size() || fInterpolations[n] != "tricubic") return;
+
+    Bool_t built = grid.BuildTricubic();
+
+    lock_guard<mutex> lock(GetOutputMutex());
+    if (!built) {
+        warning << "Volume : " << n << endl;
+        warning << "The tricubic interpolation cannot be used with a tiled grid file!" << endl;
+        warning << "The trilinear interpolation will be used" << endl;
+        return;
+    }
+
+    debug << "Field map interpolation : tricubic" << endl;
+    debug << "Tricubic derivatives size : " << grid.GetTricubicSize() / 1024. / 1024. << " MB" << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief It fits the multipole expansion of the bore to the field map `grid` of the volume `n`, if it is
+/// defined at the RML.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+void TRestAxionMagneticField::SetFieldMultipoles(Int_t n, TRestAxionFieldGrid& grid) {
+    if (grid.IsEmpty() || n >= fMultipoleOrders.size() || fMultipoleOrders[n] <= 0) return;
+
+    Bool_t built = grid.BuildMultipoles(fMultipoleOrders[n], fMultipoleRadii[n], fMultipoleTolerances[n]);
+
+    lock_guard<mutex> lock(GetOutputMutex());
+    if (!built) {
+        warning << "Volume : " << n << endl;
+        warning << "The multipole expansion does not reproduce the field map within the tolerance!" << endl;
+        warning << "The field map will be used inside the bore" << endl;
+        return;
+    }
+
+    const FieldMultipoles* multipoles = grid.GetMultipoles();
+    Int_t valid = 0;
+    for (Int_t k = 0; k < multipoles->slices; k++) valid += multipoles->valid[k];
+
+    debug << "Multipole expansion order : " << multipoles->order << ", radius : " << multipoles->radius
+          << " mm" << endl;
+    debug << "Valid slices : " << valid << " of " << multipoles->slices << endl;
+    debug << "Maximum residual : " << multipoles->residual << " T" << endl;
+    debug << "Multipole coefficients size : " << grid.GetMultipoleSize() / 1024. / 1024. << " MB" << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief It defines the analytic field `model` of the volume `n` from the model parameters given at the
+/// RML. The model is centered at the volume position.
+///
+/// This method will be made private, no reason to use it outside this class.
+///
+void TRestAxionMagneticField::SetFieldModel(Int_t n, TRestAxionFieldModel& model) {
+    model.Clear();
+    if (n >= fModels.size() || fModels[n] == "none") return;
+
+    if (fFileNames[n] != "none") {
+        warning << "Volume : " << n << endl;
+        warning << "A field model cannot be combined with a field map file!" << endl;
+        warning << "The field model will be ignored" << endl;
+        return;
+    }
+
+    const TVector3& field = fModelFields[n];
+    if (fModels[n] == "dipole") {
+        if (field.Z() != 0) {
+            warning << "Volume : " << n << endl;
+            warning << "The z component of the dipole field will be ignored" << endl;
+        }
+        model.SetDipole(field, fModelLengths[n], fModelFringes[n]);
+    } else if (fModels[n] == "solenoid") {
+        if (field.X() != 0 || field.Y() != 0) {
+            warning << "Volume : " << n << endl;
+            warning << "The transverse components of the solenoid field will be ignored" << endl;
+        }
+        if (fModelLengths[n] > 0 && fModelRadii[n] <= 0) {
+            ferr << "The radius of the solenoid was not defined for volume " << n << "!" << endl;
+            ferr << "Please review RML configuration for TRestAxionMagneticField" << endl;
+            exit(22);
+        }
+        model.SetSolenoid(field.Z(), fModelLengths[n], fModelRadii[n]);
+    } else if (fModels[n] == "multipole") {
+        std::vector<Double_t> normal, skew;
+        for (const auto& c : Split((string)fModelNormal[n], ","))
+            normal.push_back(StringToDouble(RemoveWhiteSpaces(c)));
+        for (const auto& c : Split((string)fModelSkew[n], ","))
+            skew.push_back(StringToDouble(RemoveWhiteSpaces(c)));
+        if (normal.empty() && skew.empty()) {
+            warning << "Volume : " << n << endl;
+            warning << "No multipole coefficients were defined. The field model will be ignored" << endl;
+            return;
+        }
+        if (max(normal.size(), skew.size()) > 1 && fModelRadii[n] <= 0) {
+            ferr << "The reference radius of the multipole was not defined for volume " << n << "!" << endl;
+            ferr << "Please review RML configuration for TRestAxionMagneticField" << endl;
+            exit(22);
+        }
+        model.SetMultipole(normal, skew, fModelRadii[n], fModelLengths[n], fModelFringes[n]);
+    }
+    model.Translate(fPositions[n]);
+
+    debug << "Field model : " << fModels[n] << endl;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns a read-only snapshot of the magnetic volumes, that can be shared by several threads.
+/// See TRestAxionFieldEvaluator.
+///
+/// The volumes are loaded if required, and the evaluator is created the first time it is requested. The
+/// same evaluator is returned until the volumes are loaded again. An evaluator obtained before remains
+/// valid, and it keeps the volumes that were loaded when it was created. The field queries of this class,
+/// e.g. TRestAxionMagneticField::GetMagneticField, are also evaluated using this evaluator.
+///
+/// This method is not thread-safe, and it should be called before the evaluator is shared.
+///
+std::shared_ptr<const TRestAxionFieldEvaluator> TRestAxionMagneticField::GetEvaluator() {
+    if (!FieldLoaded()) LoadMagneticVolumes();
+    if (fEvaluator) return fEvaluator;
+
+    std::vector<TRestAxionFieldEvaluator::Volume> volumes(fMagneticFieldVolumes.size());
+    for (unsigned int n = 0; n < fMagneticFieldVolumes.size(); n++) {
+        TRestAxionFieldEvaluator::Volume& vol = volumes[n];
+        vol.position = fPositions[n];
+        vol.boundMax = fBoundMax[n];
+        vol.meshSize = fMeshSize[n];
+        vol.constantField = fConstantField[n];
+        vol.cylindrical = fMagneticFieldVolumes[n].mesh.IsCylindrical();
+        vol.field = fMagneticFieldVolumes[n].field;
+        vol.model = fMagneticFieldVolumes[n].model;
+
+        // The gas properties are not modified once the mixture is defined, and they are shared
+        vol.gas = fMagneticFieldVolumes[n].bGas;
+    }
+
+    fEvaluator = std::make_shared<const TRestAxionFieldEvaluator>(volumes);
+    debug << "TRestAxionMagneticField::GetEvaluator. Evaluator created for " << volumes.size()
+          << " volumes" << endl;
+
+    return fEvaluator;
+}
+
 ///////////////////////////////////////////////
 /// \brief It returns the corresponding mesh node in the magnetic volume
 ///
@@ -1100,11 +2336,12 @@ TVector3 TRestAxionMagneticField::GetFieldAverageTransverseVector(TVector3 from,
 ///
 /// This method will be made private, no reason to use it outside this class.
 ///
-TVector3 TRestAxionMagneticField::GetMagneticVolumeNode(MagneticFieldVolume mVol, TVector3 pos) {
-    Int_t nx = mVol.mesh.GetNodeX(pos.X());
-    Int_t ny = mVol.mesh.GetNodeY(pos.Y());
-    Int_t nz = mVol.mesh.GetNodeZ(pos.Z());
-    return TVector3(nx, ny, nz);
+TVector3 TRestAxionMagneticField::GetMagneticVolumeNode(const MagneticFieldVolume& mVol, TVector3 pos) {
+    Double_t p[3] = {pos.X(), pos.Y(), pos.Z()};
+    Int_t node[3];
+    Double_t frac[3];
+    mVol.field.GetCell(p, node, frac);
+    return TVector3(node[0], node[1], node[2]);
 }
 
 ///////////////////////////////////////////////
@@ -1159,6 +2396,11 @@ std::vector<TVector3> TRestAxionMagneticField::GetVolumeBoundaries(Int_t id, TVe
 /// If no precision is given, the mesh size of the corresponding volume will be used as reference. The
 /// precision will be meshSize/2.
 ///
+/// The regions of the field map without field are skipped using the occupancy of the grid cells (see
+/// TRestAxionFieldGrid::GetOccupiedIntervals). The field is only evaluated inside the cells with field, in
+/// steps of half the mesh size, and the boundary is then refined by bisection if a smaller precision is
+/// required. See TRestAxionFieldEvaluator::FindFieldBoundaries.
+///
 /// If no intersection is found the returned std::vector will be empty.
 ///
 std::vector<TVector3> TRestAxionMagneticField::GetFieldBoundaries(Int_t id, TVector3 pos, TVector3 dir,
@@ -1166,34 +2408,7 @@ std::vector<TVector3> TRestAxionMagneticField::GetFieldBoundaries(Int_t id, TVec
     std::vector<TVector3> volumeBoundaries = GetVolumeBoundaries(id, pos, dir);
     if (volumeBoundaries.size() != 2) return volumeBoundaries;
 
-    if (IsFieldConstant(id)) return volumeBoundaries;
-
-    MagneticFieldVolume* vol = GetMagneticVolume(id);
-    if (!vol) return volumeBoundaries;
-
-    if (precision == 0) precision = min(fMeshSize[id].X(), min(fMeshSize[id].Y(), fMeshSize[id].Z())) / 2.;
-
-    TVector3 unit = dir.Unit();
-    std::vector<TVector3> fieldBoundaries;
-
-    TVector3 in = volumeBoundaries[0];
-    while ((((volumeBoundaries[1] - in) * dir) > 0) && (GetTransversalComponent(in, dir) == 0))
-        in = MoveByDistanceFast(in, unit, precision);
-    if (((volumeBoundaries[1] - in) * dir) > 0)
-        fieldBoundaries.push_back(in);
-    else
-        return fieldBoundaries;
-
-    TVector3 out = volumeBoundaries[1];
-    while ((((volumeBoundaries[0] - out) * dir) < 0) && (GetTransversalComponent(out, -dir) == 0) &&
-           (((out - in) * dir) > 0))
-        out = MoveByDistanceFast(out, -unit, precision);
-    if ((((volumeBoundaries[0] - out) * dir) < 0) && (((out - in) * dir) > 0))
-        fieldBoundaries.push_back(out);
-    else
-        return fieldBoundaries;
-
-    return fieldBoundaries;
+    return GetFieldEvaluator().FindFieldBoundaries(id, volumeBoundaries[0], volumeBoundaries[1], precision);
 }
 
 ///////////////////////////////////////////////
@@ -1255,6 +2470,96 @@ void TRestAxionMagneticField::InitFromConfigFile() {
         if (gasDensity == "NO_SUCH_PARA") gasDensity = "0";
         fGasDensities.push_back(gasDensity);
 
+        TString symmetry = GetParameter("symmetry", magVolumeDef);
+        if (symmetry == "NO_SUCH_PARA") symmetry = "";
+        fSymmetries.push_back(symmetry);
+
+        TString gridType = GetParameter("gridType", magVolumeDef);
+        if (gridType == "NO_SUCH_PARA") gridType = "cartesian";
+        if (gridType != "cartesian" && gridType != "cylindrical") {
+            warning << "Grid type not recognized : " << gridType << ". Using cartesian grid" << endl;
+            gridType = "cartesian";
+        }
+        fGridTypes.push_back(gridType);
+
+        TString precision = GetParameter("precision", magVolumeDef);
+        if (precision == "NO_SUCH_PARA") precision = "double";
+        if (precision != "double" && precision != "float" && precision != "int16") {
+            warning << "Precision not recognized : " << precision << ". Using double precision" << endl;
+            precision = "double";
+        }
+        fPrecisions.push_back(precision);
+
+        TString layout = GetParameter("layout", magVolumeDef);
+        if (layout == "NO_SUCH_PARA") layout = "linear";
+        if (layout != "linear" && layout != "blocked") {
+            warning << "Layout not recognized : " << layout << ". Using linear layout" << endl;
+            layout = "linear";
+        }
+        fLayouts.push_back(layout);
+
+        Double_t adaptiveTolerance = StringToDouble(GetParameter("adaptiveTolerance", magVolumeDef, "0"));
+        fAdaptiveTolerances.push_back(adaptiveTolerance);
+        if (adaptiveTolerance > 0 && precision != "double") {
+            warning << "The adaptive storage keeps the field map in double precision" << endl;
+            warning << "The precision " << precision << " will not be used" << endl;
+            warning << "Remove adaptiveTolerance to store the field map with reduced precision" << endl;
+            precision = "double";
+            fPrecisions.back() = precision;
+        }
+
+        TString interpolation = GetParameter("interpolation", magVolumeDef);
+        if (interpolation == "NO_SUCH_PARA") interpolation = "trilinear";
+        if (interpolation != "trilinear" && interpolation != "tricubic") {
+            warning << "Interpolation not recognized : " << interpolation << ". Using trilinear interpolation"
+                    << endl;
+            interpolation = "trilinear";
+        }
+        fInterpolations.push_back(interpolation);
+
+        Int_t multipoleOrder = StringToInteger(GetParameter("multipoleOrder", magVolumeDef, "0"));
+        fMultipoleOrders.push_back(multipoleOrder);
+
+        Double_t multipoleRadius = GetDblParameterWithUnits("multipoleRadius", magVolumeDef, 0.);
+        fMultipoleRadii.push_back(multipoleRadius);
+
+        Double_t multipoleTolerance =
+            StringToDouble(GetParameter("multipoleTolerance", magVolumeDef, "1e-4"));
+        fMultipoleTolerances.push_back(multipoleTolerance);
+
+        Double_t cacheSize = StringToDouble(GetParameter("cacheSize", magVolumeDef, "256"));
+        fCacheSizes.push_back(cacheSize);
+
+        TString model = GetParameter("model", magVolumeDef);
+        if (model == "NO_SUCH_PARA") model = "none";
+        if (model != "none" && model != "dipole" && model != "solenoid" && model != "multipole") {
+            warning << "Volume : " << fPositions.size() - 1 << endl;
+            warning << "Field model not recognized : " << model << endl;
+            warning << "Valid options are : none, dipole, solenoid, multipole" << endl;
+            warning << "No field model will be used" << endl;
+            model = "none";
+        }
+        fModels.push_back(model);
+
+        TVector3 modelField = Get3DVectorParameterWithUnits("modelField", magVolumeDef);
+        if (modelField == TVector3(-1, -1, -1)) modelField = TVector3(0, 0, 0);
+        fModelFields.push_back(modelField);
+
+        Double_t modelLength = GetDblParameterWithUnits("modelLength", magVolumeDef, 0.);
+        fModelLengths.push_back(modelLength);
+
+        Double_t modelFringe = GetDblParameterWithUnits("modelFringe", magVolumeDef, 0.);
+        fModelFringes.push_back(modelFringe);
+
+        Double_t modelRadius = GetDblParameterWithUnits("modelRadius", magVolumeDef, 0.);
+        fModelRadii.push_back(modelRadius);
+
+        TString modelNormal = GetParameter("modelNormal", magVolumeDef, "");
+        fModelNormal.push_back(modelNormal);
+
+        TString modelSkew = GetParameter("modelSkew", magVolumeDef, "");
+        fModelSkew.push_back(modelSkew);
+
         debug << "Reading new magnetic volume" << endl;
         debug << "-----" << endl;
         debug << "Filename : " << filename << endl;
@@ -1267,11 +2572,36 @@ void TRestAxionMagneticField::InitFromConfigFile() {
               << endl;
         debug << "Gas mixture : " << gasMixture << endl;
         debug << "Gas density : " << gasDensity << endl;
+        debug << "Symmetry : " << symmetry << endl;
+        debug << "Grid type : " << gridType << endl;
+        debug << "Precision : " << precision << endl;
+        debug << "Layout : " << layout << endl;
+        debug << "Adaptive tolerance : " << adaptiveTolerance << " T" << endl;
+        debug << "Interpolation : " << interpolation << endl;
+        if (multipoleOrder > 0)
+            debug << "Multipole order : " << multipoleOrder << ", radius : " << multipoleRadius
+                  << " mm, tolerance : " << multipoleTolerance << " T" << endl;
+        debug << "Tile cache size : " << cacheSize << " MB" << endl;
+        debug << "Field model : " << model << endl;
+        if (model != "none") {
+            debug << "Model field: ( " << modelField.X() << ", " << modelField.Y() << ", " << modelField.Z()
+                  << ") T" << endl;
+            debug << "Model length : " << modelLength << " mm, fringe : " << modelFringe
+                  << " mm, radius : " << modelRadius << " mm" << endl;
+            debug << "Model coefficients. Normal : " << modelNormal << " Skew : " << modelSkew << endl;
+        }
         debug << "----" << endl;
 
         magVolumeDef = GetNextElement(magVolumeDef);
     }
 
+    fDirectionTableSpacing = GetDblParameterWithUnits("directionTableSpacing", 0.);
+    fDirectionTableAxis = StringTo3DVector(GetParameter("directionTableAxis", "(0,0,0)"));
+    fDirectionTableMaxSize = StringToDouble(GetParameter("directionTableMaxSize", "512"));
+    fUseAxialSums = StringToBool(GetParameter("axialSums", "false"));
+    fAxialTolerance = StringToDouble(GetParameter("axialTolerance", "0.01"));
+    fLoadThreads = StringToInteger(GetParameter("loadThreads", "0"));
+
     LoadMagneticVolumes();
 
     // TODO we should check that the volumes do not overlap
@@ -1284,6 +2614,14 @@ void TRestAxionMagneticField::PrintMetadata() {
     TRestMetadata::PrintMetadata();
 
     metadata << " - Number of magnetic volumes : " << GetNumberOfVolumes() << endl;
+    if (fDirectionTableSpacing > 0 && fDirectionTableAxis.Mag2() > 0) {
+        metadata << " - Direction table axis : (" << fDirectionTableAxis.X() << ", "
+                 << fDirectionTableAxis.Y() << ", " << fDirectionTableAxis.Z() << ")" << endl;
+        metadata << " - Direction table spacing : " << fDirectionTableSpacing << " mm, max. size : "
+                 << fDirectionTableMaxSize << " MB" << endl;
+    }
+    if (fUseAxialSums) metadata << " - Axial sums : enabled, tolerance : " << fAxialTolerance << endl;
+    if (fLoadThreads > 0) metadata << " - Loading threads : " << fLoadThreads << endl;
     metadata << " ------------------------------------------------ " << endl;
     for (int p = 0; p < GetNumberOfVolumes(); p++) {
         if (p > 0) metadata << " ------------------------------------------------ " << endl;
@@ -1314,6 +2652,43 @@ void TRestAxionMagneticField::PrintMetadata() {
         metadata << "  - File loaded : " << fFileNames[p] << endl;
         metadata << "  - Buffer gas mixture : " << fGasMixtures[p] << endl;
         metadata << "  - Buffer gas densities : " << fGasDensities[p] << endl;
+        if (p < fSymmetries.size() && fSymmetries[p] != "")
+            metadata << "  - Symmetry : " << fSymmetries[p] << endl;
+        if (p < fGridTypes.size()) metadata << "  - Grid type : " << fGridTypes[p] << endl;
+        if (p < fPrecisions.size()) metadata << "  - Precision : " << fPrecisions[p] << endl;
+        if (p < fLayouts.size()) metadata << "  - Layout : " << fLayouts[p] << endl;
+        if (p < fMagneticFieldVolumes.size() && fMagneticFieldVolumes[p].field.IsAdaptive())
+            metadata << "  - Adaptive resolution. Max. error : "
+                     << fMagneticFieldVolumes[p].field.GetBricks()->GetMaxError() << " T, size : "
+                     << fMagneticFieldVolumes[p].field.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+        if (p < fInterpolations.size()) metadata << "  - Interpolation : " << fInterpolations[p] << endl;
+        if (p < fMagneticFieldVolumes.size() && fMagneticFieldVolumes[p].field.HasMultipoles()) {
+            const FieldMultipoles* multipoles = fMagneticFieldVolumes[p].field.GetMultipoles();
+            metadata << "  - Multipole expansion. Order : " << multipoles->order
+                     << ", radius : " << multipoles->radius << " mm" << endl;
+            metadata << "    Max. residual : " << multipoles->residual << " T" << endl;
+        }
+        if (p < fModels.size() && fModels[p] != "none") {
+            metadata << "  - Field model : " << fModels[p] << endl;
+            if (fModels[p] != "multipole")
+                metadata << "    Field : (" << fModelFields[p].X() << ", " << fModelFields[p].Y() << ", "
+                         << fModelFields[p].Z() << ") T" << endl;
+            else
+                metadata << "    Coefficients. Normal : " << fModelNormal[p] << " Skew : " << fModelSkew[p]
+                         << " T" << endl;
+            metadata << "    Length : " << fModelLengths[p] << " mm, fringe : " << fModelFringes[p]
+                     << " mm, radius : " << fModelRadii[p] << " mm" << endl;
+        }
+        if (p < fMagneticFieldVolumes.size() && fMagneticFieldVolumes[p].field.IsTiled())
+            metadata << "  - Tile cache size : " << fCacheSizes[p] << " MB" << endl;
+        if (p < fMagneticFieldVolumes.size() && fMagneticFieldVolumes[p].field.GetQuantizationError() > 0)
+            metadata << "  - Max. quantization error : "
+                     << fMagneticFieldVolumes[p].field.GetQuantizationError() << " T" << endl;
+        if (p < fLoadTimes.size() && fFileNames[p] != "none") {
+            const FieldLoadTimes& times = fLoadTimes[p];
+            metadata << "  - Loading time. Read : " << times.read << " ms, scan : " << times.scan
+                     << " ms, fill : " << times.fill << " ms, build : " << times.build << " ms" << endl;
+        }
         metadata << " " << endl;
         metadata << "  - Bounds : " << endl;
         metadata << "    xmin : " << xMin << " mm , xmax : " << xMax << " mm" << endl;
@@ -0,0 +1,258 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// TRestAxionVolumeIndex is a bounding volume hierarchy (BVH) built over the
+/// axis-aligned bounding boxes of the magnetic volumes defined at
+/// TRestAxionMagneticField.
+///
+/// The hierarchy is a binary tree. Each node stores the box enclosing all the
+/// volumes below it, and the volumes are split in two halves along the
+/// longest axis of the distribution of box centers. Leaf nodes contain at
+/// most TRestAxionVolumeIndex::kLeafSize volumes.
+///
+/// The index serves three kind of queries.
+///
+/// - TRestAxionVolumeIndex::GetVolumesAt returns the volumes whose bounding
+/// box contains a given position. The cost grows as log(N) with the number
+/// of volumes N.
+///
+/// - TRestAxionVolumeIndex::GetFirstVolumeAt returns the lowest id of the
+/// volumes whose bounding box contains a given position and that pass a
+/// check given by the caller, without allocating memory. It is used for
+/// the single point queries, e.g. TRestAxionMagneticField::GetVolumeIndex.
+///
+/// - TRestAxionVolumeIndex::GetVolumesAlongRay returns the volumes whose
+/// bounding box is crossed by the half-line starting at a position and
+/// moving along a given direction.
+///
+/// The ids returned by GetVolumesAt and GetVolumesAlongRay are ordered by
+/// increasing value. The bounding box is only a first filter, the caller
+/// must still validate the candidates against the real volume shape (e.g.
+/// a cylinder).
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the volume index used by
+///               TRestAxionMagneticField::GetVolumeIndex.
+///               Javier Galan
+///
+/// \class      TRestAxionVolumeIndex
+/// \author     Javier Galan
+///
+/// <hr>
+///
+
+#include "TRestAxionVolumeIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+/// A small margin, in mm, added to the bounding boxes so that points at the surface are never missed
+const Double_t kBoxMargin = 1.e-6;
+}  // namespace
+
+///////////////////////////////////////////////
+/// \brief It builds the hierarchy using the lower and upper vertex of the bounding box of each volume.
+///
+/// The position of each box inside the vectors defines the volume id that will be returned by the queries.
+///
+void TRestAxionVolumeIndex::Build(const std::vector<TVector3>& boxMin, const std::vector<TVector3>& boxMax) {
+    Clear();
+
+    for (unsigned int n = 0; n < boxMin.size() && n < boxMax.size(); n++) {
+        Box box;
+        for (int k = 0; k < 3; k++) {
+            box.min[k] = boxMin[n][k] - kBoxMargin;
+            box.max[k] = boxMax[n][k] + kBoxMargin;
+        }
+        fBoxes.push_back(box);
+        fIds.push_back(n);
+    }
+
+    if (fIds.empty()) return;
+
+    fNodes.reserve(2 * fIds.size());
+    fNodes.resize(1);
+    BuildNode(0, 0, fIds.size());
+}
+
+///////////////////////////////////////////////
+/// \brief It removes all the volumes from the index
+///
+void TRestAxionVolumeIndex::Clear() {
+    fNodes.clear();
+    fIds.clear();
+    fBoxes.clear();
+}
+
+///////////////////////////////////////////////
+/// \brief It defines the node `nodeId` containing the `count` volumes starting at position `first` in
+/// fIds, and it creates recursively its children.
+///
+void TRestAxionVolumeIndex::BuildNode(Int_t nodeId, Int_t first, Int_t count) {
+    Node node;
+    Double_t cMin[3], cMax[3];
+    for (int k = 0; k < 3; k++) {
+        node.box.min[k] = cMin[k] = HUGE_VAL;
+        node.box.max[k] = cMax[k] = -HUGE_VAL;
+    }
+
+    for (Int_t n = first; n < first + count; n++) {
+        const Box& box = fBoxes[fIds[n]];
+        for (int k = 0; k < 3; k++) {
+            node.box.min[k] = min(node.box.min[k], box.min[k]);
+            node.box.max[k] = max(node.box.max[k], box.max[k]);
+
+            Double_t center = 0.5 * (box.min[k] + box.max[k]);
+            cMin[k] = min(cMin[k], center);
+            cMax[k] = max(cMax[k], center);
+        }
+    }
+
+    if (count <= kLeafSize) {
+        node.first = first;
+        node.count = count;
+        fNodes[nodeId] = node;
+        return;
+    }
+
+    // We split the volumes by the median along the axis where the box centers are more spread
+    Int_t axis = 0;
+    for (int k = 1; k < 3; k++)
+        if (cMax[k] - cMin[k] > cMax[axis] - cMin[axis]) axis = k;
+
+    Int_t half = count / 2;
+    nth_element(fIds.begin() + first, fIds.begin() + first + half, fIds.begin() + first + count,
+                [this, axis](Int_t a, Int_t b) {
+                    return fBoxes[a].min[axis] + fBoxes[a].max[axis] <
+                           fBoxes[b].min[axis] + fBoxes[b].max[axis];
+                });
+
+    Int_t child = fNodes.size();
+    fNodes.resize(child + 2);
+
+    node.first = child;
+    node.count = 0;
+    fNodes[nodeId] = node;
+
+    BuildNode(child, first, half);
+    BuildNode(child + 1, first + half, count - half);
+}
+
+///////////////////////////////////////////////
+/// \brief It returns true if `pos` is inside the given `box`
+///
+Bool_t TRestAxionVolumeIndex::IsInsideBox(const Box& box, const TVector3& pos) const {
+    for (int k = 0; k < 3; k++)
+        if (pos[k] < box.min[k] || pos[k] > box.max[k]) return false;
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns true if the half-line starting at `pos` with direction `dir` crosses the given `box`
+///
+Bool_t TRestAxionVolumeIndex::IsCrossingBox(const Box& box, const TVector3& pos, const TVector3& dir) const {
+    Double_t tIn = 0;
+    Double_t tOut = HUGE_VAL;
+    for (int k = 0; k < 3; k++) {
+        if (dir[k] == 0) {
+            if (pos[k] < box.min[k] || pos[k] > box.max[k]) return false;
+            continue;
+        }
+
+        Double_t t1 = (box.min[k] - pos[k]) / dir[k];
+        Double_t t2 = (box.max[k] - pos[k]) / dir[k];
+        if (t1 > t2) swap(t1, t2);
+
+        tIn = max(tIn, t1);
+        tOut = min(tOut, t2);
+        if (tIn > tOut) return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the ids of the volumes whose bounding box contains the position `pos`
+///
+std::vector<Int_t> TRestAxionVolumeIndex::GetVolumesAt(const TVector3& pos) const {
+    std::vector<Int_t> ids;
+    if (fNodes.empty()) return ids;
+
+    Int_t stack[64];
+    Int_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = fNodes[stack[--top]];
+        if (!IsInsideBox(node.box, pos)) continue;
+
+        if (node.count == 0) {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+            continue;
+        }
+
+        for (Int_t n = node.first; n < node.first + node.count; n++) {
+            if (IsInsideBox(fBoxes[fIds[n]], pos)) ids.push_back(fIds[n]);
+        }
+    }
+
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+///////////////////////////////////////////////
+/// \brief It returns the ids of the volumes whose bounding box is crossed by the half-line starting at
+/// position `pos` with direction `dir`.
+///
+std::vector<Int_t> TRestAxionVolumeIndex::GetVolumesAlongRay(const TVector3& pos, const TVector3& dir) const {
+    std::vector<Int_t> ids;
+    if (fNodes.empty()) return ids;
+
+    Int_t stack[64];
+    Int_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = fNodes[stack[--top]];
+        if (!IsCrossingBox(node.box, pos, dir)) continue;
+
+        if (node.count == 0) {
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+            continue;
+        }
+
+        for (Int_t n = node.first; n < node.first + node.count; n++) {
+            if (IsCrossingBox(fBoxes[fIds[n]], pos, dir)) ids.push_back(fIds[n]);
+        }
+    }
+
+    sort(ids.begin(), ids.end());
+    return ids;
+}
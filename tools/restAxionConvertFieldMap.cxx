@@ -0,0 +1,352 @@
+/******************** REST disclaimer ***********************************
+ * This file is part of the REST software framework.                     *
+ *                                                                       *
+ * Copyright (C) 2016 GIFNA/TREX (University of Zaragoza)                *
+ * For more information see http://gifna.unizar.es/trex                  *
+ *                                                                       *
+ * REST is free software: you can redistribute it and/or modify          *
+ * it under the terms of the GNU General Public License as published by  *
+ * the Free Software Foundation, either version 3 of the License, or     *
+ * (at your option) any later version.                                   *
+ *                                                                       *
+ * REST is distributed in the hope that it will be useful,               *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the          *
+ * GNU General Public License for more details.                          *
+ *                                                                       *
+ * You should have a copy of the GNU General Public License along with   *
+ * REST in $REST_PATH/LICENSE.                                           *
+ * If not, see http://www.gnu.org/licenses/.                             *
+ * For the list of contributors see $REST_PATH/CREDITS.                  *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+/// restAxionConvertFieldMap converts a magnetic field map given in one of the
+/// table formats accepted by TRestAxionMagneticField (plain-text `.dat` or
+/// 6-column binary `.bin`) into the native grid format (`.grid`) described
+/// at TRestAxionFieldGrid.
+///
+/// \code
+///    restAxionConvertFieldMap Bykovskiy_201906.dat [Bykovskiy_201906.grid] [symmetry] [precision]
+/// \endcode
+///
+/// If no output filename is given, the input extension is replaced by `.grid`.
+/// If the output filename ends with `.tgrid`, the grid is written as a tiled
+/// file, with TRestAxionFieldGrid::kDefaultTileCells cells along each axis of
+/// a tile.
+///
+/// The optional `symmetry` follows the definition of the `symmetry` parameter
+/// at TRestAxionMagneticField, e.g. `xz`. Only the half of the map with
+/// positive coordinates along each symmetric axis is written to the grid
+/// file. The table may contain the full map, or only the positive half. An
+/// empty string, `""`, can be given if no symmetry is required.
+///
+/// The optional `precision` defines the numerical type of the stored field
+/// components, `double` (default), `float` or `int16`, as described at
+/// TRestAxionFieldGrid. The maximum quantization error is reported.
+///
+/// The plain-text tables are read by TRestAxionFieldTable, using all the
+/// hardware threads.
+///
+/// The table is validated before writing the grid file.
+///
+/// - The coordinates along each axis must define a regular grid, i.e. they
+/// must be placed at multiples of the node spacing from the first one. The
+/// spacing is the median distance between consecutive coordinates, and the
+/// planes of nodes missing at the table are reported.
+/// - A node defined more than once with different field values is an error.
+/// Repeated rows with identical values are ignored.
+/// - Nodes that are not defined in the table are reported, and their field
+/// will be zero.
+///
+/// The grid is written in the reference system of the table. The field map
+/// is expected to be centered at zero, since the position of the volume will
+/// be added by TRestAxionMagneticField, and a warning is shown otherwise.
+///
+/// The program returns 0 if the grid file was written, and 1 otherwise.
+///
+///--------------------------------------------------------------------------
+///
+/// RESTsoft - Software for Rare Event Searches with TPCs
+///
+/// History of developments:
+///
+/// 2026-October: First implementation of the field map converter.
+///               Javier Galan
+///
+/// 2026-October: Optional symmetry of the output grid.
+///               Javier Galan
+///
+/// 2026-October: Optional storage precision of the output grid.
+///               Javier Galan
+///
+/// 2026-October: Tiled output files (.tgrid).
+///               Javier Galan
+///
+/// 2026-October: Parallel reading of the plain-text tables.
+///               Javier Galan
+///
+/// <hr>
+///
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TRestAxionFieldGrid.h"
+#include "TRestAxionFieldTable.h"
+#include "TRestTools.h"
+
+using namespace std;
+
+namespace {
+/// The relative tolerance, with respect to the node spacing, used to compare coordinates
+const Double_t kTolerance = 1.e-3;
+
+/// The rounding error of the coordinates written at the table, relative to the largest coordinate
+const Double_t kJitter = 1.e-5;
+
+/// It returns true if `name` finishes with `ending`
+Bool_t EndsWith(const string& name, const string& ending) {
+    if (name.size() < ending.size()) return false;
+    return name.compare(name.size() - ending.size(), ending.size(), ending) == 0;
+}
+
+/// It finds the node coordinates along the `axis` column of the table. It returns false if the
+/// coordinates do not define a regular grid.
+///
+/// The differences between consecutive coordinates below kJitter times the largest coordinate are rounding
+/// errors of the table, and the median of the other differences estimates the node spacing. The
+/// coordinates closer than half the estimated spacing belong to the same node, placed at their average.
+/// The node spacing is then the median of the differences between consecutive nodes, so that the planes
+/// of nodes missing at the table are counted and reported, instead of breaking the regular grid.
+Bool_t GetAxisNodes(const TRestAxionFieldTable& data, Int_t axis, Double_t& first, Double_t& spacing,
+                    Int_t& nodes) {
+    std::vector<Double_t> values;
+    values.reserve(data.GetNumberOfRows());
+    for (size_t n = 0; n < data.GetNumberOfRows(); n++) values.push_back(data[n][axis]);
+    sort(values.begin(), values.end());
+
+    Double_t jitter = kJitter * max(fabs(values.front()), fabs(values.back()));
+    std::vector<Double_t> increases;
+    for (unsigned int n = 1; n < values.size(); n++)
+        if (values[n] - values[n - 1] > jitter) increases.push_back(values[n] - values[n - 1]);
+
+    Double_t estimation = 0;
+    if (!increases.empty()) {
+        nth_element(increases.begin(), increases.begin() + increases.size() / 2, increases.end());
+        estimation = increases[increases.size() / 2];
+    }
+
+    std::vector<Double_t> unique;
+    Double_t sum = 0;
+    size_t count = 0;
+    for (unsigned int n = 0; n < values.size(); n++) {
+        if (count > 0 && values[n] - values[n - 1] > max(0.5 * estimation, jitter)) {
+            unique.push_back(sum / count);
+            sum = 0;
+            count = 0;
+        }
+        sum += values[n];
+        count++;
+    }
+    unique.push_back(sum / count);
+
+    first = unique.front();
+    nodes = 1;
+    spacing = 0;
+    if (unique.size() < 2) return true;
+
+    std::vector<Double_t> steps;
+    for (unsigned int n = 1; n < unique.size(); n++) steps.push_back(unique[n] - unique[n - 1]);
+    nth_element(steps.begin(), steps.begin() + steps.size() / 2, steps.end());
+    Double_t step = steps[steps.size() / 2];
+
+    nodes = (Int_t)round((unique.back() - first) / step) + 1;
+    spacing = (unique.back() - first) / (nodes - 1);
+
+    Int_t missing = 0;
+    for (unsigned int n = 0; n < unique.size(); n++) {
+        Double_t position = (unique[n] - first) / spacing;
+        if (fabs(position - round(position)) > kTolerance) {
+            cout << "Axis " << axis << " : the coordinate " << unique[n] << " is not in a regular grid!"
+                 << endl;
+            cout << "Spacing : " << spacing << " mm" << endl;
+            return false;
+        }
+
+        // The nodes skipped since the previous coordinate are missing at the table
+        Int_t index = (Int_t)round(position);
+        Int_t previous = n > 0 ? (Int_t)round((unique[n - 1] - first) / spacing) : -1;
+        for (Int_t m = previous + 1; m < index; m++) {
+            cout << "Axis " << axis << " : missing plane of nodes at " << first + m * spacing << endl;
+            missing++;
+        }
+    }
+    if (missing > 0) cout << "Axis " << axis << " : " << missing << " missing planes of nodes" << endl;
+    return true;
+}
+
+/// It translates the symmetry definition, e.g. "xYz", to the symmetry flags of TRestAxionFieldGrid
+UInt_t GetSymmetryFlags(const string& symmetry) {
+    UInt_t flags = 0;
+    for (unsigned int n = 0; n < symmetry.size(); n++) {
+        size_t axis = string("xyz").find(tolower(symmetry[n]));
+        if (axis == string::npos) continue;
+        flags |= TRestAxionFieldGrid::kMirrorX << axis;
+        if (isupper(symmetry[n])) flags |= TRestAxionFieldGrid::kTangentialX << axis;
+    }
+    return flags;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "Usage : restAxionConvertFieldMap input.[dat|bin] [output.grid] [symmetry] [precision]"
+             << endl;
+        return 1;
+    }
+
+    string input = argv[1];
+    string output = argc > 2 ? argv[2] : input.substr(0, input.rfind('.')) + ".grid";
+    UInt_t symmetry = argc > 3 ? GetSymmetryFlags(argv[3]) : 0;
+
+    string precisionName = argc > 4 ? argv[4] : "double";
+    UInt_t precision = TRestAxionFieldGrid::kDoublePrecision;
+    if (precisionName == "float") {
+        precision = TRestAxionFieldGrid::kFloatPrecision;
+    } else if (precisionName == "int16") {
+        precision = TRestAxionFieldGrid::kInt16Precision;
+    } else if (precisionName != "double") {
+        cout << "Precision not recognized : " << precisionName << endl;
+        cout << "Valid options are : double, float, int16" << endl;
+        return 1;
+    }
+
+    TRestAxionFieldTable data;
+    if (EndsWith(input, ".dat")) {
+        if (!data.ReadASCII(input, max((Int_t)thread::hardware_concurrency(), 1))) {
+            cout << "Problem reading file : " << input << endl;
+            return 1;
+        }
+    } else if (EndsWith(input, ".bin")) {
+        std::vector<std::vector<Float_t>> binaryData;
+        if (!TRestTools::ReadBinaryTable(input, binaryData, 6)) {
+            cout << "Problem reading file : " << input << endl;
+            return 1;
+        }
+        data.SetRows(binaryData);
+    } else {
+        cout << "File format not recognized : " << input << endl;
+        return 1;
+    }
+
+    if (data.GetNumberOfRows() < 2) {
+        cout << "Problem reading file : " << input << endl;
+        cout << "The table must contain at least 2 rows with 6 columns : x, y, z, Bx, By, Bz" << endl;
+        return 1;
+    }
+
+    Double_t first[3], spacing[3];
+    Int_t nodes[3];
+    for (int k = 0; k < 3; k++) {
+        if (!GetAxisNodes(data, k, first[k], spacing[k], nodes[k])) return 1;
+
+        // If only the positive half is given along a symmetric axis, the negative half is left empty
+        Bool_t mirrored = symmetry & (TRestAxionFieldGrid::kMirrorX << k);
+        if (mirrored && nodes[k] > 1 && fabs(first[k]) < kTolerance * spacing[k]) {
+            first[k] = -(nodes[k] - 1) * spacing[k];
+            nodes[k] = 2 * nodes[k] - 1;
+        }
+    }
+
+    cout << "Input file : " << input << endl;
+    cout << "Rows : " << data.GetNumberOfRows() << endl;
+    cout << "Nodes : (" << nodes[0] << ", " << nodes[1] << ", " << nodes[2] << ")" << endl;
+    cout << "First node : (" << first[0] << ", " << first[1] << ", " << first[2] << ") mm" << endl;
+    cout << "Spacing : (" << spacing[0] << ", " << spacing[1] << ", " << spacing[2] << ") mm" << endl;
+
+    for (int k = 0; k < 3; k++) {
+        Double_t last = first[k] + (nodes[k] - 1) * spacing[k];
+        if (fabs(first[k] + last) > kTolerance * max(spacing[k], 1.)) {
+            cout << "WARNING : the field map is not centered at zero along axis " << k << endl;
+            cout << "TRestAxionMagneticField expects the map boundaries to be (-xMax,xMax)" << endl;
+        }
+    }
+
+    TRestAxionFieldGrid grid;
+    grid.Allocate(nodes[0], nodes[1], nodes[2], TVector3(first[0], first[1], first[2]),
+                  TVector3(spacing[0], spacing[1], spacing[2]));
+
+    std::vector<bool> defined(grid.GetNumberOfNodes(), false);
+    size_t duplicated = 0, conflicts = 0;
+    for (size_t n = 0; n < data.GetNumberOfRows(); n++) {
+        Int_t i[3];
+        for (int k = 0; k < 3; k++)
+            i[k] = nodes[k] > 1 ? (Int_t)round((data[n][k] - first[k]) / spacing[k]) : 0;
+
+        size_t id = grid.GetIndex(i[0], i[1], i[2]) / TRestAxionFieldGrid::kComponents;
+        if (defined[id]) {
+            TVector3 b = grid.GetNodeField(i[0], i[1], i[2]);
+            if (b != TVector3(data[n][3], data[n][4], data[n][5])) {
+                cout << "Node (" << i[0] << ", " << i[1] << ", " << i[2]
+                     << ") defined twice with different values" << endl;
+                cout << "x : " << data[n][0] << " y : " << data[n][1] << " z : " << data[n][2] << endl;
+                conflicts++;
+            }
+            duplicated++;
+            continue;
+        }
+
+        grid.SetNode(i[0], i[1], i[2], data[n][3], data[n][4], data[n][5]);
+        defined[id] = true;
+    }
+
+    // Only the nodes that are kept after applying the symmetry are required
+    size_t missing = 0;
+    for (Int_t i = 0; i < nodes[0]; i++)
+        for (Int_t j = 0; j < nodes[1]; j++)
+            for (Int_t k = 0; k < nodes[2]; k++) {
+                Int_t node[3] = {i, j, k};
+                Bool_t required = true;
+                for (int a = 0; a < 3; a++)
+                    if (symmetry & (TRestAxionFieldGrid::kMirrorX << a) && node[a] < nodes[a] / 2)
+                        required = false;
+
+                size_t id = grid.GetIndex(i, j, k) / TRestAxionFieldGrid::kComponents;
+                if (required && !defined[id]) missing++;
+            }
+    cout << "Duplicated nodes : " << duplicated << endl;
+    cout << "Missing nodes : " << missing << endl;
+
+    if (conflicts > 0) {
+        cout << "ERROR : " << conflicts << " nodes were defined with different field values!" << endl;
+        return 1;
+    }
+    if (missing > 0) cout << "WARNING : the field at the missing nodes will be zero" << endl;
+
+    if (symmetry != 0 && !grid.SetSymmetry(symmetry)) {
+        cout << "ERROR : the symmetry cannot be applied" << endl;
+        cout << "There is no node at zero along a symmetric axis" << endl;
+        return 1;
+    }
+
+    grid.SetPrecision(precision);
+    if (precision != TRestAxionFieldGrid::kDoublePrecision) {
+        cout << "Precision : " << precisionName << endl;
+        cout << "Max. quantization error : " << grid.GetQuantizationError() << " T" << endl;
+    }
+
+    Bool_t tiled = output.size() > 6 && output.substr(output.size() - 6) == ".tgrid";
+    Int_t tileCells = tiled ? TRestAxionFieldGrid::kDefaultTileCells : 0;
+    if (!grid.WriteFile(output, TVector3(0, 0, 0), tileCells)) return 1;
+
+    cout << "Output file : " << output << endl;
+    cout << "Size : " << grid.GetMemorySize() / 1024. / 1024. << " MB" << endl;
+
+    return 0;
+}